@@ -0,0 +1,286 @@
+/**
+   \class benchmarkClassicSVfit benchmarkClassicSVfit.cc "TauAnalysis/ClassicSVfit/bin/benchmarkClassicSVfit.cc"
+   \brief Benchmark of the computing time and of the physics results of ClassicSVfit on a fixed, versioned corpus of events
+          covering the e+tau_h, mu+tau_h, tau_h+tau_h and e+mu channels, lepton-flavor-violating H decays and mass-constrained fits.
+
+   Usage: benchmarkClassicSVfit [corpus file] [number of repetitions] [output file]
+
+   Each event of the corpus is processed once to compare mass and massErr with the reference values stored in the corpus,
+   then the whole corpus is processed again the given number of times to measure events per second, computing time per integrand call,
+   integrand calls per event and heap allocations per event. If an output file is given, a copy of the corpus with the reference values
+   replaced by the values computed by the current version of the code is written to it.
+   The return value is nonzero if mass or massErr of any event deviates from its reference value by more than 0.1%.
+*/
+
+#include "TauAnalysis/ClassicSVfit/interface/ClassicSVfit.h"
+#include "TauAnalysis/ClassicSVfit/interface/MeasuredTauLepton.h"
+
+#include <TMatrixD.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace classic_svFit;
+
+namespace
+{
+  std::atomic<unsigned long> numAllocations(0);
+
+  void* allocate(std::size_t size)
+  {
+    ++numAllocations;
+    void* ptr = std::malloc(( size > 0 ) ? size : 1);
+    if ( !ptr ) throw std::bad_alloc();
+    return ptr;
+  }
+
+  const int corpusVersion = 1;
+  const double maxRelDeviation = 1.e-3;
+}
+
+// CV: count all heap allocations made via operator new
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+struct BenchmarkEvent
+{
+  BenchmarkEvent()
+    : measuredMETx_(0.)
+    , measuredMETy_(0.)
+    , covMET_(2, 2)
+    , addLogM_power_(0.)
+    , diTauMassConstraint_(-1.)
+    , refMass_(0.)
+    , refMassErr_(0.)
+  {}
+  std::string name_;
+  std::string channel_;
+  std::vector<MeasuredTauLepton> measuredTauLeptons_;
+  double measuredMETx_;
+  double measuredMETy_;
+  TMatrixD covMET_;
+  double addLogM_power_;
+  double diTauMassConstraint_;
+  double refMass_;
+  double refMassErr_;
+  std::string line_; // CV: text of the line preceding the reference values, kept for writing the updated corpus
+};
+
+struct BenchmarkTimings
+{
+  BenchmarkTimings()
+    : numEvents_(0)
+    , numIntegrandCalls_(0)
+    , numAllocations_(0)
+    , numSeconds_real_(0.)
+  {}
+  void add(const BenchmarkTimings& timings)
+  {
+    numEvents_ += timings.numEvents_;
+    numIntegrandCalls_ += timings.numIntegrandCalls_;
+    numAllocations_ += timings.numAllocations_;
+    numSeconds_real_ += timings.numSeconds_real_;
+  }
+  unsigned long numEvents_;
+  unsigned long numIntegrandCalls_;
+  unsigned long numAllocations_;
+  double numSeconds_real_;
+};
+
+bool parseLeptonType(const std::string& type, int& leptonType)
+{
+  if      ( type == "e"      ) leptonType = MeasuredTauLepton::kTauToElecDecay;
+  else if ( type == "mu"     ) leptonType = MeasuredTauLepton::kTauToMuDecay;
+  else if ( type == "had"    ) leptonType = MeasuredTauLepton::kTauToHadDecay;
+  else if ( type == "prompt" ) leptonType = MeasuredTauLepton::kPrompt;
+  else return false;
+  return true;
+}
+
+bool readCorpus(const std::string& fileName, std::vector<std::string>& header, std::vector<BenchmarkEvent>& events)
+{
+  std::ifstream file(fileName.data());
+  if ( !file ) {
+    std::cerr << "Failed to open corpus file = " << fileName << " !!" << std::endl;
+    return false;
+  }
+  bool hasVersion = false;
+  std::string line;
+  while ( std::getline(file, line) ) {
+    std::istringstream stream(line);
+    std::string name;
+    if ( !(stream >> name) || name[0] == '#' ) {
+      if ( events.empty() ) header.push_back(line);
+      continue;
+    }
+    if ( name == "version" ) {
+      int version = 0;
+      stream >> version;
+      if ( version != corpusVersion ) {
+        std::cerr << "Corpus file = " << fileName << " has version " << version << ", expected version " << corpusVersion << " !!" << std::endl;
+        return false;
+      }
+      header.push_back(line);
+      hasVersion = true;
+      continue;
+    }
+    BenchmarkEvent event;
+    event.name_ = name;
+    for ( int idxLepton = 0; idxLepton < 2; ++idxLepton ) {
+      std::string type;
+      double pt, eta, phi, mass;
+      int decayMode, leptonType;
+      if ( !(stream >> type >> pt >> eta >> phi >> mass >> decayMode) || !parseLeptonType(type, leptonType) ) {
+        std::cerr << "Failed to parse lepton #" << idxLepton << " of event = " << name << " !!" << std::endl;
+        return false;
+      }
+      event.channel_ += ( idxLepton > 0 ) ? "_" + type : type;
+      event.measuredTauLeptons_.push_back(MeasuredTauLepton(leptonType, pt, eta, phi, mass, decayMode));
+    }
+    double covXX, covXY, covYY;
+    if ( !(stream >> event.measuredMETx_ >> event.measuredMETy_ >> covXX >> covXY >> covYY >> event.addLogM_power_ >> event.diTauMassConstraint_) ) {
+      std::cerr << "Failed to parse MET or settings of event = " << name << " !!" << std::endl;
+      return false;
+    }
+    event.covMET_[0][0] = covXX;
+    event.covMET_[0][1] = covXY;
+    event.covMET_[1][0] = covXY;
+    event.covMET_[1][1] = covYY;
+    std::streampos refPos = stream.tellg();
+    if ( !(stream >> event.refMass_ >> event.refMassErr_) ) {
+      std::cerr << "Failed to parse reference values of event = " << name << " !!" << std::endl;
+      return false;
+    }
+    event.line_ = line.substr(0, refPos);
+    events.push_back(event);
+  }
+  if ( !hasVersion ) {
+    std::cerr << "Corpus file = " << fileName << " has no version !!" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+SVfitResult runSVfit(ClassicSVfit& svFitAlgo, const BenchmarkEvent& event)
+{
+  svFitAlgo.addLogM_fixed(true, event.addLogM_power_);
+  svFitAlgo.setDiTauMassConstraint(event.diTauMassConstraint_);
+  return svFitAlgo.integrate(event.measuredTauLeptons_, event.measuredMETx_, event.measuredMETy_, event.covMET_);
+}
+
+void printTimings(const std::string& label, const BenchmarkTimings& timings)
+{
+  double numEvents = ( timings.numEvents_ > 0 ) ? timings.numEvents_ : 1.;
+  double numIntegrandCalls = ( timings.numIntegrandCalls_ > 0 ) ? timings.numIntegrandCalls_ : 1.;
+  double numSeconds = ( timings.numSeconds_real_ > 0. ) ? timings.numSeconds_real_ : 1.e-9;
+  std::cout << std::left << std::setw(16) << label << std::right
+            << std::setw(12) << std::setprecision(4) << timings.numEvents_/numSeconds
+            << std::setw(14) << std::setprecision(4) << 1.e+9*timings.numSeconds_real_/numIntegrandCalls
+            << std::setw(14) << std::setprecision(6) << timings.numIntegrandCalls_/numEvents
+            << std::setw(14) << std::setprecision(4) << timings.numAllocations_/numEvents << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+  std::string corpusFileName = ( argc > 1 ) ? argv[1] : "TauAnalysis/ClassicSVfit/data/benchmarkCorpus_v1.txt";
+  int numRepetitions = ( argc > 2 ) ? std::atoi(argv[2]) : 3;
+  std::string outputFileName = ( argc > 3 ) ? argv[3] : "";
+
+  std::vector<std::string> header;
+  std::vector<BenchmarkEvent> events;
+  if ( !readCorpus(corpusFileName, header, events) ) return 1;
+  std::cout << "read " << events.size() << " events from corpus file = " << corpusFileName << " (version " << corpusVersion << ")" << std::endl;
+
+  int verbosity = 0;
+  ClassicSVfit svFitAlgo(verbosity);
+
+  // CV: compare physics results to reference values
+  bool isDeviation = false;
+  std::vector<SVfitResult> results;
+  std::cout << std::endl;
+  std::cout << std::left << std::setw(16) << "event" << std::right
+            << std::setw(12) << "mass" << std::setw(12) << "ref." << std::setw(10) << "dev."
+            << std::setw(12) << "massErr" << std::setw(12) << "ref." << std::setw(10) << "dev." << std::endl;
+  for ( std::vector<BenchmarkEvent>::const_iterator event = events.begin(); event != events.end(); ++event ) {
+    SVfitResult result = runSVfit(svFitAlgo, *event);
+    results.push_back(result);
+    std::cout << std::left << std::setw(16) << event->name_ << std::right << std::setprecision(6)
+              << std::setw(12) << result.mass_ << std::setw(12) << event->refMass_;
+    double values[2] = { result.mass_, result.massErr_ };
+    double refValues[2] = { event->refMass_, event->refMassErr_ };
+    for ( int idxValue = 0; idxValue < 2; ++idxValue ) {
+      if ( idxValue > 0 ) std::cout << std::setw(12) << values[idxValue] << std::setw(12) << refValues[idxValue];
+      if ( refValues[idxValue] != 0. ) {
+        double relDeviation = (values[idxValue] - refValues[idxValue])/refValues[idxValue];
+        std::cout << std::fixed << std::setw(9) << std::setprecision(3) << 100.*relDeviation << "%" << std::defaultfloat << std::setprecision(6);
+        if ( !(std::abs(relDeviation) <= maxRelDeviation) ) isDeviation = true;
+      } else {
+        std::cout << std::setw(10) << "n/a";
+      }
+    }
+    if ( !result.isValidSolution_ ) std::cout << " (no valid solution)";
+    std::cout << std::endl;
+  }
+
+  // CV: measure computing time after all events have been processed once,
+  //     so that memory allocated for the first event of each channel does not enter the measurement
+  std::map<std::string, BenchmarkTimings> timings_perChannel;
+  for ( int iRepetition = 0; iRepetition < numRepetitions; ++iRepetition ) {
+    for ( std::vector<BenchmarkEvent>::const_iterator event = events.begin(); event != events.end(); ++event ) {
+      BenchmarkTimings timings;
+      unsigned long numAllocations_start = numAllocations;
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      SVfitResult result = runSVfit(svFitAlgo, *event);
+      timings.numSeconds_real_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      timings.numAllocations_ = numAllocations - numAllocations_start;
+      timings.numIntegrandCalls_ = result.numIntegrandCalls_;
+      timings.numEvents_ = 1;
+      timings_perChannel[event->channel_].add(timings);
+    }
+  }
+  std::cout << std::endl;
+  std::cout << "timings for " << numRepetitions << " repetition(s) of the corpus:" << std::endl;
+  std::cout << std::left << std::setw(16) << "channel" << std::right
+            << std::setw(12) << "events/s" << std::setw(14) << "ns/call" << std::setw(14) << "calls/event" << std::setw(14) << "allocs/event" << std::endl;
+  BenchmarkTimings timings_total;
+  for ( std::map<std::string, BenchmarkTimings>::const_iterator timings = timings_perChannel.begin();
+        timings != timings_perChannel.end(); ++timings ) {
+    printTimings(timings->first, timings->second);
+    timings_total.add(timings->second);
+  }
+  printTimings("total", timings_total);
+
+  if ( outputFileName != "" ) {
+    std::ofstream outputFile(outputFileName.data());
+    for ( std::vector<std::string>::const_iterator line = header.begin(); line != header.end(); ++line ) {
+      outputFile << (*line) << std::endl;
+    }
+    for ( size_t idxEvent = 0; idxEvent < events.size(); ++idxEvent ) {
+      outputFile << events[idxEvent].line_ << std::setprecision(6)
+                 << std::setw(9) << results[idxEvent].mass_ << std::setw(8) << results[idxEvent].massErr_ << std::endl;
+    }
+    std::cout << std::endl;
+    std::cout << "wrote corpus with updated reference values to file = " << outputFileName << std::endl;
+  }
+
+  if ( isDeviation ) {
+    std::cout << std::endl;
+    std::cout << "mass or massErr deviate from reference values by more than " << 100.*maxRelDeviation << "% !!" << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,313 @@
+/**
+   \class benchmarkClassicSVfitKernels benchmarkClassicSVfitKernels.cc "TauAnalysis/ClassicSVfit/bin/benchmarkClassicSVfitKernels.cc"
+   \brief Micro-benchmarks of the functions that dominate the computing time of ClassicSVfit, each measured in isolation
+
+   Usage: benchmarkClassicSVfitKernels [number of inputs] [number of repetitions]
+
+   The inputs of each function are generated randomly before the measurement, from tau leptons with pT, eta, phi
+   and decay parameters x, phiNu, nuMass distributed uniformly within their physical range;
+   groups of 1000 consecutive inputs share the same tau lepton, as the events processed by ClassicSVfit.
+   Each function is evaluated once for every input per repetition; mean, RMS and minimum of the computing time per call
+   are computed over the repetitions.
+*/
+
+#include "TauAnalysis/ClassicSVfit/interface/ClassicSVfitIntegrand.h"
+#include "TauAnalysis/ClassicSVfit/interface/FittedTauLepton.h"
+#include "TauAnalysis/ClassicSVfit/interface/MeasuredTauLepton.h"
+#include "TauAnalysis/ClassicSVfit/interface/SVfitIntegratorMarkovChain.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitAuxFunctions.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitHistogramAdapter.h"
+
+#include <TRandom3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace classic_svFit;
+
+namespace
+{
+  /// sum of all values returned by the functions, printed at the end to prevent the compiler from optimizing the calls away
+  double checksum = 0.;
+
+  const double leptonMasses[2] = { electronMass, muonMass };
+  const double hadTauMasses[3] = { chargedPionMass, 0.8, 1.1 };
+  const int hadTauDecayModes[3] = { 0, 1, 10 };
+
+  /// number of consecutive inputs generated for the same measured tau lepton
+  const unsigned numInputsPerLepton = 1000;
+}
+
+/// randomly generated inputs for the functions computing the tau decay kinematics and phase-space factors
+struct KernelInput
+{
+  MeasuredTauLepton measuredTauLepton_;
+  double x_;
+  double phiNu_;
+  double nuMass_;
+  double visEn_;
+  double visP_;
+  double visMass_;
+  double nuEn_;
+  double nuP_;
+};
+
+/// Markov Chain integrator with access to the stochastic move of the chain
+class SVfitIntegratorMarkovChainBenchmark : public SVfitIntegratorMarkovChain
+{
+ public:
+  SVfitIntegratorMarkovChainBenchmark()
+    : SVfitIntegratorMarkovChain("uniform", 10000, 90000, 2000, 6000, 15., 1. - 1./1000., 1, 100, 1.e-2, 0.71, 0)
+  {}
+  void prepare(gPtr_C integrand, const double* xl, const double* xu, unsigned numDimensions)
+  {
+    startIntegration(integrand, xl, xu, numDimensions);
+    startChain();
+  }
+  double move(unsigned idxMove)
+  {
+    bool isAccepted = false;
+    bool isValid = true;
+    makeStochasticMove(numIterSimAnnealingPhase1plus2_ + idxMove, isAccepted, isValid);
+    return prob_;
+  }
+};
+
+double toyIntegrand(const double* q, size_t numDimensions, void*)
+{
+  double arg = 0.;
+  for ( size_t iDimension = 0; iDimension < numDimensions; ++iDimension ) {
+    arg += square(q[iDimension] - 0.5);
+  }
+  return std::exp(-arg/0.02);
+}
+
+/// generate inputs in groups of numInputsPerLepton consecutive inputs, which share the same measured tau lepton,
+/// as the Markov Chain evaluates the functions many times for the tau leptons of one event
+void generateInputs(TRandom3& rnd, unsigned numInputs, bool isHadronicTauDecay, std::vector<KernelInput>& inputs)
+{
+  FittedTauLepton fittedTauLepton(0, 0);
+  MeasuredTauLepton measuredTauLepton;
+  while ( inputs.size() < numInputs ) {
+    if ( inputs.size() % numInputsPerLepton == 0 ) {
+      double pt = rnd.Uniform(20., 100.);
+      double eta = rnd.Uniform(-2.3, +2.3);
+      double phi = rnd.Uniform(-M_PI, +M_PI);
+      if ( isHadronicTauDecay ) {
+        int idxDecayMode = std::min(2, int(3.*rnd.Rndm()));
+        measuredTauLepton = MeasuredTauLepton(MeasuredTauLepton::kTauToHadDecay, pt, eta, phi, hadTauMasses[idxDecayMode], hadTauDecayModes[idxDecayMode]);
+      } else {
+        int idxLepton = std::min(1, int(2.*rnd.Rndm()));
+        measuredTauLepton = MeasuredTauLepton(( idxLepton == 0 ) ? MeasuredTauLepton::kTauToElecDecay : MeasuredTauLepton::kTauToMuDecay, pt, eta, phi, leptonMasses[idxLepton]);
+      }
+      fittedTauLepton.setMeasuredTauLepton(measuredTauLepton);
+      fittedTauLepton.updateVisMomentum(1.);
+    }
+    KernelInput input;
+    input.measuredTauLepton_ = measuredTauLepton;
+    input.visMass_ = input.measuredTauLepton_.mass();
+    double xMin = square(input.visMass_)/tauLeptonMass2;
+    input.x_ = rnd.Uniform(std::max(1.e-5, xMin), 1.);
+    input.phiNu_ = rnd.Uniform(-M_PI, +M_PI);
+    input.nuMass_ = ( isHadronicTauDecay ) ? 0. : rnd.Uniform(0., std::sqrt(1. - input.x_)*tauLeptonMass);
+    fittedTauLepton.updateTauMomentum(input.x_, input.phiNu_, input.nuMass_);
+    // CV: keep only inputs within the physical region, as encountered by the Markov Chain after the start-position has been found
+    if ( fittedTauLepton.errorCode() != FittedTauLepton::None ) continue;
+    input.visEn_ = fittedTauLepton.visP4().E();
+    input.visP_ = fittedTauLepton.visP4().P();
+    input.nuEn_ = fittedTauLepton.nuP4().E();
+    input.nuP_ = fittedTauLepton.nuP4().P();
+    inputs.push_back(input);
+  }
+}
+
+/// evaluate function for all inputs in each repetition and print computing time per call
+template <typename Kernel>
+void runKernel(const std::string& name, unsigned numCalls, unsigned numRepetitions, Kernel kernel)
+{
+  std::vector<double> timesPerCall;
+  for ( unsigned iRepetition = 0; iRepetition < numRepetitions; ++iRepetition ) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    checksum += kernel();
+    double numSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    timesPerCall.push_back(1.e+9*numSeconds/numCalls);
+  }
+  double mean = 0.;
+  for ( std::vector<double>::const_iterator timePerCall = timesPerCall.begin(); timePerCall != timesPerCall.end(); ++timePerCall ) {
+    mean += (*timePerCall);
+  }
+  mean /= numRepetitions;
+  double rms = 0.;
+  for ( std::vector<double>::const_iterator timePerCall = timesPerCall.begin(); timePerCall != timesPerCall.end(); ++timePerCall ) {
+    rms += square((*timePerCall) - mean);
+  }
+  rms = ( numRepetitions > 1 ) ? std::sqrt(rms/(numRepetitions - 1)) : 0.;
+  double min = *std::min_element(timesPerCall.begin(), timesPerCall.end());
+  std::cout << std::left << std::setw(48) << name << std::right << std::fixed << std::setprecision(2)
+            << std::setw(10) << mean << " +/- " << std::setw(8) << rms << std::setw(12) << min << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+  unsigned numInputs = ( argc > 1 ) ? std::atoi(argv[1]) : 100000;
+  unsigned numRepetitions = ( argc > 2 ) ? std::atoi(argv[2]) : 20;
+  if ( numInputs == 0 || numRepetitions == 0 ) {
+    std::cerr << "Usage: benchmarkClassicSVfitKernels [number of inputs] [number of repetitions]" << std::endl;
+    return 1;
+  }
+
+  TRandom3 rnd(12345);
+  std::vector<KernelInput> inputs_lep;
+  generateInputs(rnd, numInputs, false, inputs_lep);
+  std::vector<KernelInput> inputs_had;
+  generateInputs(rnd, numInputs, true, inputs_had);
+
+  std::cout << "computing time per call (in ns) for " << numInputs << " inputs and " << numRepetitions << " repetitions:" << std::endl;
+  std::cout << std::left << std::setw(48) << "function" << std::right << std::setw(10) << "mean" << "     " << std::setw(8) << "RMS" << std::setw(12) << "min" << std::endl;
+
+  FittedTauLepton fittedTauLepton(0, 0);
+  runKernel("FittedTauLepton::updateTauMomentum", numInputs, numRepetitions, [&]() {
+    double sum = 0.;
+    for ( std::vector<KernelInput>::const_iterator input = inputs_had.begin(); input != inputs_had.end(); ++input ) {
+      // CV: setting the measured tau lepton copies the MeasuredTauLepton object and computes the local coordinate system,
+      //     which ClassicSVfit does once per event. It is done once for each group of inputs generated for the same tau lepton,
+      //     so that its computing time is negligible compared to the numInputsPerLepton calls of updateTauMomentum
+      if ( (input - inputs_had.begin()) % numInputsPerLepton == 0 ) {
+        fittedTauLepton.setMeasuredTauLepton(input->measuredTauLepton_);
+        fittedTauLepton.updateVisMomentum(1.);
+      }
+      fittedTauLepton.updateTauMomentum(input->x_, input->phiNu_, input->nuMass_);
+      sum += fittedTauLepton.tauP4().E();
+    }
+    return sum;
+  });
+
+  runKernel("compCosThetaNuNu", numInputs, numRepetitions, [&]() {
+    double sum = 0.;
+    for ( std::vector<KernelInput>::const_iterator input = inputs_lep.begin(); input != inputs_lep.end(); ++input ) {
+      sum += compCosThetaNuNu(input->visEn_, input->visP_, square(input->visMass_), input->nuEn_, input->nuP_, square(input->nuMass_));
+    }
+    return sum;
+  });
+
+  runKernel("compPSfactor_tauToLepDecay", numInputs, numRepetitions, [&]() {
+    double sum = 0.;
+    for ( std::vector<KernelInput>::const_iterator input = inputs_lep.begin(); input != inputs_lep.end(); ++input ) {
+      sum += compPSfactor_tauToLepDecay(input->x_, input->visEn_, input->visP_, input->visMass_, input->nuEn_, input->nuP_, input->nuMass_);
+    }
+    return sum;
+  });
+
+  runKernel("compPSfactor_tauToHadDecay", numInputs, numRepetitions, [&]() {
+    double sum = 0.;
+    for ( std::vector<KernelInput>::const_iterator input = inputs_had.begin(); input != inputs_had.end(); ++input ) {
+      sum += compPSfactor_tauToHadDecay(input->x_, input->visEn_, input->visP_, input->visMass_, input->nuEn_, input->nuP_);
+    }
+    return sum;
+  });
+
+  // CV: MET transfer function is evaluated for randomly generated MET and covariance matrices,
+  //     with neutrino momenta of the tau leptons fixed by the inputs
+  ClassicSVfitIntegrand integrand(0);
+  std::vector<MeasuredTauLepton> measuredTauLeptons;
+  measuredTauLeptons.push_back(inputs_lep.front().measuredTauLepton_);
+  measuredTauLeptons.push_back(inputs_had.front().measuredTauLepton_);
+  integrand.setLeptonInputs(measuredTauLeptons);
+  std::vector<double> metX(numInputs);
+  std::vector<double> metY(numInputs);
+  std::vector<Matrix2x2> covMET(numInputs);
+  for ( unsigned idxInput = 0; idxInput < numInputs; ++idxInput ) {
+    metX[idxInput] = rnd.Gaus(0., 30.);
+    metY[idxInput] = rnd.Gaus(0., 30.);
+    double sigmaX2 = square(rnd.Uniform(10., 30.));
+    double sigmaY2 = square(rnd.Uniform(10., 30.));
+    double covXY = rnd.Uniform(-0.5, +0.5)*std::sqrt(sigmaX2*sigmaY2);
+    covMET[idxInput] = Matrix2x2(sigmaX2, covXY, covXY, sigmaY2);
+  }
+  runKernel("ClassicSVfitIntegrandBase::EvalMET_TF", numInputs, numRepetitions, [&]() {
+    double sum = 0.;
+    for ( unsigned idxInput = 0; idxInput < numInputs; ++idxInput ) {
+      sum += integrand.EvalMET_TF(metX[idxInput], metY[idxInput], covMET[idxInput]);
+    }
+    return sum;
+  });
+
+  // CV: the computing time of the stochastic move includes one evaluation of a (cheap) Gaussian integrand in 5 dimensions
+  SVfitIntegratorMarkovChainBenchmark intAlgo;
+  const unsigned numDimensions = 5;
+  double xl[numDimensions] = { 0., 0., 0., 0., 0. };
+  double xu[numDimensions] = { 1., 1., 1., 1., 1. };
+  intAlgo.prepare(&toyIntegrand, xl, xu, numDimensions);
+  runKernel("SVfitIntegratorMarkovChain::makeStochasticMove", numInputs, numRepetitions, [&]() {
+    double sum = 0.;
+    for ( unsigned idxInput = 0; idxInput < numInputs; ++idxInput ) {
+      sum += intAlgo.move(idxInput);
+    }
+    return sum;
+  });
+
+  HistogramAdapterDiTau histogramAdapter;
+  const KernelInput& leg1 = inputs_lep.front();
+  const KernelInput& leg2 = inputs_had.front();
+  histogramAdapter.setMeasurement(leg1.measuredTauLepton_.p4(), leg2.measuredTauLepton_.p4(), Vector(metX.front(), metY.front(), 0.));
+  histogramAdapter.bookHistograms(leg1.measuredTauLepton_.p4(), leg2.measuredTauLepton_.p4(), Vector(metX.front(), metY.front(), 0.));
+  std::vector<LorentzVector> tauP4s_lep;
+  std::vector<LorentzVector> tauP4s_had;
+  FittedTauLepton fittedTauLepton1(0, 0);
+  FittedTauLepton fittedTauLepton2(1, 0);
+  fittedTauLepton1.setMeasuredTauLepton(leg1.measuredTauLepton_);
+  fittedTauLepton1.updateVisMomentum(1.);
+  fittedTauLepton2.setMeasuredTauLepton(leg2.measuredTauLepton_);
+  fittedTauLepton2.updateVisMomentum(1.);
+  for ( unsigned idxInput = 0; idxInput < numInputs; ++idxInput ) {
+    fittedTauLepton1.updateTauMomentum(inputs_lep[idxInput].x_, inputs_lep[idxInput].phiNu_, inputs_lep[idxInput].nuMass_);
+    fittedTauLepton2.updateTauMomentum(inputs_had[idxInput].x_, inputs_had[idxInput].phiNu_, inputs_had[idxInput].nuMass_);
+    tauP4s_lep.push_back(fittedTauLepton1.tauP4());
+    tauP4s_had.push_back(fittedTauLepton2.tauP4());
+  }
+  runKernel("HistogramAdapterDiTau::DoEval", numInputs, numRepetitions, [&]() {
+    for ( unsigned idxInput = 0; idxInput < numInputs; ++idxInput ) {
+      histogramAdapter.setTau1And2P4(tauP4s_lep[idxInput], tauP4s_had[idxInput]);
+      histogramAdapter(xl);
+    }
+    return histogramAdapter.getMass();
+  });
+
+  // CV: histograms of the mass of the di-tau system with different mean and width;
+  //     the computing time does not depend on the number of entries
+  const unsigned numHistograms = 16;
+  std::vector<SVfitHistogram> histograms(numHistograms);
+  HistogramBinning binning;
+  HistogramTools::compBinning_linBinWidth(250, 0., 500., binning);
+  for ( unsigned idxHistogram = 0; idxHistogram < numHistograms; ++idxHistogram ) {
+    SVfitHistogram& histogram = histograms[idxHistogram];
+    histogram.setBinning(binning);
+    double mean = rnd.Uniform(80., 200.);
+    double sigma = rnd.Uniform(5., 50.);
+    for ( unsigned idxEntry = 0; idxEntry < 10000; ++idxEntry ) {
+      histogram.fill(rnd.Gaus(mean, sigma));
+    }
+  }
+  HistogramProperties properties;
+  std::vector<double> workspace;
+  unsigned numCalls_extract = std::max(1u, numInputs/100);
+  runKernel("HistogramTools::extractHistogramProperties", numCalls_extract, numRepetitions, [&]() {
+    double sum = 0.;
+    for ( unsigned idxCall = 0; idxCall < numCalls_extract; ++idxCall ) {
+      HistogramTools::extractHistogramProperties(histograms[idxCall % numHistograms], properties, workspace);
+      sum += properties.xMean_;
+    }
+    return sum;
+  });
+
+  std::cout << std::endl;
+  std::cout << "checksum = " << std::defaultfloat << checksum << std::endl;
+
+  return 0;
+}
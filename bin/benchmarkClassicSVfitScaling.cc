@@ -0,0 +1,202 @@
+/**
+   \class benchmarkClassicSVfitScaling benchmarkClassicSVfitScaling.cc "TauAnalysis/ClassicSVfit/bin/benchmarkClassicSVfitScaling.cc"
+   \brief Measure the scaling of the throughput of ClassicSVfit with the number of threads,
+          on events generated by generateClassicSVfitToyEvents
+
+   Each thread processes events with its own ClassicSVfit instance, taking the next event from a common queue.
+   For strong scaling, the total number of events is fixed; for weak scaling, the number of events per thread is fixed.
+   For each number of threads, the throughput, the speed-up and the parallel efficiency relative to one thread,
+   the 50% and 99% percentiles of the computing time per event and the high-water mark of the memory usage are printed.
+
+   Usage: benchmarkClassicSVfitScaling input file [maximum number of threads] [number of events for strong scaling]
+                                       [number of events per thread for weak scaling] [number of evaluations of the integrand]
+*/
+
+#include "TauAnalysis/ClassicSVfit/interface/ClassicSVfit.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitToyGenerator.h"
+
+#include <TMatrixD.h>
+#include <TROOT.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace classic_svFit;
+
+typedef std::chrono::steady_clock Clock;
+
+void processEvents(const std::vector<SVfitToyEvent>& events, std::atomic<unsigned long>& nextEvent, unsigned long numEvents,
+                   unsigned maxObjFunctionCalls, std::vector<double>& latencies)
+{
+  ClassicSVfit svFitAlgo(0);
+  svFitAlgo.addLogM_fixed(true, 4.);
+  svFitAlgo.setMaxObjFunctionCalls(maxObjFunctionCalls);
+  TMatrixD covMET(2, 2);
+  while ( true ) {
+    unsigned long idxEvent = nextEvent++;
+    if ( idxEvent >= numEvents ) break;
+    const SVfitToyEvent& event = events[idxEvent % events.size()];
+    covMET[0][0] = event.covMET_.xx_;
+    covMET[0][1] = event.covMET_.xy_;
+    covMET[1][0] = event.covMET_.yx_;
+    covMET[1][1] = event.covMET_.yy_;
+    Clock::time_point start = Clock::now();
+    svFitAlgo.integrate(event.measuredTauLeptons_, event.measuredMETx_, event.measuredMETy_, covMET);
+    latencies.push_back(std::chrono::duration<double>(Clock::now() - start).count());
+  }
+}
+
+/// return wall-clock time (in seconds) needed to process the given number of events with the given number of threads
+double runThreads(const std::vector<SVfitToyEvent>& events, unsigned numThreads, unsigned long numEvents, unsigned maxObjFunctionCalls,
+                  std::vector<double>& latencies)
+{
+  std::vector<std::vector<double> > latencies_perThread(numThreads);
+  std::atomic<unsigned long> nextEvent(0);
+  Clock::time_point start = Clock::now();
+  std::vector<std::thread> threads;
+  for ( unsigned idxThread = 0; idxThread < numThreads; ++idxThread ) {
+    threads.push_back(std::thread(processEvents, std::cref(events), std::ref(nextEvent), numEvents, maxObjFunctionCalls,
+                                  std::ref(latencies_perThread[idxThread])));
+  }
+  for ( std::vector<std::thread>::iterator thread = threads.begin(); thread != threads.end(); ++thread ) {
+    thread->join();
+  }
+  double numSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+  latencies.clear();
+  for ( unsigned idxThread = 0; idxThread < numThreads; ++idxThread ) {
+    latencies.insert(latencies.end(), latencies_perThread[idxThread].begin(), latencies_perThread[idxThread].end());
+  }
+  std::sort(latencies.begin(), latencies.end());
+  return numSeconds;
+}
+
+double getPercentile(const std::vector<double>& sortedValues, double fraction)
+{
+  if ( sortedValues.empty() ) return 0.;
+  return sortedValues[std::min(sortedValues.size() - 1, size_t(fraction*sortedValues.size()))];
+}
+
+/// high-water mark of the resident memory of the process (in MB), or -1 if not available
+double getMemoryHighWaterMark()
+{
+  std::ifstream file("/proc/self/status");
+  std::string line;
+  while ( std::getline(file, line) ) {
+    if ( line.find("VmHWM:") == 0 ) {
+      std::istringstream stream(line.substr(6));
+      double kB = 0.;
+      stream >> kB;
+      return kB/1024.;
+    }
+  }
+  return -1.;
+}
+
+/// number of CPUs in a list of the form "0-3,8-11"
+unsigned countCPUs(const std::string& cpuList)
+{
+  unsigned numCPUs = 0;
+  std::istringstream stream(cpuList);
+  std::string range;
+  while ( std::getline(stream, range, ',') ) {
+    size_t idxSeparator = range.find('-');
+    if ( idxSeparator == std::string::npos ) ++numCPUs;
+    else numCPUs += std::atoi(range.substr(idxSeparator + 1).data()) - std::atoi(range.substr(0, idxSeparator).data()) + 1;
+  }
+  return numCPUs;
+}
+
+void printNUMATopology()
+{
+  const std::string nodePath = "/sys/devices/system/node/";
+  std::ifstream onlineFile((nodePath + "online").data());
+  std::string onlineNodes;
+  if ( !std::getline(onlineFile, onlineNodes) ) {
+    std::cout << "NUMA topology not available" << std::endl;
+    return;
+  }
+  std::istringstream stream(onlineNodes);
+  std::string range;
+  while ( std::getline(stream, range, ',') ) {
+    size_t idxSeparator = range.find('-');
+    int firstNode = std::atoi(range.substr(0, idxSeparator).data());
+    int lastNode = ( idxSeparator == std::string::npos ) ? firstNode : std::atoi(range.substr(idxSeparator + 1).data());
+    for ( int node = firstNode; node <= lastNode; ++node ) {
+      std::ifstream cpuListFile((nodePath + "node" + std::to_string(node) + "/cpulist").data());
+      std::string cpuList;
+      std::getline(cpuListFile, cpuList);
+      std::cout << "NUMA node " << node << ": CPUs " << cpuList << " (" << countCPUs(cpuList) << " CPUs)" << std::endl;
+    }
+  }
+}
+
+void runScaling(const std::string& label, const std::vector<SVfitToyEvent>& events, const std::vector<unsigned>& numThreads,
+                unsigned long numEvents, bool isWeakScaling, unsigned maxObjFunctionCalls)
+{
+  std::cout << label << ":" << std::endl;
+  std::cout << std::setw(8) << "threads" << std::setw(8) << "events" << std::setw(12) << "events/s" << std::setw(10) << "speed-up"
+            << std::setw(12) << "efficiency" << std::setw(10) << "p50 [ms]" << std::setw(10) << "p99 [ms]" << std::setw(12) << "VmHWM [MB]" << std::endl;
+  double throughput_1thread = 0.;
+  for ( std::vector<unsigned>::const_iterator numThreads_i = numThreads.begin(); numThreads_i != numThreads.end(); ++numThreads_i ) {
+    unsigned long numEvents_i = ( isWeakScaling ) ? numEvents*(*numThreads_i) : numEvents;
+    std::vector<double> latencies;
+    double numSeconds = runThreads(events, *numThreads_i, numEvents_i, maxObjFunctionCalls, latencies);
+    double throughput = ( numSeconds > 0. ) ? numEvents_i/numSeconds : 0.;
+    if ( numThreads_i == numThreads.begin() ) throughput_1thread = throughput/(*numThreads_i);
+    double speedup = ( throughput_1thread > 0. ) ? throughput/throughput_1thread : 0.;
+    std::cout << std::setw(8) << (*numThreads_i) << std::setw(8) << numEvents_i << std::setw(12) << throughput << std::setw(10) << speedup
+              << std::setw(12) << speedup/(*numThreads_i) << std::setw(10) << 1.e+3*getPercentile(latencies, 0.50)
+              << std::setw(10) << 1.e+3*getPercentile(latencies, 0.99) << std::setw(12) << getMemoryHighWaterMark() << std::endl;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  if ( argc < 2 ) {
+    std::cerr << "Usage: benchmarkClassicSVfitScaling input file [maximum number of threads] [number of events for strong scaling]"
+              << " [number of events per thread for weak scaling] [number of evaluations of the integrand]" << std::endl;
+    return 1;
+  }
+  std::string inputFileName = argv[1];
+  unsigned maxThreads = ( argc > 2 ) ? std::atoi(argv[2]) : std::max(1U, std::thread::hardware_concurrency());
+  unsigned long numEvents_strong = ( argc > 3 ) ? std::atol(argv[3]) : 200;
+  unsigned long numEvents_weak = ( argc > 4 ) ? std::atol(argv[4]) : 20;
+  unsigned maxObjFunctionCalls = ( argc > 5 ) ? std::atoi(argv[5]) : 30000;
+
+  // CV: TH1 objects are created concurrently by the ClassicSVfit instances of the different threads
+  ROOT::EnableThreadSafety();
+
+  std::vector<SVfitToyEvent> events;
+  SVfitToyEventReader reader(inputFileName);
+  SVfitToyEvent event;
+  while ( reader.read(event) ) {
+    events.push_back(event);
+  }
+  if ( events.empty() ) {
+    std::cerr << "No events in file = " << inputFileName << " !!" << std::endl;
+    return 1;
+  }
+  std::cout << "read " << events.size() << " events from file = " << inputFileName << std::endl;
+  std::cout << "hardware concurrency = " << std::thread::hardware_concurrency() << std::endl;
+  printNUMATopology();
+
+  std::vector<unsigned> numThreads;
+  for ( unsigned numThreads_i = 1; numThreads_i < maxThreads; numThreads_i *= 2 ) {
+    numThreads.push_back(numThreads_i);
+  }
+  numThreads.push_back(maxThreads);
+
+  runScaling("strong scaling", events, numThreads, numEvents_strong, false, maxObjFunctionCalls);
+  runScaling("weak scaling", events, numThreads, numEvents_weak, true, maxObjFunctionCalls);
+
+  return 0;
+}
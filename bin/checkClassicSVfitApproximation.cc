@@ -0,0 +1,123 @@
+/**
+   \class checkClassicSVfitApproximation checkClassicSVfitApproximation.cc "TauAnalysis/ClassicSVfit/bin/checkClassicSVfitApproximation.cc"
+   \brief Compare the approximate estimates of the di-tau mass (cf. SVfitApproximation) with the mass reconstructed by ClassicSVfit,
+          on events generated by generateClassicSVfitToyEvents
+
+   For a given mass window, the tool prints the fraction of events with reconstructed mass within the window
+   that pass the pre-selection by SVfitApproximation::isCompatible (which is expected to be one),
+   the fraction of all other events that get rejected, and the computing time of the approximate estimates.
+   The tool returns a nonzero value if more than 1% of the events within the window get rejected.
+
+   Usage: checkClassicSVfitApproximation input file [minimum mass] [maximum mass] [maximum number of events] [number of evaluations of the integrand]
+*/
+
+#include "TauAnalysis/ClassicSVfit/interface/ClassicSVfit.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitToyGenerator.h"
+
+#include <TMatrixD.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace classic_svFit;
+
+typedef std::chrono::steady_clock Clock;
+
+int main(int argc, char* argv[])
+{
+  if ( argc < 2 ) {
+    std::cerr << "Usage: checkClassicSVfitApproximation input file [minimum mass] [maximum mass] [maximum number of events]"
+              << " [number of evaluations of the integrand]" << std::endl;
+    return 1;
+  }
+  std::string inputFileName = argv[1];
+  double massMin = ( argc > 2 ) ? std::atof(argv[2]) : 100.;
+  double massMax = ( argc > 3 ) ? std::atof(argv[3]) : 150.;
+  unsigned long maxEvents = ( argc > 4 ) ? std::atol(argv[4]) : 200;
+  unsigned maxObjFunctionCalls = ( argc > 5 ) ? std::atoi(argv[5]) : 100000;
+
+  std::vector<SVfitToyEvent> events;
+  SVfitToyEventReader reader(inputFileName);
+  SVfitToyEvent event;
+  while ( events.size() < maxEvents && reader.read(event) ) {
+    events.push_back(event);
+  }
+  if ( events.empty() ) {
+    std::cerr << "No events in file = " << inputFileName << " !!" << std::endl;
+    return 1;
+  }
+
+  ClassicSVfit svFitAlgo(0);
+  svFitAlgo.addLogM_fixed(true, 4.);
+  svFitAlgo.setMaxObjFunctionCalls(maxObjFunctionCalls);
+
+//--- measure computing time of the approximate estimates
+  std::vector<TMatrixD> covMETs;
+  for ( std::vector<SVfitToyEvent>::const_iterator event = events.begin(); event != events.end(); ++event ) {
+    TMatrixD covMET(2, 2);
+    covMET[0][0] = event->covMET_.xx_;
+    covMET[0][1] = event->covMET_.xy_;
+    covMET[1][0] = event->covMET_.yx_;
+    covMET[1][1] = event->covMET_.yy_;
+    covMETs.push_back(covMET);
+  }
+  const unsigned numRepetitions = 1000;
+  double checksum = 0.;
+  Clock::time_point start = Clock::now();
+  for ( unsigned iRepetition = 0; iRepetition < numRepetitions; ++iRepetition ) {
+    for ( size_t idxEvent = 0; idxEvent < events.size(); ++idxEvent ) {
+      const SVfitToyEvent& event = events[idxEvent];
+      checksum += svFitAlgo.approximate(event.measuredTauLeptons_, event.measuredMETx_, event.measuredMETy_, covMETs[idxEvent]).collinearMass_;
+    }
+  }
+  double numSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+  std::cout << "computing time of approximate estimates = " << 1.e+9*numSeconds/(numRepetitions*events.size()) << " ns/event"
+            << " (checksum = " << checksum << ")" << std::endl;
+
+  unsigned long numEvents_inside = 0;
+  unsigned long numEvents_inside_passed = 0;
+  unsigned long numEvents_outside = 0;
+  unsigned long numEvents_outside_rejected = 0;
+  std::vector<double> ratios;
+  for ( size_t idxEvent = 0; idxEvent < events.size(); ++idxEvent ) {
+    const SVfitToyEvent& event = events[idxEvent];
+    SVfitApproximation approximation = svFitAlgo.approximate(event.measuredTauLeptons_, event.measuredMETx_, event.measuredMETy_, covMETs[idxEvent]);
+    SVfitResult result = svFitAlgo.integrate(event.measuredTauLeptons_, event.measuredMETx_, event.measuredMETy_, covMETs[idxEvent]);
+    if ( !result.isValidSolution_ ) continue;
+    if ( approximation.isValidCollinearSolution_ ) ratios.push_back(approximation.collinearMass_/result.mass_);
+    bool isCompatible = approximation.isCompatible(massMin, massMax);
+    if ( result.mass_ >= massMin && result.mass_ <= massMax ) {
+      ++numEvents_inside;
+      if ( isCompatible ) {
+        ++numEvents_inside_passed;
+      } else {
+        std::cout << "event #" << idxEvent << " (" << getDecayChannelName(event.measuredTauLeptons_) << "): mass = " << result.mass_ << " rejected,"
+                  << " visible mass = " << approximation.visibleMass_ << ", collinear mass = " << approximation.collinearMass_
+                  << " +/- " << approximation.collinearMassErr_ << std::endl;
+      }
+    } else {
+      ++numEvents_outside;
+      if ( !isCompatible ) ++numEvents_outside_rejected;
+    }
+  }
+
+  // CV: the collinear mass has long tails, for events with the visible decay products nearly back-to-back in the transverse plane
+  std::sort(ratios.begin(), ratios.end());
+  if ( !ratios.empty() ) {
+    std::cout << "collinear mass/reconstructed mass: minimum = " << ratios.front() << ", 16% quantile = " << ratios[ratios.size()*16/100]
+              << ", median = " << ratios[ratios.size()/2] << ", 84% quantile = " << ratios[ratios.size()*84/100]
+              << " (" << ratios.size() << " events with physical collinear solution)" << std::endl;
+  }
+  double efficiency = ( numEvents_inside > 0 ) ? double(numEvents_inside_passed)/numEvents_inside : 1.;
+  double rejection = ( numEvents_outside > 0 ) ? double(numEvents_outside_rejected)/numEvents_outside : 0.;
+  std::cout << "mass window = [" << massMin << ", " << massMax << "]:"
+            << " efficiency for events within window = " << efficiency << " (" << numEvents_inside << " events),"
+            << " rejection of events outside window = " << rejection << " (" << numEvents_outside << " events)" << std::endl;
+
+  return ( efficiency >= 0.99 ) ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+/**
+   \class closureClassicSVfit closureClassicSVfit.cc "TauAnalysis/ClassicSVfit/bin/closureClassicSVfit.cc"
+   \brief Closure test of ClassicSVfit on events generated by generateClassicSVfitToyEvents:
+          compares the reconstructed mass to the true mass for different numbers of evaluations of the integrand
+
+   Usage: closureClassicSVfit input file [maximum number of events] [numbers of evaluations of the integrand, separated by commas]
+*/
+
+#include "TauAnalysis/ClassicSVfit/interface/ClassicSVfit.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitToyGenerator.h"
+
+#include <TMatrixD.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace classic_svFit;
+
+int main(int argc, char* argv[])
+{
+  if ( argc < 2 ) {
+    std::cerr << "Usage: closureClassicSVfit input file [maximum number of events] [numbers of evaluations of the integrand]" << std::endl;
+    return 1;
+  }
+  std::string inputFileName = argv[1];
+  unsigned long maxEvents = ( argc > 2 ) ? std::atol(argv[2]) : 100;
+  std::vector<unsigned> maxObjFunctionCalls;
+  std::istringstream maxObjFunctionCalls_string(( argc > 3 ) ? argv[3] : "10000,30000,100000");
+  std::string item;
+  while ( std::getline(maxObjFunctionCalls_string, item, ',') ) {
+    maxObjFunctionCalls.push_back(std::atoi(item.data()));
+  }
+
+  std::vector<SVfitToyEvent> events;
+  SVfitToyEventReader reader(inputFileName);
+  SVfitToyEvent event;
+  while ( events.size() < maxEvents && reader.read(event) ) {
+    events.push_back(event);
+  }
+  std::cout << "read " << events.size() << " events from file = " << inputFileName << std::endl;
+
+  std::cout << std::setw(12) << "calls" << std::setw(12) << "<m/mTrue>" << std::setw(12) << "RMS" << std::setw(14) << "<massErr/m>"
+            << std::setw(12) << "failures" << std::setw(14) << "ms/event" << std::endl;
+  ClassicSVfit svFitAlgo(0);
+  svFitAlgo.addLogM_fixed(true, 4.);
+  TMatrixD covMET(2, 2);
+  for ( std::vector<unsigned>::const_iterator numCalls = maxObjFunctionCalls.begin(); numCalls != maxObjFunctionCalls.end(); ++numCalls ) {
+    svFitAlgo.setMaxObjFunctionCalls(*numCalls);
+    double sumRatio = 0.;
+    double sumRatio2 = 0.;
+    double sumRelErr = 0.;
+    double sumSeconds = 0.;
+    unsigned long numValid = 0;
+    for ( std::vector<SVfitToyEvent>::const_iterator event = events.begin(); event != events.end(); ++event ) {
+      covMET[0][0] = event->covMET_.xx_;
+      covMET[0][1] = event->covMET_.xy_;
+      covMET[1][0] = event->covMET_.yx_;
+      covMET[1][1] = event->covMET_.yy_;
+      SVfitResult result = svFitAlgo.integrate(event->measuredTauLeptons_, event->measuredMETx_, event->measuredMETy_, covMET);
+      sumSeconds += result.numSeconds_real_;
+      if ( !(result.isValidSolution_ && result.mass_ > 0.) ) continue;
+      double ratio = result.mass_/event->trueMass_;
+      sumRatio += ratio;
+      sumRatio2 += ratio*ratio;
+      sumRelErr += result.massErr_/result.mass_;
+      ++numValid;
+    }
+    double meanRatio = ( numValid > 0 ) ? sumRatio/numValid : 0.;
+    double rmsRatio = ( numValid > 0 ) ? std::sqrt(std::max(0., sumRatio2/numValid - meanRatio*meanRatio)) : 0.;
+    double meanRelErr = ( numValid > 0 ) ? sumRelErr/numValid : 0.;
+    double msPerEvent = ( events.size() > 0 ) ? 1.e+3*sumSeconds/events.size() : 0.;
+    std::cout << std::setw(12) << (*numCalls) << std::setw(12) << meanRatio << std::setw(12) << rmsRatio << std::setw(14) << meanRelErr
+              << std::setw(12) << (events.size() - numValid) << std::setw(14) << msPerEvent << std::endl;
+  }
+
+  return 0;
+}
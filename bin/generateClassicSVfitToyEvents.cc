@@ -0,0 +1,72 @@
+/**
+   \class generateClassicSVfitToyEvents generateClassicSVfitToyEvents.cc "TauAnalysis/ClassicSVfit/bin/generateClassicSVfitToyEvents.cc"
+   \brief Generate H/Z -> tau tau events with SVfitToyGenerator and write them to a binary file
+
+   Usage: generateClassicSVfitToyEvents output file [number of events] [channel] [mass] [width] [seed]
+
+   The channel is given by the decay types of the two legs (e, mu, had or any), e.g. "mu_had";
+   "prompt_had" generates lepton-flavor-violating H -> mu tau -> mu tau_h nu decays.
+*/
+
+#include "TauAnalysis/ClassicSVfit/interface/svFitToyGenerator.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+
+using namespace classic_svFit;
+
+bool parseDecayType(const std::string& name, int& decayType)
+{
+  if      ( name == "e"      ) decayType = MeasuredTauLepton::kTauToElecDecay;
+  else if ( name == "mu"     ) decayType = MeasuredTauLepton::kTauToMuDecay;
+  else if ( name == "had"    ) decayType = MeasuredTauLepton::kTauToHadDecay;
+  else if ( name == "prompt" ) decayType = MeasuredTauLepton::kPrompt;
+  else if ( name == "any"    ) decayType = MeasuredTauLepton::kUndefinedDecayType;
+  else return false;
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  if ( argc < 2 ) {
+    std::cerr << "Usage: generateClassicSVfitToyEvents output file [number of events] [channel] [mass] [width] [seed]" << std::endl;
+    return 1;
+  }
+  std::string outputFileName = argv[1];
+  unsigned long numEvents = ( argc > 2 ) ? std::atol(argv[2]) : 1000;
+  std::string channel = ( argc > 3 ) ? argv[3] : "any_any";
+  double mass = ( argc > 4 ) ? std::atof(argv[4]) : 125.;
+  double width = ( argc > 5 ) ? std::atof(argv[5]) : 0.;
+  unsigned seed = ( argc > 6 ) ? std::atoi(argv[6]) : 12345;
+
+  size_t idxSeparator = channel.find('_');
+  int decayType1, decayType2;
+  if ( idxSeparator == std::string::npos ||
+       !parseDecayType(channel.substr(0, idxSeparator), decayType1) ||
+       !parseDecayType(channel.substr(idxSeparator + 1), decayType2) || decayType2 == MeasuredTauLepton::kPrompt ) {
+    std::cerr << "Invalid channel = " << channel << " !!" << std::endl;
+    return 1;
+  }
+
+  SVfitToyGenerator generator(decayType1, decayType2, seed);
+  generator.setMass(mass, width);
+  SVfitToyEventWriter writer(outputFileName);
+  SVfitToyEvent event;
+  std::map<std::string, unsigned long> numEvents_perChannel;
+  for ( unsigned long idxEvent = 0; idxEvent < numEvents; ++idxEvent ) {
+    generator.generate(event);
+    writer.write(event);
+    ++numEvents_perChannel[getDecayChannelName(event.measuredTauLeptons_)];
+  }
+
+  std::cout << "wrote " << generator.getNumEventsAccepted() << " events to file = " << outputFileName
+            << " (acceptance = " << double(generator.getNumEventsAccepted())/generator.getNumEventsGenerated() << ")" << std::endl;
+  for ( std::map<std::string, unsigned long>::const_iterator numEvents_channel = numEvents_perChannel.begin();
+        numEvents_channel != numEvents_perChannel.end(); ++numEvents_channel ) {
+    std::cout << " channel = " << numEvents_channel->first << ": " << numEvents_channel->second << " events" << std::endl;
+  }
+
+  return 0;
+}
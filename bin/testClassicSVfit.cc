@@ -53,7 +53,7 @@ int main(int argc, char* argv[])
   //svFitAlgo.addLogM_dynamic(true, "(m/1000.)*15.");
   //svFitAlgo.setMaxObjFunctionCalls(100000); // CV: default is 100000 evaluations of integrand per event
   svFitAlgo.setLikelihoodFileName("testClassicSVfit.root");
-  svFitAlgo.integrate(measuredTauLeptons, measuredMETx, measuredMETy, covMET);
+  SVfitResult result_1stRun = svFitAlgo.integrate(measuredTauLeptons, measuredMETx, measuredMETy, covMET);
   bool isValidSolution_1stRun = svFitAlgo.isValidSolution();
   double mass_1stRun = static_cast<HistogramAdapterDiTau*>(svFitAlgo.getHistogramAdapter())->getMass();
   double massErr_1stRun = static_cast<HistogramAdapterDiTau*>(svFitAlgo.getHistogramAdapter())->getMassErr();
@@ -70,6 +70,10 @@ int main(int argc, char* argv[])
   if (std::abs((massErr_1stRun - 87.001) / 87.0011) > 0.001) return 1;
   if (std::abs((transverseMass_1stRun - 114.242) / 114.242) > 0.001) return 1;
   if (std::abs((transverseMassErr_1stRun - 85.8296) / 85.8296) > 0.001) return 1;
+  // results returned by integrate method need to agree with those of the histogram adapter
+  if ( result_1stRun.isValidSolution_ != isValidSolution_1stRun ) return 1;
+  if ( result_1stRun.mass_ != mass_1stRun || result_1stRun.massErr_ != massErr_1stRun ) return 1;
+  if ( result_1stRun.transverseMass_ != transverseMass_1stRun || result_1stRun.transverseMassErr_ != transverseMassErr_1stRun ) return 1;
  
   // re-run with mass constraint
   double massContraint = 125.06;
@@ -0,0 +1,165 @@
+/**
+   \class testClassicSVfitAllocations testClassicSVfitAllocations.cc "TauAnalysis/ClassicSVfit/bin/testClassicSVfitAllocations.cc"
+   \brief Test that repeated calls to ClassicSVfit::integrate do not allocate memory on the heap,
+          once all events have been processed for the first time,
+          for further events with smaller or larger visible mass, i.e. mass histograms with more or fewer bins,
+          and for events alternating between decay channels with different integrator settings
+*/
+
+#include "TauAnalysis/ClassicSVfit/interface/ClassicSVfit.h"
+#include "TauAnalysis/ClassicSVfit/interface/MeasuredTauLepton.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitHistogramAdapter.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitIntegratorSettings.h"
+
+#include <TMatrixD.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+
+using namespace classic_svFit;
+
+namespace
+{
+  std::atomic<unsigned long> numAllocations(0);
+
+  void* allocate(std::size_t size)
+  {
+    ++numAllocations;
+    void* ptr = std::malloc(( size > 0 ) ? size : 1);
+    if ( !ptr ) throw std::bad_alloc();
+    return ptr;
+  }
+}
+
+// CV: count all heap allocations made via operator new
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+struct TestEvent
+{
+  TestEvent()
+    : measuredMETx_(0.)
+    , measuredMETy_(0.)
+    , covMET_(2, 2)
+  {}
+  std::vector<MeasuredTauLepton> measuredTauLeptons_;
+  double measuredMETx_;
+  double measuredMETy_;
+  TMatrixD covMET_;
+};
+
+int main(int argc, char* argv[])
+{
+  // define events of different decay channels, which result in histograms with different binning
+  std::vector<TestEvent> events(3);
+  events[0].measuredTauLeptons_.push_back(MeasuredTauLepton(MeasuredTauLepton::kTauToElecDecay, 33.7393, 0.9409,  -0.541458, 0.51100e-3));
+  events[0].measuredTauLeptons_.push_back(MeasuredTauLepton(MeasuredTauLepton::kTauToHadDecay,  25.7322, 0.618228, 2.79362,  0.13957, 0));
+  events[0].measuredMETx_ =  11.7491;
+  events[0].measuredMETy_ = -51.9172;
+  events[1].measuredTauLeptons_.push_back(MeasuredTauLepton(MeasuredTauLepton::kTauToMuDecay,   41.2,    -0.3,     1.2,      0.10566));
+  events[1].measuredTauLeptons_.push_back(MeasuredTauLepton(MeasuredTauLepton::kTauToHadDecay,  38.5,     0.4,    -1.9,      0.8, 1));
+  events[1].measuredMETx_ =  25.3;
+  events[1].measuredMETy_ =  12.8;
+  events[2].measuredTauLeptons_.push_back(MeasuredTauLepton(MeasuredTauLepton::kTauToHadDecay,  62.1,     1.1,     0.2,      1.1, 10));
+  events[2].measuredTauLeptons_.push_back(MeasuredTauLepton(MeasuredTauLepton::kTauToHadDecay,  55.7,    -0.7,    -2.8,      0.13957, 0));
+  events[2].measuredMETx_ = -18.4;
+  events[2].measuredMETy_ =  30.9;
+  for ( std::vector<TestEvent>::iterator event = events.begin(); event != events.end(); ++event ) {
+    event->covMET_[0][0] =  787.352;
+    event->covMET_[1][0] = -178.63;
+    event->covMET_[0][1] = -178.63;
+    event->covMET_[1][1] =  179.545;
+  }
+
+  int verbosity = 0;
+  ClassicSVfit svFitAlgo(verbosity);
+  svFitAlgo.addLogM_fixed(true, 6.);
+  svFitAlgo.setMaxObjFunctionCalls(20000);
+
+  // CV: the first pass allocates the memory needed for all events,
+  //     the second pass is expected to reuse it
+  double mass_1stPass[3];
+  for ( size_t idxEvent = 0; idxEvent < events.size(); ++idxEvent ) {
+    const TestEvent& event = events[idxEvent];
+    mass_1stPass[idxEvent] = svFitAlgo.integrate(event.measuredTauLeptons_, event.measuredMETx_, event.measuredMETy_, event.covMET_).mass_;
+  }
+  unsigned long numAllocations_2ndPass = numAllocations;
+  double mass_2ndPass[3];
+  for ( size_t idxEvent = 0; idxEvent < events.size(); ++idxEvent ) {
+    const TestEvent& event = events[idxEvent];
+    mass_2ndPass[idxEvent] = svFitAlgo.integrate(event.measuredTauLeptons_, event.measuredMETx_, event.measuredMETy_, event.covMET_).mass_;
+  }
+  numAllocations_2ndPass = numAllocations - numAllocations_2ndPass;
+
+  // CV: scale the momenta of the visible decay products down and up, so that the binning of the mass histograms differs for each event;
+  //     the events are constructed before counting the allocations
+  const unsigned numScaledEvents = 10;
+  std::vector<TestEvent> scaledEvents(numScaledEvents*events.size());
+  for ( unsigned idxScale = 0; idxScale < numScaledEvents; ++idxScale ) {
+    double scale = 0.25 + 0.15*idxScale;
+    for ( size_t idxEvent = 0; idxEvent < events.size(); ++idxEvent ) {
+      const TestEvent& event = events[idxEvent];
+      TestEvent& scaledEvent = scaledEvents[idxScale*events.size() + idxEvent];
+      for ( std::vector<MeasuredTauLepton>::const_iterator measuredTauLepton = event.measuredTauLeptons_.begin();
+            measuredTauLepton != event.measuredTauLeptons_.end(); ++measuredTauLepton ) {
+        scaledEvent.measuredTauLeptons_.push_back(MeasuredTauLepton(
+          measuredTauLepton->type(), scale*measuredTauLepton->pt(), measuredTauLepton->eta(), measuredTauLepton->phi(),
+          measuredTauLepton->mass(), measuredTauLepton->decayMode()));
+      }
+      scaledEvent.measuredMETx_ = scale*event.measuredMETx_;
+      scaledEvent.measuredMETy_ = scale*event.measuredMETy_;
+      scaledEvent.covMET_ = event.covMET_;
+    }
+  }
+  unsigned long numAllocations_scaledEvents = numAllocations;
+  for ( std::vector<TestEvent>::const_iterator event = scaledEvents.begin(); event != scaledEvents.end(); ++event ) {
+    svFitAlgo.integrate(event->measuredTauLeptons_, event->measuredMETx_, event->measuredMETy_, event->covMET_);
+  }
+  numAllocations_scaledEvents = numAllocations - numAllocations_scaledEvents;
+
+  // CV: use different integrator settings for the three decay channels,
+  //     so that the integrator changes between consecutive events
+  ClassicSVfit svFitAlgo_presets(verbosity);
+  svFitAlgo_presets.addLogM_fixed(true, 6.);
+  SVfitIntegratorPresets integratorPresets;
+  for ( size_t idxEvent = 0; idxEvent < events.size(); ++idxEvent ) {
+    SVfitIntegratorSettings integratorSettings;
+    integratorSettings.maxObjFunctionCalls_ = 20000;
+    integratorSettings.fractionBurnin_ = 0.10 + 0.05*idxEvent;
+    integratorPresets.set(getDecayChannelName(events[idxEvent].measuredTauLeptons_), integratorSettings);
+  }
+  svFitAlgo_presets.setIntegratorPresets(integratorPresets);
+  for ( std::vector<TestEvent>::const_iterator event = events.begin(); event != events.end(); ++event ) {
+    svFitAlgo_presets.integrate(event->measuredTauLeptons_, event->measuredMETx_, event->measuredMETy_, event->covMET_);
+  }
+  unsigned long numAllocations_presets = numAllocations;
+  for ( unsigned iPass = 0; iPass < 3; ++iPass ) {
+    for ( std::vector<TestEvent>::const_iterator event = events.begin(); event != events.end(); ++event ) {
+      svFitAlgo_presets.integrate(event->measuredTauLeptons_, event->measuredMETx_, event->measuredMETy_, event->covMET_);
+    }
+  }
+  numAllocations_presets = numAllocations - numAllocations_presets;
+
+  std::cout << "number of heap allocations in 2nd pass = " << numAllocations_2ndPass << " (expected = 0)" << std::endl;
+  if ( numAllocations_2ndPass != 0 ) return 1;
+  std::cout << "number of heap allocations for " << scaledEvents.size() << " events with smaller or larger visible mass = " << numAllocations_scaledEvents
+            << " (expected = 0)" << std::endl;
+  if ( numAllocations_scaledEvents != 0 ) return 1;
+  std::cout << "number of heap allocations for events alternating between decay channels with different integrator settings = "
+            << numAllocations_presets << " (expected = 0)" << std::endl;
+  if ( numAllocations_presets != 0 ) return 1;
+  // results need to be the same when the memory is reused
+  for ( size_t idxEvent = 0; idxEvent < events.size(); ++idxEvent ) {
+    std::cout << "event #" << idxEvent << ": mass = " << mass_1stPass[idxEvent] << " (1st pass), " << mass_2ndPass[idxEvent] << " (2nd pass)" << std::endl;
+    if ( mass_2ndPass[idxEvent] != mass_1stPass[idxEvent] ) return 1;
+  }
+
+  return 0;
+}
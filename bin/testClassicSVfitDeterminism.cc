@@ -0,0 +1,108 @@
+/**
+   \class testClassicSVfitDeterminism testClassicSVfitDeterminism.cc "TauAnalysis/ClassicSVfit/bin/testClassicSVfitDeterminism.cc"
+   \brief Test that the results of ClassicSVfit are bitwise identical when events are processed in parallel
+          by separate ClassicSVfit instances in 1, 8 or 64 threads, and when events are processed in reverse order
+*/
+
+#include "TauAnalysis/ClassicSVfit/interface/ClassicSVfit.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitToyGenerator.h"
+
+#include <TMatrixD.h>
+#include <TROOT.h>
+
+#include <atomic>
+#include <iostream>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+using namespace classic_svFit;
+
+void processEvents(const std::vector<SVfitToyEvent>& events, std::atomic<size_t>& nextEvent, bool useEventSeeding, bool isReversed,
+                   std::vector<SVfitResult>& results)
+{
+  ClassicSVfit svFitAlgo(0);
+  svFitAlgo.addLogM_fixed(true, 6.);
+  svFitAlgo.setMaxObjFunctionCalls(10000);
+  if ( useEventSeeding ) svFitAlgo.enableEventSeeding();
+  TMatrixD covMET(2, 2);
+  while ( true ) {
+    size_t idx = nextEvent++;
+    if ( idx >= events.size() ) break;
+    size_t idxEvent = ( isReversed ) ? events.size() - 1 - idx : idx;
+    const SVfitToyEvent& event = events[idxEvent];
+    covMET[0][0] = event.covMET_.xx_;
+    covMET[0][1] = event.covMET_.xy_;
+    covMET[1][0] = event.covMET_.yx_;
+    covMET[1][1] = event.covMET_.yy_;
+    svFitAlgo.setEventId(event.eventId_);
+    results[idxEvent] = svFitAlgo.integrate(event.measuredTauLeptons_, event.measuredMETx_, event.measuredMETy_, covMET);
+  }
+}
+
+std::vector<SVfitResult> runThreads(const std::vector<SVfitToyEvent>& events, unsigned numThreads, bool useEventSeeding, bool isReversed)
+{
+  std::vector<SVfitResult> results(events.size());
+  std::atomic<size_t> nextEvent(0);
+  std::vector<std::thread> threads;
+  for ( unsigned idxThread = 0; idxThread < numThreads; ++idxThread ) {
+    threads.push_back(std::thread(processEvents, std::cref(events), std::ref(nextEvent), useEventSeeding, isReversed, std::ref(results)));
+  }
+  for ( std::vector<std::thread>::iterator thread = threads.begin(); thread != threads.end(); ++thread ) {
+    thread->join();
+  }
+  return results;
+}
+
+/// compare all results except the computing time bit by bit
+bool isIdentical(const SVfitResult& result1, const SVfitResult& result2)
+{
+  double values1[] = {
+    result1.pt_, result1.ptErr_, result1.eta_, result1.etaErr_, result1.phi_, result1.phiErr_,
+    result1.mass_, result1.massErr_, result1.massLmax_, result1.transverseMass_, result1.transverseMassErr_,
+    result1.integral_, result1.integralErr_, result1.probMax_, result1.acceptanceRate_
+  };
+  double values2[] = {
+    result2.pt_, result2.ptErr_, result2.eta_, result2.etaErr_, result2.phi_, result2.phiErr_,
+    result2.mass_, result2.massErr_, result2.massLmax_, result2.transverseMass_, result2.transverseMassErr_,
+    result2.integral_, result2.integralErr_, result2.probMax_, result2.acceptanceRate_
+  };
+  return ( memcmp(values1, values2, sizeof(values1)) == 0 &&
+           result1.isValidSolution_ == result2.isValidSolution_ &&
+           result1.numIntegrandCalls_ == result2.numIntegrandCalls_ );
+}
+
+int main(int argc, char* argv[])
+{
+  ROOT::EnableThreadSafety();
+
+  // generate events of all decay channels
+  SVfitToyGenerator generator(MeasuredTauLepton::kUndefinedDecayType, MeasuredTauLepton::kUndefinedDecayType, 4357);
+  std::vector<SVfitToyEvent> events(64);
+  for ( std::vector<SVfitToyEvent>::iterator event = events.begin(); event != events.end(); ++event ) {
+    generator.generate(*event);
+  }
+
+  int errorFlag = 0;
+  for ( int useEventSeeding = 0; useEventSeeding <= 1; ++useEventSeeding ) {
+    std::vector<SVfitResult> results_ref = runThreads(events, 1, useEventSeeding, false);
+    unsigned numThreads[] = { 1, 8, 64 };
+    for ( int idxRun = 0; idxRun < 4; ++idxRun ) {
+      bool isReversed = ( idxRun == 3 );
+      unsigned numThreads_run = ( isReversed ) ? 1 : numThreads[idxRun];
+      std::vector<SVfitResult> results = runThreads(events, numThreads_run, useEventSeeding, isReversed);
+      unsigned numDifferences = 0;
+      for ( size_t idxEvent = 0; idxEvent < events.size(); ++idxEvent ) {
+        if ( !isIdentical(results[idxEvent], results_ref[idxEvent]) ) {
+          std::cout << "event #" << idxEvent << ": mass = " << results[idxEvent].mass_ << ", expected = " << results_ref[idxEvent].mass_ << std::endl;
+          ++numDifferences;
+        }
+      }
+      std::cout << "event seeding = " << ( useEventSeeding ? "enabled" : "disabled" ) << ", " << numThreads_run << " thread(s)"
+                << ( isReversed ? ", reverse order" : "" ) << ": " << numDifferences << " events with different results (expected = 0)" << std::endl;
+      if ( numDifferences != 0 ) errorFlag = 1;
+    }
+  }
+
+  return errorFlag;
+}
@@ -0,0 +1,76 @@
+/**
+   \class testClassicSVfitPrecision testClassicSVfitPrecision.cc "TauAnalysis/ClassicSVfit/bin/testClassicSVfitPrecision.cc"
+   \brief Test that ClassicSVfit::integrate extends the sampling of the Markov Chain until the statistical uncertainty of the mass
+          reaches the target precision (cf. ClassicSVfitBase::setPrecision), on events of all decay channels,
+          and that the statistical uncertainty is restored when the result is taken from the result cache
+*/
+
+#include "TauAnalysis/ClassicSVfit/interface/ClassicSVfit.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitHistogramAdapter.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitIntegratorSettings.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitToyGenerator.h"
+
+#include <TMatrixD.h>
+
+#include <iostream>
+#include <vector>
+
+using namespace classic_svFit;
+
+/// median of the mass posterior, to which the target precision refers
+double getMassMedian(const ClassicSVfit& svFitAlgo)
+{
+  std::vector<SVfitQuantity*> quantities;
+  svFitAlgo.getHistogramAdapter()->getBookedQuantities(quantities);
+  for ( std::vector<SVfitQuantity*>::const_iterator quantity = quantities.begin(); quantity != quantities.end(); ++quantity ) {
+    if ( dynamic_cast<const SVfitQuantityDiTauMass*>(*quantity) ) return (*quantity)->getHistogramProperties().xQuantile050_;
+  }
+  return 0.;
+}
+
+int main(int argc, char* argv[])
+{
+  SVfitToyGenerator generator(MeasuredTauLepton::kUndefinedDecayType, MeasuredTauLepton::kUndefinedDecayType, 2203);
+  std::vector<SVfitToyEvent> events(12);
+  for ( std::vector<SVfitToyEvent>::iterator event = events.begin(); event != events.end(); ++event ) {
+    generator.generate(*event);
+  }
+
+  SVfitPrecisionSettings precisionSettings;
+  precisionSettings.targetMassPrecision_ = 2.e-2;
+  precisionSettings.minObjFunctionCalls_ = 10000;
+  precisionSettings.maxObjFunctionCalls_ = 2000000;
+
+  int verbosity = 0;
+  ClassicSVfit svFitAlgo(verbosity);
+  svFitAlgo.addLogM_fixed(true, 6.);
+  svFitAlgo.setPrecision(precisionSettings);
+  svFitAlgo.enableResultCache();
+
+  int errorFlag = 0;
+  TMatrixD covMET(2, 2);
+  for ( size_t idxEvent = 0; idxEvent < events.size(); ++idxEvent ) {
+    const SVfitToyEvent& event = events[idxEvent];
+    covMET[0][0] = event.covMET_.xx_;
+    covMET[0][1] = event.covMET_.xy_;
+    covMET[1][0] = event.covMET_.yx_;
+    covMET[1][1] = event.covMET_.yy_;
+    SVfitResult result = svFitAlgo.integrate(event.measuredTauLeptons_, event.measuredMETx_, event.measuredMETy_, covMET);
+    double massMedian = getMassMedian(svFitAlgo);
+    double targetMassErr = precisionSettings.targetMassPrecision_*massMedian;
+    std::cout << "event #" << idxEvent << " (" << getDecayChannelName(event.measuredTauLeptons_) << "): mass = " << result.mass_
+              << ", median = " << massMedian << ", statistical uncertainty = " << result.massStatErr_ << " (target = " << targetMassErr << "), "
+              << result.numIntegrandCalls_ << " function calls" << std::endl;
+    if ( !result.isValidSolution_ ) continue;
+    // CV: the target refers to the average of the batch medians, which differs slightly from the median of all samples
+    if ( !(result.massStatErr_ > 0. && result.massStatErr_ <= 1.02*targetMassErr) ) errorFlag = 1;
+    if ( !(result.numIntegrandCalls_ < precisionSettings.maxObjFunctionCalls_) ) errorFlag = 1;
+    SVfitResult result_cached = svFitAlgo.integrate(event.measuredTauLeptons_, event.measuredMETx_, event.measuredMETy_, covMET);
+    if ( result_cached.mass_ != result.mass_ || result_cached.massStatErr_ != result.massStatErr_ ) {
+      std::cout << " result cache: mass = " << result_cached.mass_ << ", statistical uncertainty = " << result_cached.massStatErr_ << std::endl;
+      errorFlag = 1;
+    }
+  }
+
+  return errorFlag;
+}
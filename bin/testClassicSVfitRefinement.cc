@@ -0,0 +1,112 @@
+/**
+   \class testClassicSVfitRefinement testClassicSVfitRefinement.cc "TauAnalysis/ClassicSVfit/bin/testClassicSVfitRefinement.cc"
+   \brief Test the two-tier integration (cf. ClassicSVfitBase::enableRefinement):
+          for events whose mass is within the mass window, the refined results are expected to agree with the results of integrations
+          with the full number of function calls, on average over several random number seeds;
+          for events outside the window, the result of the coarse integration is expected to be returned unchanged,
+          with the flag isRefined_ not set
+*/
+
+#include "TauAnalysis/ClassicSVfit/interface/ClassicSVfit.h"
+#include "TauAnalysis/ClassicSVfit/interface/MeasuredTauLepton.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitIntegratorSettings.h"
+
+#include <TMatrixD.h>
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace classic_svFit;
+
+/// integrate event with the random numbers given by the event number
+SVfitResult integrate(unsigned maxObjFunctionCalls, const SVfitRefinementSettings* refinementSettings, unsigned long eventId,
+                      const std::vector<MeasuredTauLepton>& measuredTauLeptons, double measuredMETx, double measuredMETy, const TMatrixD& covMET)
+{
+  ClassicSVfit svFitAlgo(0);
+  svFitAlgo.addLogM_fixed(true, 6.);
+  svFitAlgo.setMaxObjFunctionCalls(maxObjFunctionCalls);
+  if ( refinementSettings ) svFitAlgo.enableRefinement(*refinementSettings);
+  svFitAlgo.enableEventSeeding();
+  svFitAlgo.setEventId(eventId);
+  return svFitAlgo.integrate(measuredTauLeptons, measuredMETx, measuredMETy, covMET);
+}
+
+void printResult(const std::string& label, const SVfitResult& result)
+{
+  std::cout << " " << label << ": mass = " << result.mass_ << " +/- " << result.massErr_ << ", "
+            << result.numIntegrandCalls_ << " function calls (isRefined = " << result.isRefined_ << ")" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+  // define MET
+  double measuredMETx =  11.7491;
+  double measuredMETy = -51.9172;
+
+  // define MET covariance
+  TMatrixD covMET(2, 2);
+  covMET[0][0] =  787.352;
+  covMET[1][0] = -178.63;
+  covMET[0][1] = -178.63;
+  covMET[1][1] =  179.545;
+
+  // define lepton four vectors
+  std::vector<MeasuredTauLepton> measuredTauLeptons;
+  measuredTauLeptons.push_back(MeasuredTauLepton(MeasuredTauLepton::kTauToElecDecay, 33.7393, 0.9409,  -0.541458, 0.51100e-3));
+  measuredTauLeptons.push_back(MeasuredTauLepton(MeasuredTauLepton::kTauToHadDecay,  25.7322, 0.618228, 2.79362,  0.13957, 0));
+
+  const unsigned numObjFunctionCallsCoarse = 10000;
+  const unsigned maxObjFunctionCalls = 100000;
+
+  SVfitRefinementSettings refinementSettings;
+  refinementSettings.numObjFunctionCallsCoarse_ = numObjFunctionCallsCoarse;
+  // CV: refine depending on the mass window only
+  refinementSettings.maxMassStatErr_ = 0.;
+
+  int errorFlag = 0;
+
+  // CV: mass window containing the mass of the event;
+  //     the refined and full integrations differ by statistical fluctuations, which are reduced by averaging over several seeds
+  refinementSettings.massMin_ = 100.;
+  refinementSettings.massMax_ = 150.;
+  std::cout << "mass window = [" << refinementSettings.massMin_ << ", " << refinementSettings.massMax_ << "]:" << std::endl;
+  const unsigned numSeeds = 16;
+  double sumMass_full = 0.;
+  double sumMassErr_full = 0.;
+  double sumMass_inside = 0.;
+  double sumMassErr_inside = 0.;
+  for ( unsigned idxSeed = 0; idxSeed < numSeeds; ++idxSeed ) {
+    SVfitResult result_full = integrate(maxObjFunctionCalls, nullptr, idxSeed, measuredTauLeptons, measuredMETx, measuredMETy, covMET);
+    SVfitResult result_inside = integrate(maxObjFunctionCalls, &refinementSettings, idxSeed, measuredTauLeptons, measuredMETx, measuredMETy, covMET);
+    printResult("full integration", result_full);
+    printResult("refined integration", result_inside);
+    if ( !result_inside.isRefined_ ) errorFlag = 1;
+    if ( !(result_inside.numIntegrandCalls_ >= maxObjFunctionCalls) ) errorFlag = 1;
+    sumMass_full += result_full.mass_;
+    sumMassErr_full += result_full.massErr_;
+    sumMass_inside += result_inside.mass_;
+    sumMassErr_inside += result_inside.massErr_;
+  }
+  // CV: the tolerances are about three times the statistical uncertainties of the differences between the averages,
+  //     estimated from the spread of the results for different seeds
+  std::cout << " average: mass = " << sumMass_inside/numSeeds << " +/- " << sumMassErr_inside/numSeeds << " (refined), "
+            << sumMass_full/numSeeds << " +/- " << sumMassErr_full/numSeeds << " (full)" << std::endl;
+  if ( !(std::fabs(sumMass_inside - sumMass_full) < 0.04*sumMass_full) ) errorFlag = 1;
+  if ( !(std::fabs(sumMassErr_inside - sumMassErr_full) < 0.12*sumMassErr_full) ) errorFlag = 1;
+
+  // CV: mass window far above the mass of the event
+  refinementSettings.massMin_ = 400.;
+  refinementSettings.massMax_ = 500.;
+  SVfitResult result_coarse = integrate(numObjFunctionCallsCoarse, nullptr, 0, measuredTauLeptons, measuredMETx, measuredMETy, covMET);
+  SVfitResult result_outside = integrate(maxObjFunctionCalls, &refinementSettings, 0, measuredTauLeptons, measuredMETx, measuredMETy, covMET);
+  std::cout << "mass window = [" << refinementSettings.massMin_ << ", " << refinementSettings.massMax_ << "]:" << std::endl;
+  printResult("coarse integration", result_coarse);
+  printResult("refined integration", result_outside);
+  // CV: the coarse integration is run with the same random numbers as an integration with the number of function calls of the coarse integration
+  if ( result_outside.isRefined_ ) errorFlag = 1;
+  if ( result_outside.numIntegrandCalls_ != result_coarse.numIntegrandCalls_ ) errorFlag = 1;
+  if ( result_outside.mass_ != result_coarse.mass_ || result_outside.massErr_ != result_coarse.massErr_ ) errorFlag = 1;
+
+  return errorFlag;
+}
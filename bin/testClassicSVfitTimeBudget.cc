@@ -0,0 +1,65 @@
+/**
+   \class testClassicSVfitTimeBudget testClassicSVfitTimeBudget.cc "TauAnalysis/ClassicSVfit/bin/testClassicSVfitTimeBudget.cc"
+   \brief Test that ClassicSVfit::integrate respects a time budget that is much smaller than the time needed
+          for the full number of function calls: the integration is expected to stop after a small fraction of the function calls,
+          with the flag isStoppedByTimeBudget_ set and a valid solution computed from the samples taken so far
+*/
+
+#include "TauAnalysis/ClassicSVfit/interface/ClassicSVfit.h"
+#include "TauAnalysis/ClassicSVfit/interface/MeasuredTauLepton.h"
+
+#include <TMatrixD.h>
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using namespace classic_svFit;
+
+typedef std::chrono::steady_clock Clock;
+
+int main(int argc, char* argv[])
+{
+  // define MET
+  double measuredMETx =  11.7491;
+  double measuredMETy = -51.9172;
+
+  // define MET covariance
+  TMatrixD covMET(2, 2);
+  covMET[0][0] =  787.352;
+  covMET[1][0] = -178.63;
+  covMET[0][1] = -178.63;
+  covMET[1][1] =  179.545;
+
+  // define lepton four vectors
+  std::vector<MeasuredTauLepton> measuredTauLeptons;
+  measuredTauLeptons.push_back(MeasuredTauLepton(MeasuredTauLepton::kTauToElecDecay, 33.7393, 0.9409,  -0.541458, 0.51100e-3));
+  measuredTauLeptons.push_back(MeasuredTauLepton(MeasuredTauLepton::kTauToHadDecay,  25.7322, 0.618228, 2.79362,  0.13957, 0));
+
+  int verbosity = 0;
+  ClassicSVfit svFitAlgo(verbosity);
+  svFitAlgo.addLogM_fixed(true, 6.);
+  svFitAlgo.setMaxObjFunctionCalls(10000000);
+
+  const double timeBudget = 0.01;
+  svFitAlgo.setTimeBudget(timeBudget);
+
+  // CV: the first call books the histograms and initializes the integrator, which is not limited by the time budget
+  svFitAlgo.integrate(measuredTauLeptons, measuredMETx, measuredMETy, covMET);
+
+  Clock::time_point start = Clock::now();
+  SVfitResult result = svFitAlgo.integrate(measuredTauLeptons, measuredMETx, measuredMETy, covMET);
+  double numSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  std::cout << "time budget = " << timeBudget << " s: computing time = " << numSeconds << " s, "
+            << result.numIntegrandCalls_ << " function calls, mass = " << result.mass_ << " +/- " << result.massErr_
+            << " (isStoppedByTimeBudget = " << result.isStoppedByTimeBudget_ << ", isValidSolution = " << result.isValidSolution_ << ")" << std::endl;
+  if ( !result.isStoppedByTimeBudget_ ) return 1;
+  if ( !result.isValidSolution_ || !(result.mass_ > 0.) ) return 1;
+  // CV: the computing time is not checked, as it depends on the load of the machine;
+  //     the number of function calls that fit into the time budget is about a factor 1000 below the maximum on an idle machine,
+  //     so a limit of one tenth of the maximum leaves a generous margin while still requiring that the integration stopped early
+  if ( !(result.numIntegrandCalls_ > 0 && result.numIntegrandCalls_ < 10000000/10) ) return 1;
+
+  return 0;
+}
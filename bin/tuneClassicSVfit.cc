@@ -0,0 +1,238 @@
+/**
+   \class tuneClassicSVfit tuneClassicSVfit.cc "TauAnalysis/ClassicSVfit/bin/tuneClassicSVfit.cc"
+   \brief Determine the number of evaluations of the integrand and the hyperparameters of the Markov Chain integration
+          for each decay channel, on events generated by generateClassicSVfitToyEvents
+
+   For each decay channel, the mass is first reconstructed with a large number of evaluations of the integrand (reference).
+   The number of evaluations is then increased step by step, starting from a small value,
+   and for each number the hyperparameters are varied one at a time, keeping variations that improve the agreement with the reference.
+   The hyperparameters varied are the fraction of "burnin" iterations, the lengths of both phases of the simulated annealing,
+   the initial annealing temperature and its decay, the number of batches and the step-size of the Metropolis moves.
+   The first settings for which the mean and the RMS of the ratio of the reconstructed mass to the reference mass
+   are within the given tolerances are written to the presets file (cf. SVfitIntegratorPresets).
+
+   Usage: tuneClassicSVfit input file output file [maximum number of events per channel] [tolerance on bias] [tolerance on resolution]
+                           [number of evaluations of the integrand for the reference]
+*/
+
+#include "TauAnalysis/ClassicSVfit/interface/ClassicSVfit.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitIntegratorSettings.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitToyGenerator.h"
+
+#include <TMatrixD.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace classic_svFit;
+
+struct TuningSample
+{
+  std::vector<SVfitToyEvent> events_;
+  std::vector<double> refMasses_;
+};
+
+struct Performance
+{
+  double bias_;
+  double resolution_;
+  unsigned long numFailures_;
+  double msPerEvent_;
+};
+
+Performance evaluate(ClassicSVfit& svFitAlgo, const SVfitIntegratorSettings& settings, const std::vector<SVfitToyEvent>& events, std::vector<double>& masses)
+{
+  svFitAlgo.setIntegratorSettings(settings);
+  masses.resize(events.size());
+  TMatrixD covMET(2, 2);
+  double sumSeconds = 0.;
+  Performance performance;
+  performance.numFailures_ = 0;
+  for ( size_t idxEvent = 0; idxEvent < events.size(); ++idxEvent ) {
+    const SVfitToyEvent& event = events[idxEvent];
+    covMET[0][0] = event.covMET_.xx_;
+    covMET[0][1] = event.covMET_.xy_;
+    covMET[1][0] = event.covMET_.yx_;
+    covMET[1][1] = event.covMET_.yy_;
+    SVfitResult result = svFitAlgo.integrate(event.measuredTauLeptons_, event.measuredMETx_, event.measuredMETy_, covMET);
+    sumSeconds += result.numSeconds_real_;
+    masses[idxEvent] = ( result.isValidSolution_ ) ? result.mass_ : -1.;
+    if ( !(masses[idxEvent] > 0.) ) ++performance.numFailures_;
+  }
+  performance.bias_ = 0.;
+  performance.resolution_ = 0.;
+  performance.msPerEvent_ = ( events.size() > 0 ) ? 1.e+3*sumSeconds/events.size() : 0.;
+  return performance;
+}
+
+Performance evaluate(ClassicSVfit& svFitAlgo, const SVfitIntegratorSettings& settings, const TuningSample& sample)
+{
+  std::vector<double> masses;
+  Performance performance = evaluate(svFitAlgo, settings, sample.events_, masses);
+  double sumRatio = 0.;
+  double sumRatio2 = 0.;
+  unsigned long numValid = 0;
+  for ( size_t idxEvent = 0; idxEvent < masses.size(); ++idxEvent ) {
+    if ( !(masses[idxEvent] > 0.) ) continue;
+    double ratio = masses[idxEvent]/sample.refMasses_[idxEvent];
+    sumRatio += ratio;
+    sumRatio2 += ratio*ratio;
+    ++numValid;
+  }
+  double meanRatio = ( numValid > 0 ) ? sumRatio/numValid : 0.;
+  performance.bias_ = meanRatio - 1.;
+  performance.resolution_ = ( numValid > 0 ) ? std::sqrt(std::max(0., sumRatio2/numValid - meanRatio*meanRatio)) : 0.;
+  return performance;
+}
+
+/// compatibility with the reference, normalized such that values below one are within the tolerances
+double compScore(const Performance& performance, double maxBias, double maxResolution)
+{
+  if ( performance.numFailures_ > 0 ) return 1.e+3;
+  return std::max(std::fabs(performance.bias_)/maxBias, performance.resolution_/maxResolution);
+}
+
+void printPerformance(const SVfitIntegratorSettings& settings, const Performance& performance, const std::string& comment)
+{
+  std::cout << std::setw(10) << settings.maxObjFunctionCalls_ << std::setw(8) << settings.fractionBurnin_
+            << std::setw(8) << settings.fractionSimAnnealingPhase1_ << std::setw(8) << settings.fractionSimAnnealingPhase2_
+            << std::setw(6) << settings.T0_ << std::setw(8) << settings.fractionTemperatureDecay_ << std::setw(8) << settings.numBatches_
+            << std::setw(10) << settings.epsilon0_ << std::setw(6) << settings.nu_
+            << std::setw(12) << performance.bias_ << std::setw(12) << performance.resolution_ << std::setw(10) << performance.numFailures_
+            << std::setw(12) << performance.msPerEvent_ << " " << comment << std::endl;
+}
+
+/// values tried for one hyperparameter, while keeping the other hyperparameters fixed
+struct Hyperparameter
+{
+  Hyperparameter(double SVfitIntegratorSettings::* member, const std::vector<double>& values)
+    : member_(member)
+    , member_unsigned_(nullptr)
+    , values_(values)
+  {}
+  Hyperparameter(unsigned SVfitIntegratorSettings::* member, const std::vector<double>& values)
+    : member_(nullptr)
+    , member_unsigned_(member)
+    , values_(values)
+  {}
+  void set(SVfitIntegratorSettings& settings, double value) const
+  {
+    if ( member_ ) settings.*member_ = value;
+    else settings.*member_unsigned_ = static_cast<unsigned>(value);
+  }
+  double SVfitIntegratorSettings::* member_;
+  unsigned SVfitIntegratorSettings::* member_unsigned_;
+  std::vector<double> values_;
+};
+
+int main(int argc, char* argv[])
+{
+  if ( argc < 3 ) {
+    std::cerr << "Usage: tuneClassicSVfit input file output file [maximum number of events per channel] [tolerance on bias] [tolerance on resolution]"
+              << " [number of evaluations of the integrand for the reference]" << std::endl;
+    return 1;
+  }
+  std::string inputFileName = argv[1];
+  std::string outputFileName = argv[2];
+  unsigned long maxEvents = ( argc > 3 ) ? std::atol(argv[3]) : 50;
+  double maxBias = ( argc > 4 ) ? std::atof(argv[4]) : 0.01;
+  double maxResolution = ( argc > 5 ) ? std::atof(argv[5]) : 0.05;
+  unsigned refObjFunctionCalls = ( argc > 6 ) ? std::atoi(argv[6]) : 1000000;
+
+  std::map<std::string, TuningSample> samples;
+  SVfitToyEventReader reader(inputFileName);
+  SVfitToyEvent event;
+  while ( reader.read(event) ) {
+    TuningSample& sample = samples[getDecayChannelName(event.measuredTauLeptons_)];
+    if ( sample.events_.size() < maxEvents ) sample.events_.push_back(event);
+  }
+
+  std::vector<unsigned> maxObjFunctionCalls = { 5000, 10000, 20000, 30000, 50000, 100000, 200000, 500000 };
+  std::vector<Hyperparameter> hyperparameters = {
+    Hyperparameter(&SVfitIntegratorSettings::fractionBurnin_, { 0.05, 0.20 }),
+    Hyperparameter(&SVfitIntegratorSettings::fractionSimAnnealingPhase1_, { 0.10, 0.30 }),
+    Hyperparameter(&SVfitIntegratorSettings::fractionSimAnnealingPhase2_, { 0.40, 0.70 }),
+    Hyperparameter(&SVfitIntegratorSettings::T0_, { 5., 50. }),
+    Hyperparameter(&SVfitIntegratorSettings::fractionTemperatureDecay_, { 0.05, 0.20 }),
+    Hyperparameter(&SVfitIntegratorSettings::numBatches_, { 50., 200. }),
+    Hyperparameter(&SVfitIntegratorSettings::epsilon0_, { 3.e-3, 3.e-2 }),
+    Hyperparameter(&SVfitIntegratorSettings::nu_, { 0.5, 1.0 })
+  };
+
+  ClassicSVfit svFitAlgo(0);
+  svFitAlgo.addLogM_fixed(true, 4.);
+  SVfitIntegratorPresets presets;
+  for ( std::map<std::string, TuningSample>::iterator sample = samples.begin(); sample != samples.end(); ++sample ) {
+    std::cout << "channel = " << sample->first << ": " << sample->second.events_.size() << " events" << std::endl;
+
+//--- reconstruct reference masses; drop events without valid solution
+    SVfitIntegratorSettings refSettings;
+    refSettings.maxObjFunctionCalls_ = refObjFunctionCalls;
+    std::vector<double> refMasses;
+    Performance refPerformance = evaluate(svFitAlgo, refSettings, sample->second.events_, refMasses);
+    std::vector<SVfitToyEvent> events;
+    for ( size_t idxEvent = 0; idxEvent < refMasses.size(); ++idxEvent ) {
+      if ( !(refMasses[idxEvent] > 0.) ) continue;
+      events.push_back(sample->second.events_[idxEvent]);
+      sample->second.refMasses_.push_back(refMasses[idxEvent]);
+    }
+    sample->second.events_ = events;
+    std::cout << " reference: " << refObjFunctionCalls << " calls, " << refPerformance.msPerEvent_ << " ms/event, "
+              << refPerformance.numFailures_ << " events without valid solution dropped" << std::endl;
+    if ( events.empty() ) continue;
+
+    std::cout << std::setw(10) << "calls" << std::setw(8) << "burnin" << std::setw(8) << "phase1" << std::setw(8) << "phase2"
+              << std::setw(6) << "T0" << std::setw(8) << "Tdecay" << std::setw(8) << "batches" << std::setw(10) << "epsilon0" << std::setw(6) << "nu"
+              << std::setw(12) << "bias" << std::setw(12) << "resolution" << std::setw(10) << "failures" << std::setw(12) << "ms/event" << std::endl;
+    bool isTuned = false;
+    SVfitIntegratorSettings bestSettings;
+    for ( std::vector<unsigned>::const_iterator numCalls = maxObjFunctionCalls.begin(); numCalls != maxObjFunctionCalls.end() && !isTuned; ++numCalls ) {
+      bestSettings = SVfitIntegratorSettings();
+      bestSettings.maxObjFunctionCalls_ = *numCalls;
+      Performance bestPerformance = evaluate(svFitAlgo, bestSettings, sample->second);
+      double bestScore = compScore(bestPerformance, maxBias, maxResolution);
+      printPerformance(bestSettings, bestPerformance, "");
+      for ( std::vector<Hyperparameter>::const_iterator hyperparameter = hyperparameters.begin();
+            hyperparameter != hyperparameters.end() && bestScore >= 1.; ++hyperparameter ) {
+        SVfitIntegratorSettings settings = bestSettings;
+        for ( std::vector<double>::const_iterator value = hyperparameter->values_.begin(); value != hyperparameter->values_.end(); ++value ) {
+          hyperparameter->set(settings, *value);
+          // CV: both phases of the simulated annealing need to fit into the "burnin" iterations
+          //    (cf. SVfitIntegratorMarkovChain), with margin for rounding the number of iterations
+          if ( settings.fractionSimAnnealingPhase1_ + settings.fractionSimAnnealingPhase2_ > 0.9 ) continue;
+          Performance performance = evaluate(svFitAlgo, settings, sample->second);
+          double score = compScore(performance, maxBias, maxResolution);
+          printPerformance(settings, performance, "");
+          if ( score < bestScore ) {
+            bestSettings = settings;
+            bestPerformance = performance;
+            bestScore = score;
+          }
+        }
+      }
+      if ( bestScore < 1. ) {
+        printPerformance(bestSettings, bestPerformance, "<-- selected");
+        isTuned = true;
+      }
+    }
+    if ( !isTuned ) {
+      std::cout << " no settings within tolerances, using " << bestSettings.maxObjFunctionCalls_ << " calls" << std::endl;
+    }
+    presets.set(sample->first, bestSettings);
+  }
+
+  std::ofstream outputFile(outputFileName.data());
+  outputFile << "# ClassicSVfit integrator presets, tuned on file = " << inputFileName
+             << " (tolerance on bias = " << maxBias << ", on resolution = " << maxResolution
+             << ", reference = " << refObjFunctionCalls << " calls)" << std::endl;
+  presets.write(outputFile);
+  std::cout << "wrote presets to file = " << outputFileName << std::endl;
+
+  return 0;
+}
@@ -3,7 +3,9 @@
 
 #include "TauAnalysis/ClassicSVfit/interface/ClassicSVfitBase.h"
 #include "TauAnalysis/ClassicSVfit/interface/MeasuredTauLepton.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitBatchMeans.h"
 #include "TauAnalysis/ClassicSVfit/interface/svFitHistogramAdapter.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitHistogramPipeline.h"
 
 class ClassicSVfit : public ClassicSVfitBase
 {
@@ -17,6 +19,10 @@ class ClassicSVfit : public ClassicSVfitBase
   void setHistogramAdapter(classic_svFit::HistogramAdapterDiTau* histogramAdapter);
   classic_svFit::HistogramAdapterDiTau* getHistogramAdapter() const;
 
+  /// enable/disable filling of histograms in a separate thread, in parallel to the Markov Chain sampling (default is disabled)
+  void enablePipelinedFill();
+  void disablePipelinedFill();
+
   /// prepare the integrand
   void prepareIntegrand();
 
@@ -24,21 +30,42 @@ class ClassicSVfit : public ClassicSVfitBase
   void prepareLeptonInput(const std::vector<classic_svFit::MeasuredTauLepton>& measuredTauLeptons);
 
   /// run integration with Markov Chain
-  void integrate(const std::vector<classic_svFit::MeasuredTauLepton>&, double, double, const TMatrixD&);
+  classic_svFit::SVfitResult integrate(const std::vector<classic_svFit::MeasuredTauLepton>&, double, double, const TMatrixD&);
 
  protected:
-  /// initialize Markov Chain integrator class
-  void initializeMCIntegrator();
-
   /// set integration indices and ranges for both legs
   /// when useMassConstraint is true reduce number of
   /// dimension by using the mass contraint
   void setIntegrationParams(bool useDiTauMassConstraint=false);
 
+  void hashInputs(classic_svFit::SVfitHash& hash) const;
+
+  /// check if the coarse integration of the current event needs to be refined (cf. SVfitRefinementSettings)
+  bool isRefinementNeeded() const;
+
+  /// extend the sampling of the Markov Chain until the target precision of the mass is reached,
+  /// or, for refined events without target precision, up to the number of function calls of the decay channel
+  template <typename... Observers>
+  void extendSampling(double& integral, double& integralErr, Observers&... observers);
+
+  /// fill results of the integration, extracted from the histogram adapter
+  void fillResult(double integral, double integralErr, unsigned long numIntegrandCalls, double acceptanceRate, bool isStoppedByTimeBudget,
+                  double massStatErr, bool isRefined);
+
   double diTauMassConstraint_;
 
   /// histograms for evaluation of pT, eta, phi, mass and transverse mass of di-tau system
   mutable classic_svFit::HistogramAdapterDiTau* histogramAdapter_;
+
+  /// batch medians of the mass, for estimating its statistical uncertainty;
+  /// the median is used as it is close to the maximum of the mass posterior reported as result, but can be estimated reliably from one batch.
+  /// The batches are long compared to the autocorrelation of the Markov Chain
+  classic_svFit::SVfitBatchMeans massBatchMeans_;
+  static const unsigned minNumIterPerMassBatch = 1000;
+
+  /// consumer thread for filling histograms
+  bool usePipelinedFill_;
+  classic_svFit::HistogramPipelineDiTau* histogramPipeline_;
 };
 
 #endif
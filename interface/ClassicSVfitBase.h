@@ -4,17 +4,28 @@
 #include "TauAnalysis/ClassicSVfit/interface/ClassicSVfitIntegrand.h"
 #include "TauAnalysis/ClassicSVfit/interface/MeasuredTauLepton.h"
 #include "TauAnalysis/ClassicSVfit/interface/SVfitIntegratorMarkovChain.h"
+#include "TauAnalysis/ClassicSVfit/interface/SVfitChainTreeWriter.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitIntegratorSettings.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitCollinearApproximation.h"
 #ifdef USE_SVFITTF
 #include "TauAnalysis/SVfitTF/interface/HadTauTFBase.h"
 #endif
 #include "TauAnalysis/ClassicSVfit/interface/svFitHistogramAdapter.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitLikelihoodArchive.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitResultCache.h"
+#include "TauAnalysis/ClassicSVfit/interface/SVfitResult.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitProfiler.h"
 
-#include <TBenchmark.h>
 #include <TFile.h>
+#include <TFormula.h>
 #include <TGraphErrors.h>
 #include <TMatrixD.h>
 #include <TMath.h>
 
+#include <map>
+#include <utility>
+#include <vector>
+
 class ClassicSVfitBase
 {
  public:
@@ -43,12 +54,76 @@ class ClassicSVfitBase
   /// number of function calls for Markov Chain integration (default is 100000)
   void setMaxObjFunctionCalls(unsigned maxObjFunctionCalls);
 
-  /// set name of ROOT file to store histograms of di-tau pT, eta, phi, mass and transverse mass
+  /// limit the computing time (in seconds, real time) of the Markov Chain integration of each event (default is 0 = no limit).
+  /// The number of function calls is then reduced to the number that fits into the time budget, up to the number set by setMaxObjFunctionCalls;
+  /// if the time budget is exhausted before, the integration stops with the samples taken so far
+  /// and the flag isStoppedByTimeBudget_ is set in the result
+  void setTimeBudget(double timeBudget);
+
+  /// set number of function calls and hyperparameters of the Markov Chain integration,
+  /// used for all decay channels for which no preset is loaded
+  void setIntegratorSettings(const classic_svFit::SVfitIntegratorSettings& integratorSettings);
+  const classic_svFit::SVfitIntegratorSettings& getIntegratorSettings() const;
+
+  /// choose the number of function calls for each event such that the statistical uncertainty of the median of the mass posterior
+  /// reaches the given target precision (cf. SVfitPrecisionSettings; default is a fixed number of function calls).
+  /// The median is used, as its uncertainty can be estimated from batches of samples, while the mass is taken from the maximum
+  /// of the posterior (cf. SVfitResult::massStatErr_). The settings are given either directly
+  /// or by the name of a preset ("fast", "standard" or "reference"). The first integration of each event uses minObjFunctionCalls_;
+  /// the sampling of the Markov Chain is then extended until the target precision or maxObjFunctionCalls_ is reached.
+  /// Easy events thus need fewer function calls than difficult ones
+  void setPrecision(const classic_svFit::SVfitPrecisionSettings& precisionSettings);
+  void setPrecision(const std::string& presetName);
+  const classic_svFit::SVfitPrecisionSettings& getPrecision() const;
+
+  /// enable/disable two-tier integration (cf. SVfitRefinementSettings; default is disabled):
+  /// each event is integrated with numObjFunctionCallsCoarse_ function calls first; the sampling of the Markov Chain is continued,
+  /// starting from the position reached by the coarse integration, up to the number of function calls set by setMaxObjFunctionCalls
+  /// (or by the presets of the decay channel, or up to the target precision set by setPrecision) only for events
+  /// whose coarse mass posterior overlaps with the mass window or whose mass has a large statistical uncertainty.
+  /// Refined events are flagged by isRefined_ in the result
+  void enableRefinement(const classic_svFit::SVfitRefinementSettings& refinementSettings);
+  void disableRefinement();
+
+  /// load settings of the Markov Chain integration for individual decay channels
+  /// (cf. SVfitIntegratorPresets; the presets can be determined with the tuneClassicSVfit executable)
+  void loadIntegratorPresets(const std::string& presetsFileName);
+  void setIntegratorPresets(const classic_svFit::SVfitIntegratorPresets& integratorPresets);
+
+  /// set name of ROOT file to store histograms of di-tau pT, eta, phi, mass and transverse mass of all events
+  /// (cf. SVfitLikelihoodArchive)
   void setLikelihoodFileName(const std::string& likelihoodFileName);
 
+  /// set identifier of the event processed by the next call to integrate,
+  /// used as key for storing the likelihoods and Markov Chain steps
+  /// (by default, events are numbered consecutively, starting from zero)
+  void setEventId(unsigned long long eventId);
+  /// return identifier of the event processed by the last call to integrate
+  unsigned long long getEventId() const;
+
+  /// enable/disable deriving the seed of the random number generator of the Markov Chain integration from the event identifier
+  /// (default is disabled, i.e. the same seed is used for all events).
+  /// In both cases, the results for an event do not depend on the events processed before,
+  /// so that events processed in parallel by separate ClassicSVfit instances give identical results for any number of threads;
+  /// with event seeding enabled, the event identifiers need to be set by setEventId, as the default numbering depends on the instance
+  void enableEventSeeding();
+  void disableEventSeeding();
+
   /// set name of ROOT file to store Markov Chain steps
   void setTreeFileName(const std::string& treeFileName);
 
+  /// set name of binary file to store Markov Chain steps of all events, recording every n-th step only if thinning > 1
+  /// (cf. SVfitChainRecorder; faster than storing the steps in a ROOT file, which gets overwritten for each event)
+  void setChainFileName(const std::string& chainFileName, unsigned thinning = 1);
+
+  /// enable caching of results for events with the same (rounded) inputs and configuration,
+  /// keeping the results of the capacity most recently used events in memory
+  /// and, if a file name is given, all results in a memory-mapped file that can be reused by subsequent jobs
+  /// (cf. SVfitResultCache). Results are not cached if likelihoods or Markov Chain steps are stored or a time budget is set (default is disabled)
+  void enableResultCache(unsigned long capacity = 10000, const std::string& resultCacheFileName = "");
+  void disableResultCache();
+  const classic_svFit::SVfitResultCache* getResultCache() const;
+
   /// prepare the integrand
   virtual void prepareIntegrand() = 0;
 
@@ -62,10 +137,17 @@ class ClassicSVfitBase
   void clearMET();
 
   /// run integration with Markov Chain
-  virtual void integrate(const std::vector<classic_svFit::MeasuredTauLepton>&, double, double, const TMatrixD&) = 0;
+  virtual classic_svFit::SVfitResult integrate(const std::vector<classic_svFit::MeasuredTauLepton>&, double, double, const TMatrixD&) = 0;
+
+  /// compute visible mass, collinear mass and total transverse mass in closed form, without integration,
+  /// e.g. to run the integration only for events that may pass the final selection (cf. SVfitApproximation::isCompatible)
+  classic_svFit::SVfitApproximation approximate(const std::vector<classic_svFit::MeasuredTauLepton>&, double, double, const TMatrixD&) const;
+
+  /// return results of last call to integrate method
+  const classic_svFit::SVfitResult& getResult() const;
 
   /// return maximum of integrand within integration domain
-  double getProbMax() const { return intAlgo_->getProbMax(); }
+  double getProbMax() const { return probMax_; }
 
   /// return flag indicating if algorithm succeeded to find valid solution
   bool isValidSolution() const;
@@ -74,6 +156,23 @@ class ClassicSVfitBase
   double getComputingTime_cpu() const;
   double getComputingTime_real() const;
 
+  /// enable/disable measurement of the computing time spent in the different stages of the algorithm
+  /// (cf. SVfitProfiler; default is disabled). The total computing time and the counters are always available
+  void enableProfiling();
+  void disableProfiling();
+  /// return timings and counters of the last call to integrate method and summed over all calls
+  const classic_svFit::SVfitProfile& getEventProfile() const;
+  const classic_svFit::SVfitProfile& getProcessProfile() const;
+
+#ifdef USE_REJECTION_COUNTERS
+  /// return number of evaluations of the integrand and of evaluations that returned zero probability, per reason,
+  /// for the last call to integrate method and summed over all calls, separately for each decay channel (e.g. "e_had")
+  const classic_svFit::SVfitRejectionCounts& getEventRejectionCounts() const;
+  const std::map<std::string, classic_svFit::SVfitRejectionCounts>& getProcessRejectionCounts() const;
+  /// print fraction of evaluations that returned zero probability, per reason and decay channel
+  void printRejectionCounts(std::ostream& stream) const;
+#endif
+
  protected:
   ///flag for choosing the integrator class
   bool useCuba_;
@@ -81,9 +180,28 @@ class ClassicSVfitBase
   /// initialize Markov Chain integrator class
   virtual void initializeMCIntegrator();
 
+  /// choose settings of the Markov Chain integration for the decay channel of the current event
+  /// and select the integrator for these settings, which is initialized only if it is not kept from previous events
+  void selectIntegratorSettings();
+
+  /// assign identifier to the event processed by the current call to integrate
+  void startEvent();
+
+  /// return seed of the random number generator for the event processed by the current call to integrate
+  unsigned getSeed() const;
+
+  /// add inputs and configuration to hash used as key for caching results
+  virtual void hashInputs(classic_svFit::SVfitHash& hash) const;
+
+  /// check if results are taken from and stored in the cache
+  bool useResultCache() const;
+
   /// print MET and its covariance matrix
   void printMET(double measuredMETx, double measuredMETy, const TMatrixD& covMET) const;
 
+  /// return name of decay channel of the event processed by the current call to integrate (e.g. "e_had")
+  std::string getChannelName() const;
+
   /// print measured leptons
   void printLeptons() const;
 
@@ -103,10 +221,52 @@ class ClassicSVfitBase
 
   /// interface to Markov Chain integration algorithm
   classic_svFit::SVfitIntegratorMarkovChain* intAlgo_;
-  unsigned maxObjFunctionCalls_;
-  std::string treeFileName_;
+
+  /// integrators for the most recently used settings, most recent first (cf. selectIntegratorSettings)
+  typedef std::pair<classic_svFit::SVfitIntegratorSettings, classic_svFit::SVfitIntegratorMarkovChain*> IntegratorCacheEntry;
+  std::vector<IntegratorCacheEntry> intAlgos_;
+  static const size_t maxNumIntegrators = 16;
+
+  /// settings of the Markov Chain integration for all decay channels, for individual decay channels,
+  /// and for the current event
+  classic_svFit::SVfitIntegratorSettings integratorSettings_;
+  classic_svFit::SVfitIntegratorPresets integratorPresets_;
+  classic_svFit::SVfitIntegratorSettings intAlgoSettings_;
+
+  /// target precision of the mass
+  classic_svFit::SVfitPrecisionSettings precisionSettings_;
+
+  /// settings of the two-tier integration and number of function calls of the refined integration of the current event
+  bool useRefinement_;
+  classic_svFit::SVfitRefinementSettings refinementSettings_;
+  unsigned maxObjFunctionCalls_refined_;
+
+  /// time budget of the Markov Chain integration of each event
+  double timeBudget_;
   std::string likelihoodFileName_;
 
+  /// writer of the Markov Chain steps of each event into a ROOT file
+  std::string treeFileName_;
+  classic_svFit::SVfitChainTreeWriter* chainTreeWriter_;
+
+  /// event identifiers
+  unsigned long long eventId_;
+  unsigned long long nextEventId_;
+
+  /// flag indicating that the seed of the random number generator is derived from the event identifier
+  bool useEventSeeding_;
+
+  /// archive for likelihood histograms
+  classic_svFit::SVfitLikelihoodArchive* likelihoodArchive_;
+
+  /// recorder for Markov Chain steps
+  std::string chainFileName_;
+  unsigned chainThinning_;
+  classic_svFit::SVfitChainRecorder* chainRecorder_;
+
+  /// cache of results
+  classic_svFit::SVfitResultCache* resultCache_;
+
   /// variables indices and ranges for each leg
   std::vector<classic_svFit::integrationParameters> legIntegrationParams_;
   unsigned numDimensions_;
@@ -116,14 +276,28 @@ class ClassicSVfitBase
   /// flag indicating if algorithm succeeded to find valid solution
   bool isValidSolution_;
 
+  /// maximum of integrand within integration domain
+  double probMax_;
+
+  /// results of last call to integrate method
+  classic_svFit::SVfitResult result_;
+
   /// account for resolution on pT of hadronic tau decays via appropriate transfer functions
   bool useHadTauTF_;
 
-  /// clock for measuring run-time of algorithm
-  TBenchmark* clock_;
+  /// formula for the power of the dynamic log(mTauTau) term, evaluated by the integrand
+  TFormula* addLogM_dynamic_formula_;
+
+  /// measurement of run-time of algorithm
+  classic_svFit::SVfitProfiler profiler_;
   double numSeconds_cpu_;
   double numSeconds_real_;
 
+#ifdef USE_REJECTION_COUNTERS
+  /// reasons for which the integrand returned zero probability, summed over all events of each decay channel
+  std::map<std::string, classic_svFit::SVfitRejectionCounts> rejectionCounts_;
+#endif
+
   /// verbosity level
   int verbosity_;
 };
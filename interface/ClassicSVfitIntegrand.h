@@ -4,10 +4,6 @@
 #include "TauAnalysis/ClassicSVfit/interface/ClassicSVfitIntegrandBase.h"
 #include "TauAnalysis/ClassicSVfit/interface/MeasuredTauLepton.h"
 #include "TauAnalysis/ClassicSVfit/interface/FittedTauLepton.h"
-#include "TauAnalysis/ClassicSVfit/interface/svFitHistogramAdapter.h" // HistogramAdapterDiTau
-
-#include <Math/Functor.h>
-#include <TMatrixD.h>
 
 namespace classic_svFit
 {
@@ -19,10 +15,6 @@ namespace classic_svFit
 
     void setDiTauMassConstraint(double diTauMass);
 
-    /// set pointer to histograms used to keep track of pT, eta, phi, mass and transverse mass of di-tau system
-    /// during Markov Chain integration
-    void setHistogramAdapter(HistogramAdapterDiTau* histogramAdapter);
-
     /// set momenta of visible tau decay products
     void setLeptonInputs(const std::vector<classic_svFit::MeasuredTauLepton>&);
 
@@ -33,8 +25,15 @@ namespace classic_svFit
     /// q is given in standarised range [0,1] for each dimension.
     double Eval(const double* q, unsigned int iComponent=0) const;
 
-    /// static pointer to this (needed for interfacing the likelihood function calls to Markov Chain integration)
-    static const ClassicSVfitIntegrand* gSVfitIntegrand;
+    void hashInputs(SVfitHash& hash) const;
+
+    /// four-vectors of the tau leptons at the last point at which the integrand was evaluated with non-zero probability
+    const LorentzVector& getTau1P4() const { return tau1P4_; }
+    const LorentzVector& getTau2P4() const { return tau2P4_; }
+
+    /// static pointer to this (needed for interfacing the likelihood function calls to Markov Chain integration);
+    /// one pointer per thread, so that events can be processed by separate ClassicSVfit instances in different threads
+    static thread_local const ClassicSVfitIntegrand* gSVfitIntegrand;
 
    protected:
     /// momenta of visible tau decay products and of reconstructed tau leptons
@@ -55,7 +54,8 @@ namespace classic_svFit
     double diTauMassConstraint_;
     double diTauMassConstraint2_;
 
-    HistogramAdapterDiTau* histogramAdapter_;
+    mutable LorentzVector tau1P4_;
+    mutable LorentzVector tau2P4_;
   };
 }
 
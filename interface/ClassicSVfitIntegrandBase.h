@@ -6,15 +6,42 @@
 #ifdef USE_SVFITTF
 #include "TauAnalysis/SVfitTF/interface/HadTauTFBase.h"
 #endif
-#include "TauAnalysis/ClassicSVfit/interface/svFitHistogramAdapter.h"
 #include "TauAnalysis/ClassicSVfit/interface/svFitAuxFunctions.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitHash.h"
 
-#include <Math/Functor.h>
-#include <TMatrixD.h>
-#include <TFormula.h>
+#include <functional>
+#include <string>
+#include <vector>
 
 namespace classic_svFit
 {
+  /// number of evaluations of the integrand and of evaluations that returned zero probability, per reason;
+  /// filled only if the code is compiled with USE_REJECTION_COUNTERS defined
+  struct SVfitRejectionCounts
+  {
+    enum Reason {
+      kInitializationError, // wrong number of leptons or MET covariance matrix not invertible
+      kVisPtShift,          // shift of visible tau pT below 1e-2
+      kX1OutOfRange,        // visible energy fraction of first tau outside [1e-5, 1]
+      kX2OutOfRange,        // visible energy fraction of second tau outside [1e-5, 1]
+      kTauDecayParameters,  // no physical solution for neutrino momenta (|cosThetaNu| > 1, cf. FittedTauLepton)
+      kPhaseSpaceFactor,    // outside physical region of tau decay phase-space (cf. compPSfactor_tauToLepDecay/HadDecay)
+      kNaN,                 // product of all factors not a number
+      kSmallProbability,    // product of all factors below 1e-300
+      kNumReasons
+    };
+
+    SVfitRejectionCounts();
+
+    void reset();
+    void add(const SVfitRejectionCounts& counts);
+
+    static const char* getReasonName(int reason);
+
+    unsigned long long numEvaluations_;
+    unsigned long long numRejections_[kNumReasons];
+  };
+
   class ClassicSVfitIntegrandBase
   {
    public:
@@ -27,12 +54,17 @@ namespace classic_svFit
       TauDecayParameters = 0x00001000,
     };
 
+    /// function computing the power of the dynamic log(mTauTau) term for given mTauTau
+    typedef std::function<double(double)> LogMPowerFunction;
+
     ClassicSVfitIntegrandBase(int);
     virtual ~ClassicSVfitIntegrandBase();
 
-    /// add an additional log(mTauTau) term to the nll to suppress high mass tail in mTauTau distribution (default is false)
+    /// add an additional log(mTauTau) term to the nll to suppress high mass tail in mTauTau distribution (default is false);
+    /// the expression for the power of the dynamic term is used for printout and for the hash of the SVfit inputs only,
+    /// while its value is computed by powerFunction
     void addLogM_fixed(bool value, double power = 1.);
-    void addLogM_dynamic(bool value, const std::string& power= "");
+    void addLogM_dynamic(bool value, const std::string& power = "", const LogMPowerFunction& powerFunction = LogMPowerFunction());
 
     void setLegIntegrationParams(unsigned int iLeg, const classic_svFit::integrationParameters& aParams);
 
@@ -57,7 +89,7 @@ namespace classic_svFit
     virtual void setLeptonInputs(const std::vector<classic_svFit::MeasuredTauLepton>&);
 
     /// add MET  estimates, i.e. systematic effect variations
-    void addMETEstimate(double, double, const TMatrixD&);
+    void addMETEstimate(double, double, const Matrix2x2&);
 
     /// remove MET estimates
     void clearMET();
@@ -66,7 +98,7 @@ namespace classic_svFit
     virtual double EvalPS(const double* x) const = 0;
 
     /// evaluate the MET TF part of the integral.
-    double EvalMET_TF(double aMETx, double aMETy, const TMatrixD&) const;
+    double EvalMET_TF(double aMETx, double aMETy, const Matrix2x2&) const;
 
     /// evaluate the MET TF part of the integral using current values of the MET variables
     /// iComponent is ans index to MET estimate, i.e. systamtic effect variation
@@ -82,7 +114,32 @@ namespace classic_svFit
 
     int getMETComponentsSize() const;
 
+    /// add MET estimates and settings of the integrand to hash of the SVfit inputs (cf. SVfitResultCache);
+    /// the transfer functions for hadronic tau decays are not included
+    virtual void hashInputs(SVfitHash& hash) const;
+
+#ifdef USE_REJECTION_COUNTERS
+    /// number of evaluations of the integrand and of evaluations that returned zero probability,
+    /// since the last call to setLeptonInputs
+    const SVfitRejectionCounts& getRejectionCounts() const { return rejectionCounts_; }
+#endif
+
    protected:
+    /// count evaluation of the integrand, or evaluation that returned zero probability for given reason
+    /// (no-ops unless compiled with USE_REJECTION_COUNTERS defined)
+    void countEvaluation() const
+    {
+#ifdef USE_REJECTION_COUNTERS
+      ++rejectionCounts_.numEvaluations_;
+#endif
+    }
+    void countRejection(SVfitRejectionCounts::Reason reason) const
+    {
+#ifdef USE_REJECTION_COUNTERS
+      ++rejectionCounts_.numRejections_[reason];
+#endif
+    }
+
     /// number of tau leptons reconstructed per event
     unsigned numTaus_;
 
@@ -94,7 +151,7 @@ namespace classic_svFit
     std::vector<double> measuredMETy_;
 
     ///MET covariance matrix
-    std::vector<TMatrixD> covMET_;
+    std::vector<Matrix2x2> covMET_;
 
     ///Inverse covariance matix elements
     double invCovMETxx_;
@@ -122,13 +179,18 @@ namespace classic_svFit
     bool addLogM_fixed_;
     double addLogM_fixed_power_;
     bool addLogM_dynamic_;
-    TFormula* addLogM_dynamic_formula_;
+    std::string addLogM_dynamic_power_;
+    LogMPowerFunction addLogM_dynamic_function_;
 
     /// error code that can be passed on
     mutable int errorCode_;
 
     mutable double phaseSpaceComponentCache_;
 
+#ifdef USE_REJECTION_COUNTERS
+    mutable SVfitRejectionCounts rejectionCounts_;
+#endif
+
     /// verbosity level
     int verbosity_;
   };
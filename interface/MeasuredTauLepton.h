@@ -3,6 +3,9 @@
 
 #include "TauAnalysis/ClassicSVfit/interface/svFitAuxFunctions.h" // Vector, LorentzVector
 
+#include <string>
+#include <vector>
+
 namespace classic_svFit
 {
   class MeasuredTauLepton
@@ -121,6 +124,10 @@ namespace classic_svFit
   {
     bool operator() (const MeasuredTauLepton& measuredTauLepton1, const MeasuredTauLepton& measuredTauLepton2);
   };
+
+  /// name of the decay channel given by the decay types of the legs ("prompt", "e", "mu" or "had"), e.g. "mu_had";
+  /// the name does not depend on the order of the legs
+  std::string getDecayChannelName(const std::vector<MeasuredTauLepton>& measuredTauLeptons);
 }
 
 #endif
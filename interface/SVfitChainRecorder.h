@@ -0,0 +1,126 @@
+#ifndef TauAnalysis_ClassicSVfit_SVfitChainRecorder_h
+#define TauAnalysis_ClassicSVfit_SVfitChainRecorder_h
+
+/** \class SVfitChainRecorder
+ *
+ * Records the moves of the Markov Chain for all events processed in a job into a single binary file.
+ *
+ * The moves are written into preallocated in-memory blocks,
+ * which are passed to a background thread for writing once they are full,
+ * so that the recording adds little overhead to the sampling of the Markov Chain.
+ * Optionally, only every n-th move is recorded ("thinning").
+ *
+ * File layout (little-endian, as written by the host):
+ *   file header:  char[8] "SVFITMC1"
+ *   followed by any number of blocks, each consisting of
+ *   block header: uint64 eventId, uint32 numDimensions, uint32 numMoves
+ *   and numMoves records of (2 + numDimensions) 32-bit words:
+ *     uint32 move, float integrand, float x[numDimensions]
+ * The moves of one event may be split into several consecutive blocks.
+ *
+ */
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include <string.h>
+
+namespace classic_svFit
+{
+  class SVfitChainRecorder
+  {
+   public:
+    SVfitChainRecorder(const std::string& fileName, unsigned thinning = 1, unsigned blockSize = 65536, unsigned numBlocks = 4);
+    ~SVfitChainRecorder();
+
+    /// start recording the moves of a new event
+    void beginEvent(uint64_t eventId, unsigned numDimensions);
+
+    /// record move of the Markov Chain (sampling thread only)
+    void record(unsigned move, double integrand, const double* x)
+    {
+      if ( (move % thinning_) != 0 ) return;
+      if ( !currentBlock_ || currentBlock_->numMoves_ == blockSize_ ) nextBlock();
+      char* data = &currentBlock_->data_[currentBlock_->numMoves_*recordSize_];
+      uint32_t move_word = move;
+      memcpy(data, &move_word, sizeof(uint32_t));
+      float integrand_word = integrand;
+      memcpy(data + sizeof(uint32_t), &integrand_word, sizeof(float));
+      for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
+        float x_i = x[iDimension];
+        memcpy(data + (2 + iDimension)*sizeof(float), &x_i, sizeof(float));
+      }
+      ++currentBlock_->numMoves_;
+    }
+
+    /// pass moves recorded for the current event to the writer thread
+    void endEvent();
+
+    static const unsigned maxNumDimensions = 6;
+
+   private:
+    struct Block
+    {
+      uint64_t eventId_;
+      uint32_t numDimensions_;
+      uint32_t numMoves_;
+      std::vector<char> data_;
+    };
+
+    void nextBlock();
+    void write();
+
+    std::ofstream file_;
+    unsigned thinning_;
+    unsigned blockSize_;
+
+    uint64_t eventId_;
+    unsigned numDimensions_;
+    unsigned recordSize_;
+
+    std::vector<Block> blocks_;
+    Block* currentBlock_;
+    std::vector<Block*> freeBlocks_;
+    std::deque<Block*> filledBlocks_;
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool isDone_;
+    std::thread writer_;
+  };
+
+  /// read blocks of Markov Chain moves from files written by SVfitChainRecorder
+  class SVfitChainReader
+  {
+   public:
+    SVfitChainReader(const std::string& fileName);
+
+    bool isValid() const { return isValid_; }
+
+    /// read next block of moves; returns false at end of file
+    bool nextBlock();
+
+    uint64_t getEventId() const { return eventId_; }
+    unsigned getNumDimensions() const { return numDimensions_; }
+    unsigned getNumMoves() const { return numMoves_; }
+
+    unsigned getMove(unsigned idxMove) const;
+    float getIntegrand(unsigned idxMove) const;
+    float getX(unsigned idxMove, unsigned iDimension) const;
+
+   private:
+    std::ifstream file_;
+    bool isValid_;
+    uint64_t eventId_;
+    uint32_t numDimensions_;
+    uint32_t numMoves_;
+    std::vector<char> data_;
+  };
+}
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef TauAnalysis_ClassicSVfit_SVfitChainTreeWriter_h
+#define TauAnalysis_ClassicSVfit_SVfitChainTreeWriter_h
+
+/** \class SVfitChainTreeWriter
+ *
+ * Writes the moves of the Markov Chain into the TTree "tree" of a ROOT file, which is recreated for each integration,
+ * with the branches "x0", "x1", ... for the position of the Markov Chain, "move" and "integrand".
+ * Moves written after the end of the integration, e.g. by SVfitIntegratorMarkovChain::continueIntegration, are ignored.
+ *
+ * Writing the moves into a ROOT file slows down the integration by a large factor;
+ * SVfitChainRecorder records the moves of all events into a single binary file with little overhead.
+ *
+ */
+
+#include "TauAnalysis/ClassicSVfit/interface/SVfitChainWriter.h"
+
+#include <TFile.h>
+#include <TTree.h>
+
+#include <string>
+
+namespace classic_svFit
+{
+  class SVfitChainTreeWriter : public SVfitChainWriter
+  {
+   public:
+    SVfitChainTreeWriter(const std::string& fileName);
+    ~SVfitChainTreeWriter();
+
+    void beginIntegration(unsigned numDimensions, const double* x);
+    void write(unsigned move, double integrand);
+    void endIntegration();
+
+   private:
+    std::string fileName_;
+    TFile* file_;
+    TTree* tree_;
+    int move_;
+    float integrand_;
+  };
+}
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef TauAnalysis_ClassicSVfit_SVfitChainWriter_h
+#define TauAnalysis_ClassicSVfit_SVfitChainWriter_h
+
+/** \class SVfitChainWriter
+ *
+ * Interface for writing the moves of the Markov Chain of each integration into a separate file
+ * (cf. SVfitChainTreeWriter, which writes them into a TTree),
+ * so that the integrator does not depend on the file format.
+ *
+ */
+
+namespace classic_svFit
+{
+  class SVfitChainWriter
+  {
+   public:
+    virtual ~SVfitChainWriter() {}
+
+    /// start writing the moves of a new integration;
+    /// x is the position of the Markov Chain in the integration region, which is updated by the integrator in every move
+    virtual void beginIntegration(unsigned numDimensions, const double* x) = 0;
+
+    /// write move of the Markov Chain, with the current position x and the value of the integrand at this position
+    virtual void write(unsigned move, double integrand) = 0;
+
+    /// finish writing the moves of the integration
+    virtual void endIntegration() = 0;
+  };
+}
+
+#endif
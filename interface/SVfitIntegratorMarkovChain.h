@@ -16,21 +16,38 @@
  *
  */
 
-#include <Math/Functor.h>
-#include <TRandom3.h>
-#include <TFile.h>
-#include <TTree.h>
+#include "TauAnalysis/ClassicSVfit/interface/SVfitChainRecorder.h"
+#include "TauAnalysis/ClassicSVfit/interface/SVfitChainWriter.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitAuxFunctions.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitProfiler.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitRandom.h"
 
+#include <Math/Functor.h> // CV: header-only, like the ROOT::Math vector classes
+
+#include <chrono>
 #include <vector>
 #include <string>
 #include <iostream>
 
 namespace classic_svFit
 {
+  /// current state of the Markov Chain, passed to the observers given to SVfitIntegratorMarkovChain::integrate
+  struct MarkovChainState
+  {
+    const double* q_;         // position in the unit hypercube
+    const double* x_;         // position in the integration region
+    unsigned numDimensions_;
+    double prob_;             // value of the integrand at the current position
+    bool isAccepted_;         // flag indicating whether the last proposed move was accepted
+    bool isBurnin_;           // flag indicating "burnin" iterations (evaluated after the simulated annealing only)
+    const LorentzVector* tau1P4_; // four-vectors of the tau leptons computed by the last evaluation of the integrand
+    const LorentzVector* tau2P4_; // (nullptr unless set by SVfitIntegratorMarkovChain::setTauP4s)
+  };
+
   class SVfitIntegratorMarkovChain
   {
    public:
-    SVfitIntegratorMarkovChain(const std::string&, unsigned, unsigned, unsigned, unsigned, double, double, unsigned, unsigned, double, double, const std::string&, int = 0);
+    SVfitIntegratorMarkovChain(const std::string&, unsigned, unsigned, unsigned, unsigned, double, double, unsigned, unsigned, double, double, int = 0);
     ~SVfitIntegratorMarkovChain();
 
     /// set initial position of Markov Chain in N-dimensional space to given values,
@@ -49,18 +66,141 @@ namespace classic_svFit
     /// N-dimensional space in which the integration is performed.
     void registerCallBackFunction(const ROOT::Math::Functor&);
 
+    /// register "call-back" functions evaluated in the iterations of the "burnin" stage
+    /// that follow the simulated annealing, e.g. to learn the range of observables prior to sampling.
+    /// The argument x is the current position of the Markov Chain, as for the functions registered by registerCallBackFunction
+    void registerBurninCallBackFunction(const ROOT::Math::Functor&);
+
+    /// enable/disable passing the state of the Markov Chain to the observers in the "burnin" iterations that follow the simulated annealing
+    /// (default is enabled); disable it if none of the observers uses these iterations, in order to save their evaluation
+    void setObserveBurnin(bool observeBurnin) { observeBurnin_ = observeBurnin; }
+
+    /// set the four-vectors of the tau leptons that the integrand updates in each evaluation,
+    /// in order to pass them to the observers in the state of the Markov Chain; the four-vectors are not owned by the integrator
+    void setTauP4s(const LorentzVector* tau1P4, const LorentzVector* tau2P4)
+    {
+      tau1P4_ = tau1P4;
+      tau2P4_ = tau2P4;
+    }
+
     /// compute integral of function g
     /// the points xl and xh represent the lower left and upper right corner of a Hypercube in d-dimensional integration space
     typedef double (*gPtr_C)(const double*, size_t, void*);
     void integrate(gPtr_C g, const double* xl, const double* xu, unsigned d, double& integral, double& integralErr);
 
+    /// compute integral of function g and pass the state of the Markov Chain to the given observers
+    /// in every iteration, by calling observer(const MarkovChainState&).
+    /// In contrast to the "call-back" functions, the observers are resolved at compile time,
+    /// so that their evaluation can be inlined into the sampling loop.
+    /// Registered "call-back" functions are evaluated in addition to the observers
+    template <typename... Observers>
+    void integrate(gPtr_C g, const double* xl, const double* xu, unsigned d, double& integral, double& integralErr, Observers&... observers);
+
+    /// continue the sampling of the last Markov Chain of the previous integration that found a valid start-position from its current position
+    /// by the given number of iterations, rounded up to a multiple of the number of iterations per batch,
+    /// and recompute the integral and its uncertainty including the additional batches.
+    /// The observers are evaluated in every additional iteration, as in the integrate method.
+    /// Nothing is done if the previous integration did not find a valid start-position or was stopped by the time budget.
+    /// The additional iterations are recorded by the chain recorder, but not written by the chain writer
+    template <typename... Observers>
+    void continueIntegration(unsigned numIterSampling, double& integral, double& integralErr, Observers&... observers);
+
+    /// record the moves of the Markov Chain for all subsequent integrations;
+    /// the recorder is not owned by the integrator
+    void setChainRecorder(SVfitChainRecorder* chainRecorder) { chainRecorder_ = chainRecorder; }
+
+    /// write the moves of the Markov Chain of each subsequent integration into a separate file, e.g. a TTree (cf. SVfitChainTreeWriter);
+    /// the writer is not owned by the integrator
+    void setChainWriter(SVfitChainWriter* chainWriter) { chainWriter_ = chainWriter; }
+
+    /// set identifier of the event processed by the next integration
+    /// (by default, integrations are numbered consecutively, starting from zero)
+    void setEventId(unsigned long long eventId) { eventId_ = eventId; }
+
+    /// set seed of the random number generator, which is reset to this seed at the start of each integration,
+    /// in order to make integration results independent of processing history (default is 12345).
+    /// The Markov Chains run within one integration use streams of random numbers derived from the seed and the index of the chain
+    void setSeed(unsigned seed) { seed_ = seed; }
+
+    /// stop each integration when the given computing time (in seconds, real time) has elapsed since its start (default is 0 = no limit).
+    /// The numbers of iterations given to the constructor are then the maximum numbers of iterations:
+    /// they get scaled down to the number of iterations that fit into the time budget, estimated from the computing time of the first iterations,
+    /// and the sampling stops when the time budget is exhausted, checked every numIterTimeCheck iterations
+    /// and before the sampling starts. The "burnin" stops when half of the time budget is exhausted, so that samples can still be taken
+    void setTimeBudget(double timeBudget) { timeBudget_ = timeBudget; }
+    static const unsigned numIterTimeCheck = 256;
+
+    /// set the time from which the time budget of the next integration is counted, e.g. the start of the processing of the event,
+    /// so that the time spent preparing the integration is included (by default, the time budget is counted from the start of the integration)
+    typedef std::chrono::steady_clock Clock;
+    void setStartTime(Clock::time_point startTime)
+    {
+      startTime_ = startTime;
+      isStartTimeSet_ = true;
+    }
+
+    /// flag indicating that the last integration was ended by the time budget, i.e. with fewer than the maximum numbers of iterations
+    bool isStoppedByTimeBudget() const { return ( isStoppedByTimeBudget_ || numIterBurnin_ < numIterBurnin_max_ || numIterSampling_ < numIterSampling_max_ ); }
+
+    /// measure time spent in the stages of all subsequent integrations
+    /// (pass nullptr to disable the measurement); the profiler is not owned by the integrator
+    void setProfiler(SVfitProfiler* profiler) { profiler_ = profiler; }
+
     double getProbMax() const { return probMax_; }
 
+    /// number of sampling iterations per batch (before the numbers of iterations get scaled to the time budget)
+    unsigned getNumIterPerBatch() const { return numIterSampling_max_/numBatches_; }
+
+    /// number of evaluations of the integrand and fraction of accepted moves during the sampling stage of the last integration
+    unsigned long getNumIntegrandCalls() const { return numIntegrandCalls_; }
+    double getAcceptanceRate() const
+    {
+      long numMoves = numMoves_accepted_ + numMoves_rejected_;
+      return ( numMoves > 0 ) ? (double)numMoves_accepted_/numMoves : 0.;
+    }
+
+    /// number of evaluations of the integrand that returned zero probability,
+    /// number of failed attempts to find a valid start-position
+    /// and number of accepted and rejected moves during the sampling stage of the last integration
+    unsigned long getNumIntegrandCalls_zeroProb() const { return numIntegrandCalls_zeroProb_; }
+    unsigned long getNumStartPositionRetries() const { return numStartPositionRetries_; }
+    long getNumMovesAccepted() const { return numMoves_accepted_; }
+    long getNumMovesRejected() const { return numMoves_rejected_; }
+
     void print(std::ostream&) const;
 
   protected:
     void setIntegrand(gPtr_C, const double*, const double*, unsigned);
 
+    /// auxiliary functions for the different stages of the integration
+    void startIntegration(gPtr_C, const double*, const double*, unsigned);
+    bool startChain();
+    void makeValidStochasticMove(unsigned, bool&);
+    void startRandomStream(unsigned);
+    bool checkTimeBudget_burnin(unsigned);
+    bool checkTimeBudget();
+    void evalCallBackFunctions(const std::vector<const ROOT::Math::Functor*>&) const;
+    void recordSample(unsigned, bool, unsigned&);
+    void compIntegral(double&, double&);
+    void finishIntegration(double&, double&);
+    void finishContinuation(double&, double&, long, long);
+
+    /// switch profiler to the stage of the simulated annealing or "burnin" iterations that starts at given move
+    void setBurninStage(unsigned iMove)
+    {
+      if      ( iMove == 0                               ) profiler_->setStage(SVfitProfile::kAnnealingPhase1);
+      else if ( iMove == numIterSimAnnealingPhase1_      ) profiler_->setStage(SVfitProfile::kAnnealingPhase2);
+      else if ( iMove == numIterSimAnnealingPhase1plus2_ ) profiler_->setStage(SVfitProfile::kBurnin);
+    }
+
+    template <typename... Observers>
+    static void notifyObservers(const MarkovChainState& state, Observers&... observers)
+    {
+      // CV: expand the parameter pack in an array initializer, in order to call the observers in the order given
+      int dummy[] = { 0, (observers(state), 0)... };
+      (void)dummy;
+    }
+
     void initializeStartPosition_and_Momentum();
 
     void makeStochasticMove(unsigned, bool&, bool&);
@@ -80,6 +220,7 @@ namespace classic_svFit
     ///  initMode:      flag indicating how initial position of Markov Chain is chosen (uniform/Gaus distribution)
     unsigned numDimensions_;
     double* x_;
+    unsigned x_size_;
     std::vector<double> xMin_; // index = dimension
     std::vector<double> xMax_; // index = dimension
     int initMode_;
@@ -93,6 +234,15 @@ namespace classic_svFit
     unsigned numIterBurnin_;
     unsigned numIterSampling_;
 
+    /// maximum numbers of iterations, as given to the constructor (the numbers of iterations of an integration may be scaled down to fit into the time budget),
+    /// number of batches completed and number of sampling iterations of the last chain
+    unsigned numIterBurnin_max_;
+    unsigned numIterSampling_max_;
+    unsigned numIterSimAnnealingPhase1_max_;
+    unsigned numIterSimAnnealingPhase2_max_;
+    unsigned numBatchesCompleted_;
+    unsigned numIterSampling_done_;
+
     // maximum number of attempts to find a valid starting-position for the Markov Chain
     // (i.e. an initial point of non-zero probability)
     unsigned maxCallsStartingPos_;
@@ -108,6 +258,7 @@ namespace classic_svFit
     double sqrtT0_;
     double alpha_;
     double alpha2_;
+    double alpha_max_;
 
     /// number of Markov Chains run in parallel
     unsigned numChains_;
@@ -127,7 +278,8 @@ namespace classic_svFit
     double nu_;
 
     /// random number generator
-    TRandom3 rnd_;
+    SVfitRandom rnd_;
+    unsigned seed_;
 
     /// internal variables storing current state of Markov Chain
     vdouble p_;
@@ -135,6 +287,10 @@ namespace classic_svFit
     vdouble gradE_;
     double prob_;
 
+    /// position and value of the integrand reached by the last Markov Chain that found a valid start-position
+    vdouble qLastChain_;
+    double probLastChain_;
+
     /// temporary variables used for computations
     vdouble u_;
     vdouble pProposal_;
@@ -146,6 +302,10 @@ namespace classic_svFit
     long numMoves_accepted_;
     long numMoves_rejected_;
 
+    unsigned long numIntegrandCalls_;
+    unsigned long numIntegrandCalls_zeroProb_;
+    unsigned long numStartPositionRetries_;
+
     unsigned numChainsRun_;
 
     long numIntegrationCalls_;
@@ -157,15 +317,146 @@ namespace classic_svFit
     int errorFlag_;
 
     std::vector<const ROOT::Math::Functor*> callBackFunctions_;
+    std::vector<const ROOT::Math::Functor*> burninCallBackFunctions_;
+    bool observeBurnin_;
+
+    const LorentzVector* tau1P4_;
+    const LorentzVector* tau2P4_;
 
-    std::string treeFileName_;
-    TFile* treeFile_;
-    TTree* tree_;
-    int treeMove_;
-    float treeIntegrand_;
+    SVfitChainRecorder* chainRecorder_;
+    SVfitChainWriter* chainWriter_;
+    unsigned long long eventId_;
+
+    SVfitProfiler* profiler_;
+
+    /// time budget of each integration and start time of the current integration
+    double timeBudget_;
+    Clock::time_point startTime_;
+    bool isStartTimeSet_;
+    bool isStoppedByTimeBudget_;
 
     int verbosity_; // flag to enable/disable debug output
   };
+
+  template <typename... Observers>
+  void SVfitIntegratorMarkovChain::integrate(gPtr_C g, const double* xl, const double* xu, unsigned d, double& integral, double& integralErr, Observers&... observers)
+  {
+    startIntegration(g, xl, xu, d);
+
+    MarkovChainState state;
+    state.q_ = q_.data();
+    state.x_ = x_;
+    state.numDimensions_ = numDimensions_;
+    state.tau1P4_ = tau1P4_;
+    state.tau2P4_ = tau2P4_;
+
+    for ( unsigned iChain = 0; iChain < numChains_; ++iChain ) {
+      if ( profiler_ ) profiler_->setStage(SVfitProfile::kStartPosition);
+      startRandomStream(iChain);
+      if ( !startChain() ) {
+        if ( isStoppedByTimeBudget_ ) break;
+        continue;
+      }
+
+      state.isBurnin_ = true;
+      for ( unsigned iMove = 0; iMove < numIterBurnin_; ++iMove ) {
+        if ( timeBudget_ > 0. && (iMove % numIterTimeCheck) == 0 && !checkTimeBudget_burnin(iMove) ) break;
+        if ( profiler_ ) setBurninStage(iMove);
+        bool isAccepted = false;
+        makeValidStochasticMove(iMove, isAccepted);
+        if ( iMove >= numIterSimAnnealingPhase1plus2_ && ((observeBurnin_ && sizeof...(Observers) > 0) || !burninCallBackFunctions_.empty()) ) {
+          if ( profiler_ ) profiler_->setStage(SVfitProfile::kHistogramFill);
+          updateX(q_);
+          state.prob_ = prob_;
+          state.isAccepted_ = isAccepted;
+          if ( observeBurnin_ ) notifyObservers(state, observers...);
+          evalCallBackFunctions(burninCallBackFunctions_);
+          if ( profiler_ ) profiler_->setStage(SVfitProfile::kBurnin);
+        }
+      }
+
+      unsigned idxBatch = iChain*numBatches_;
+
+      state.isBurnin_ = false;
+      unsigned iMove = 0;
+      for ( ; iMove < numIterSampling_; ++iMove ) {
+        // CV: the time budget is checked also before the first move, in case it got exhausted by the "burnin"
+        if ( timeBudget_ > 0. && (iMove % numIterTimeCheck) == 0 && !checkTimeBudget() ) break;
+//--- propose Markov Chain transition to new, randomly chosen, point;
+//    evaluate observers and "call-back" functions at this point
+        if ( profiler_ ) profiler_->setStage(SVfitProfile::kSampling);
+        bool isAccepted = false;
+        makeValidStochasticMove(numIterBurnin_ + iMove, isAccepted);
+        recordSample(iMove, isAccepted, idxBatch);
+        if ( profiler_ ) profiler_->setStage(SVfitProfile::kHistogramFill);
+        state.prob_ = prob_;
+        state.isAccepted_ = isAccepted;
+        notifyObservers(state, observers...);
+        evalCallBackFunctions(callBackFunctions_);
+      }
+      numIterSampling_done_ = iMove;
+      numBatchesCompleted_ = iChain*numBatches_ + iMove/(numIterSampling_/numBatches_);
+      // CV: keep the position reached by this chain, from which continueIntegration resumes the sampling,
+      //     as the following chains may fail to find a valid start-position
+      qLastChain_ = q_;
+      probLastChain_ = prob_;
+
+      ++numChainsRun_;
+      if ( isStoppedByTimeBudget_ ) break;
+    }
+
+    if ( profiler_ ) profiler_->setStage(SVfitProfile::kExtractStatistics);
+    finishIntegration(integral, integralErr);
+  }
+
+  template <typename... Observers>
+  void SVfitIntegratorMarkovChain::continueIntegration(unsigned numIterSampling, double& integral, double& integralErr, Observers&... observers)
+  {
+    if ( numChainsRun_ == 0 || isStoppedByTimeBudget_ ) return;
+    q_ = qLastChain_;
+    prob_ = probLastChain_;
+
+    unsigned m = numIterSampling_/numBatches_;
+    unsigned numBatches = (numIterSampling + m - 1)/m;
+    if ( numBatches == 0 ) return;
+    unsigned idxBatch = probSum_.size() - 1;
+    probSum_.resize(probSum_.size() + numBatches, 0.);
+    integral_.resize(probSum_.size());
+    long numMoves_accepted = numMoves_accepted_;
+    long numMoves_rejected = numMoves_rejected_;
+
+    MarkovChainState state;
+    state.q_ = q_.data();
+    state.x_ = x_;
+    state.numDimensions_ = numDimensions_;
+    state.tau1P4_ = tau1P4_;
+    state.tau2P4_ = tau2P4_;
+    state.isBurnin_ = false;
+
+//--- continue the move counter of the last chain, so that batches are completed after every m moves
+    unsigned iMove = numIterSampling_done_;
+    unsigned iMove_end = iMove + numBatches*m;
+    for ( ; iMove < iMove_end; ++iMove ) {
+      if ( timeBudget_ > 0. && (iMove % m) == 0 && !checkTimeBudget() ) break;
+      if ( profiler_ ) profiler_->setStage(SVfitProfile::kSampling);
+      bool isAccepted = false;
+      makeValidStochasticMove(numIterBurnin_ + iMove, isAccepted);
+      recordSample(iMove, isAccepted, idxBatch);
+      if ( profiler_ ) profiler_->setStage(SVfitProfile::kHistogramFill);
+      state.prob_ = prob_;
+      state.isAccepted_ = isAccepted;
+      notifyObservers(state, observers...);
+      evalCallBackFunctions(callBackFunctions_);
+    }
+    numIterSampling_done_ = iMove;
+    // CV: if the time budget was exhausted, drop the batches that were not started
+    probSum_.resize(idxBatch + 1);
+    integral_.resize(idxBatch + 1);
+    numBatchesCompleted_ = probSum_.size();
+
+    if ( profiler_ ) profiler_->setStage(SVfitProfile::kExtractStatistics);
+    finishContinuation(integral, integralErr, numMoves_accepted, numMoves_rejected);
+  }
 }
 
 #endif
@@ -0,0 +1,87 @@
+#ifndef TauAnalysis_ClassicSVfit_SVfitResult_h
+#define TauAnalysis_ClassicSVfit_SVfitResult_h
+
+/** \class SVfitResult
+ *
+ * Results of the SVfit algorithm for one event,
+ * filled once at the end of the integration and returned by value by ClassicSVfit::integrate.
+ *
+ * The struct contains only plain values with default member initializers, and no user-declared constructor,
+ * so that it can be copied and written to files as a whole (cf. the static_assert below).
+ * The four-vectors of the tau leptons are stored as arrays of doubles, cf. getTau1P4 and getTau2P4,
+ * and the flags are grouped at the end, so that there is no padding between the members.
+ * Values of observables that are not selected in the histogram adapter are zero.
+ *
+ */
+
+#include "TauAnalysis/ClassicSVfit/interface/svFitAuxFunctions.h" // LorentzVector
+
+#include <type_traits>
+
+namespace classic_svFit
+{
+  struct SVfitResult
+  {
+    /// pT, eta, phi, mass and transverse mass of di-tau system:
+    /// value, uncertainty and maximum of the likelihood
+    double pt_ = 0.;
+    double ptErr_ = 0.;
+    double ptLmax_ = 0.;
+    double eta_ = 0.;
+    double etaErr_ = 0.;
+    double etaLmax_ = 0.;
+    double phi_ = 0.;
+    double phiErr_ = 0.;
+    double phiLmax_ = 0.;
+    double mass_ = 0.;
+    double massErr_ = 0.;
+    double massLmax_ = 0.;
+    /// statistical uncertainty of the median of the mass posterior, estimated from batch medians of the Markov Chain samples
+    /// (computed only if a target precision is set, cf. ClassicSVfitBase::setPrecision,
+    /// or if the refinement uses the statistical uncertainty, cf. SVfitRefinementSettings::maxMassStatErr_, otherwise zero).
+    /// Note that mass_ is the maximum of the mass posterior, not its median: massStatErr_ indicates the statistical precision
+    /// of the sampled posterior distribution, it is not the statistical uncertainty of mass_
+    double massStatErr_ = 0.;
+    double transverseMass_ = 0.;
+    double transverseMassErr_ = 0.;
+    double transverseMassLmax_ = 0.;
+
+    /// four-vectors of the two tau leptons: px, py, pz and energy
+    double tau1P4_[4] = { 0., 0., 0., 0. };
+    double tau2P4_[4] = { 0., 0., 0., 0. };
+    LorentzVector getTau1P4() const { return LorentzVector(tau1P4_[0], tau1P4_[1], tau1P4_[2], tau1P4_[3]); }
+    LorentzVector getTau2P4() const { return LorentzVector(tau2P4_[0], tau2P4_[1], tau2P4_[2], tau2P4_[3]); }
+
+    /// integral of the likelihood function and its uncertainty
+    double integral_ = 0.;
+    double integralErr_ = 0.;
+
+    /// maximum of integrand within integration domain
+    double probMax_ = 0.;
+
+    /// fraction of accepted moves of the Markov Chain
+    double acceptanceRate_ = 0.;
+
+    /// computing time (in seconds)
+    double numSeconds_cpu_ = -1.;
+    double numSeconds_real_ = -1.;
+
+    /// number of evaluations of the integrand (zero if the result was taken from SVfitResultCache)
+    unsigned long numIntegrandCalls_ = 0;
+
+    /// flag indicating if algorithm succeeded to find valid solution
+    bool isValidSolution_ = false;
+
+    /// flag indicating that the integration was ended by the time budget (cf. ClassicSVfitBase::setTimeBudget)
+    /// rather than after the number of evaluations of the integrand given by setMaxObjFunctionCalls
+    bool isStoppedByTimeBudget_ = false;
+
+    /// flag indicating that the sampling was continued after the coarse integration (cf. ClassicSVfitBase::enableRefinement)
+    bool isRefined_ = false;
+  };
+
+  static_assert(std::is_trivially_copyable<SVfitResult>::value && std::is_standard_layout<SVfitResult>::value,
+                "SVfitResult needs to be copyable as a whole");
+}
+
+#endif
@@ -1,13 +1,15 @@
 #ifndef TauAnalysis_ClassicSVfit_svFitAuxFunctions_h
 #define TauAnalysis_ClassicSVfit_svFitAuxFunctions_h
 
-#include <TGraphErrors.h>
 #include "Math/LorentzVector.h"
 #include "Math/Vector3D.h"
 
+#include <cmath>
 #include <vector>
 #include <string>
 
+class TGraphErrors;
+
 namespace classic_svFit
 {
   inline double square(double x)
@@ -106,6 +108,35 @@ namespace classic_svFit
   */
   typedef ROOT::Math::LorentzVector<ROOT::Math::PxPyPzE4D<double> > LorentzVector;
 
+  /// mass of the given four-vector, negative for space-like four-vectors, as LorentzVector::mass();
+  /// computed without the check for negative mass-squared of LorentzVector::mass(), which needs the GenVector library
+  inline double compMass(const LorentzVector& p4)
+  {
+    double mass2 = p4.M2();
+    return ( mass2 >= 0. ) ? std::sqrt(mass2) : -std::sqrt(-mass2);
+  }
+
+  /// four-vector with given pT, eta, phi and mass, as TLorentzVector::SetPtEtaPhiM
+  LorentzVector makeP4_PtEtaPhiM(double pt, double eta, double phi, double mass);
+
+  /**
+     \struct Matrix2x2
+     \brief  2x2 matrix with elements xx_, xy_ (first row) and yx_, yy_ (second row), used for the MET covariance
+  */
+  struct Matrix2x2
+  {
+    Matrix2x2(double xx = 0., double xy = 0., double yx = 0., double yy = 0.)
+      : xx_(xx)
+      , xy_(xy)
+      , yx_(yx)
+      , yy_(yy)
+    {}
+    double xx_;
+    double xy_;
+    double yx_;
+    double yy_;
+  };
+
   double roundToNdigits(double, int = 3);
 
   struct GraphPoint
@@ -116,6 +147,7 @@ namespace classic_svFit
     double yErr_;
     double mTest_step_;
   };
+  /// CV: makeGraph and extractResult are defined in svFitAuxFunctionsROOT.cc, as they need the ROOT libraries
   TGraphErrors* makeGraph(const std::string&, const std::vector<GraphPoint>&);
 
   void extractResult(TGraphErrors*, double&, double&, double&, int = 0);
@@ -0,0 +1,102 @@
+#ifndef TauAnalysis_ClassicSVfit_svFitBatchMeans_h
+#define TauAnalysis_ClassicSVfit_svFitBatchMeans_h
+
+/** \class SVfitBatchMeans
+ *
+ * Estimate of a quantity sampled by the Markov Chain and of its statistical uncertainty,
+ * computed from the estimates of consecutive batches of samples, according to eqs. (6.39) and (6.40) in
+ *  "Probabilistic Inference Using Markov Chain Monte Carlo Methods",
+ *  R. Neal, http://www.cs.toronto.edu/pub/radford/review.pdf
+ *
+ * The estimate of each batch is either the mean or the median of the samples in the batch.
+ * The batches need to be long compared to the autocorrelation of the Markov Chain.
+ * Only completed batches enter the estimate and its uncertainty.
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace classic_svFit
+{
+  class SVfitBatchMeans
+  {
+   public:
+    enum Statistic { kMean, kMedian };
+
+    SVfitBatchMeans(Statistic statistic = kMean)
+      : statistic_(statistic)
+      , batchSize_(1)
+      , numValues_(0)
+      , batchSum_(0.)
+    {}
+
+    /// remove all samples and set the number of samples per batch;
+    /// the memory for the batch estimates and the samples of the current batch is kept and reused for subsequent events
+    void reset(unsigned long batchSize)
+    {
+      batchSize_ = ( batchSize > 0 ) ? batchSize : 1;
+      numValues_ = 0;
+      batchSum_ = 0.;
+      batchValues_.clear();
+      if ( statistic_ == kMedian ) batchValues_.reserve(batchSize_);
+      batchMeans_.clear();
+    }
+
+    void fill(double value)
+    {
+      if ( statistic_ == kMedian ) batchValues_.push_back(value);
+      else batchSum_ += value;
+      ++numValues_;
+      if ( (numValues_ % batchSize_) == 0 ) {
+        if ( statistic_ == kMedian ) {
+          std::vector<double>::iterator median = batchValues_.begin() + batchValues_.size()/2;
+          std::nth_element(batchValues_.begin(), median, batchValues_.end());
+          batchMeans_.push_back(*median);
+          batchValues_.clear();
+        } else {
+          batchMeans_.push_back(batchSum_/batchSize_);
+          batchSum_ = 0.;
+        }
+      }
+    }
+
+    unsigned long getNumValues() const { return numValues_; }
+    unsigned long getNumBatches() const { return batchMeans_.size(); }
+
+    /// average of the batch estimates
+    double getMean() const
+    {
+      if ( batchMeans_.empty() ) return 0.;
+      double sum = 0.;
+      for ( std::vector<double>::const_iterator batchMean = batchMeans_.begin(); batchMean != batchMeans_.end(); ++batchMean ) {
+        sum += (*batchMean);
+      }
+      return sum/batchMeans_.size();
+    }
+
+    /// uncertainty on the average of the batch estimates; zero if less than two batches are completed
+    double getMeanErr() const
+    {
+      size_t k = batchMeans_.size();
+      if ( k < 2 ) return 0.;
+      double mean = getMean();
+      double sum2 = 0.;
+      for ( std::vector<double>::const_iterator batchMean = batchMeans_.begin(); batchMean != batchMeans_.end(); ++batchMean ) {
+        sum2 += ((*batchMean) - mean)*((*batchMean) - mean);
+      }
+      return std::sqrt(sum2/(k*(k - 1)));
+    }
+
+   private:
+    Statistic statistic_;
+    unsigned long batchSize_;
+    unsigned long numValues_;
+    double batchSum_;
+    std::vector<double> batchValues_;
+    std::vector<double> batchMeans_;
+  };
+}
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef TauAnalysis_ClassicSVfit_svFitCollinearApproximation_h
+#define TauAnalysis_ClassicSVfit_svFitCollinearApproximation_h
+
+/** \class SVfitApproximation
+ *
+ * Approximate estimates of the mass of the di-tau system, computed in closed form from the same inputs as ClassicSVfit,
+ * for pre-selecting the events for which the (much slower) integration is run:
+ *
+ *  visible mass:          mass of the sum of the visible decay products
+ *  collinear mass:        mass of the di-tau system, assuming that the neutrinos are collinear with the visible decay products
+ *                         and account for the full MET; its uncertainty is propagated linearly from the MET covariance
+ *  total transverse mass: sqrt(mT(vis1, vis2)^2 + mT(vis1, MET)^2 + mT(vis2, MET)^2)
+ *
+ * The method isCompatible checks if the mass reconstructed by ClassicSVfit may fall into a given window.
+ * It is conservative by construction:
+ *  - the upper boundary uses the visible mass, which is a lower bound on the di-tau mass
+ *    (the neutrinos can only add to the invariant mass of the visible decay products);
+ *  - the lower boundary uses the collinear mass, incremented by a multiple of its uncertainty and by a relative margin,
+ *    and is applied only if the collinear solution is physical (0 < x <= 1 for both tau leptons).
+ *    The collinear mass has long tails towards high values, for visible decay products that are nearly back-to-back
+ *    in the transverse plane, but may also underestimate the mass when the MET is mismeasured.
+ *    On events generated by generateClassicSVfitToyEvents, the collinear mass plus three times its uncertainty
+ *    exceeds 1.4 times the reconstructed mass for all events; the default margin of 25% comes on top of that
+ *    (cf. checkClassicSVfitApproximation).
+ *
+ */
+
+#include "TauAnalysis/ClassicSVfit/interface/MeasuredTauLepton.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitAuxFunctions.h" // Matrix2x2
+
+#include <vector>
+
+namespace classic_svFit
+{
+  struct SVfitApproximation
+  {
+    SVfitApproximation();
+
+    /// check if the mass reconstructed by ClassicSVfit may be within [massMin, massMax],
+    /// allowing the collinear mass to deviate downwards by numSigma times its uncertainty plus the fraction margin of the lower boundary
+    bool isCompatible(double massMin, double massMax, double numSigma = 3., double margin = 0.25) const;
+
+    double visibleMass_;
+
+    double collinearMass_;
+    double collinearMassErr_;
+
+    /// fraction of the tau energy carried by the visible decay products in the collinear approximation
+    /// (one for prompt leptons)
+    double x1_;
+    double x2_;
+
+    /// flag indicating that the collinear approximation has a physical solution (0 < x <= 1 for both tau leptons)
+    bool isValidCollinearSolution_;
+
+    double totalTransverseMass_;
+  };
+
+  /// compute approximate estimates for two measured tau leptons and the measured MET
+  SVfitApproximation compApproximation(const std::vector<MeasuredTauLepton>& measuredTauLeptons,
+                                       double measuredMETx, double measuredMETy, const Matrix2x2& covMET);
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef TauAnalysis_ClassicSVfit_svFitHash_h
+#define TauAnalysis_ClassicSVfit_svFitHash_h
+
+/** \class SVfitHash
+ *
+ * Incremental 64-bit FNV-1a hash of the inputs and configuration of the SVfit algorithm,
+ * used as key for caching results (cf. SVfitResultCache)
+ *
+ */
+
+#include <string>
+#include <stdint.h>
+#include <string.h>
+
+namespace classic_svFit
+{
+  class SVfitHash
+  {
+   public:
+    SVfitHash()
+      : value_(14695981039346656037ULL)
+    {}
+
+    void add(const void* data, size_t size)
+    {
+      const unsigned char* bytes = static_cast<const unsigned char*>(data);
+      for ( size_t idx = 0; idx < size; ++idx ) {
+        value_ ^= bytes[idx];
+        value_ *= 1099511628211ULL;
+      }
+    }
+    void add(double value)
+    {
+      // CV: make sure that +0 and -0 give the same hash
+      if ( value == 0. ) value = 0.;
+      add(&value, sizeof(double));
+    }
+    void add(int value) { add(&value, sizeof(int)); }
+    void add(unsigned value) { add(&value, sizeof(unsigned)); }
+    void add(unsigned long long value) { add(&value, sizeof(unsigned long long)); }
+    void add(bool value) { add(static_cast<int>(value)); }
+    void add(const std::string& value)
+    {
+      add(static_cast<unsigned long long>(value.size()));
+      add(value.data(), value.size());
+    }
+
+    uint64_t getValue() const { return value_; }
+
+   private:
+    uint64_t value_;
+  };
+}
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef TauAnalysis_ClassicSVfit_svFitHistogram_h
+#define TauAnalysis_ClassicSVfit_svFitHistogram_h
+
+/** \class SVfitHistogram
+ *
+ * Histogram of the posterior distribution of a reconstructed quantity, which does not need the ROOT libraries.
+ *
+ * The binning, the filling and the statistics follow the conventions of TH1D:
+ * bin 0 is the underflow and bin numBins + 1 the overflow bin,
+ * and the mean is computed from the filled values that are within the range of the histogram.
+ * The conversion to and from TH1 is provided by HistogramTools (cf. svFitHistogramAdapterROOT.cc).
+ *
+ */
+
+#include <algorithm>
+#include <vector>
+
+namespace classic_svFit
+{
+  /// binning of a histogram: either numBins_ bins of equal width in the range [xMin_, xMax_],
+  /// or bins of variable width, with the numBins_ + 1 bin edges given by binEdges_
+  struct HistogramBinning
+  {
+    HistogramBinning();
+    int numBins_;
+    double xMin_;
+    double xMax_;
+    std::vector<double> binEdges_;
+  };
+
+  class SVfitHistogram
+  {
+   public:
+    SVfitHistogram();
+
+    /// change binning and reset content;
+    /// memory is reallocated only if the number of bins exceeds the largest number of bins set before
+    void setBinning(const HistogramBinning& binning);
+    const HistogramBinning& getBinning() const { return binning_; }
+
+    /// reset bin contents and statistics
+    void reset();
+
+    /// add entry for the given value; returns the bin that was filled, or -1 for the underflow and overflow bins
+    int fill(double x)
+    {
+      ++numEntries_;
+      int bin = findBin(x);
+      binContents_[bin] += 1.;
+      if ( bin == 0 || bin > binning_.numBins_ ) return -1;
+      sumw_ += 1.;
+      sumwx_ += x;
+      sumwx2_ += x*x;
+      return bin;
+    }
+
+    /// bin containing the given value, as TAxis::FindBin
+    int findBin(double x) const
+    {
+      if ( x < binning_.xMin_ ) return 0;
+      // CV: NaN is assigned to the overflow bin
+      if ( !(x < binning_.xMax_) ) return binning_.numBins_ + 1;
+      if ( binning_.binEdges_.empty() ) return 1 + int(binning_.numBins_*(x - binning_.xMin_)/(binning_.xMax_ - binning_.xMin_));
+      return std::upper_bound(binning_.binEdges_.begin(), binning_.binEdges_.end(), x) - binning_.binEdges_.begin();
+    }
+
+    int getNumBins() const { return binning_.numBins_; }
+
+    double getBinContent(int bin) const { return binContents_[bin]; }
+    void setBinContent(int bin, double binContent) { binContents_[bin] = binContent; }
+
+    double getBinLowEdge(int bin) const;
+    double getBinWidth(int bin) const;
+    double getBinCenter(int bin) const;
+
+    /// mean of the filled values within the range of the histogram
+    double getMean() const { return ( sumw_ != 0. ) ? sumwx_/sumw_ : 0.; }
+
+    /// number of entries, including those in the underflow and overflow bins
+    double getEntries() const { return numEntries_; }
+    void setEntries(double numEntries) { numEntries_ = numEntries; }
+
+    /// sum of weights, sum of squared weights, sum of weighted values and sum of weighted squared values
+    /// of the filled values within the range of the histogram, in the order of TH1::GetStats
+    void getStats(double* stats) const;
+    void putStats(const double* stats);
+
+   private:
+    HistogramBinning binning_;
+
+    /// contents of the numBins + 2 bins, including the underflow and overflow bins
+    std::vector<double> binContents_;
+
+    double numEntries_;
+    double sumw_;
+    double sumwx_;
+    double sumwx2_;
+  };
+}
+
+#endif
@@ -2,16 +2,65 @@
 #define TauAnalysis_ClassicSVfit_svFitHistogramAdapter_h
 
 #include "TauAnalysis/ClassicSVfit/interface/MeasuredTauLepton.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitQuantileEstimator.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitHistogram.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitHash.h"
 
 #include <Math/Functor.h>
-#include <TH1.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+class TH1;
 
 namespace classic_svFit
 {
+  class SVfitLikelihoodArchive;
+
+  /// summary statistics of the posterior distribution of a reconstructed quantity,
+  /// extracted in a single pass over the histogram bins
+  struct HistogramProperties
+  {
+    HistogramProperties();
+    double xMaximum_;
+    double xMaximum_interpol_;
+    double xMean_;
+    double xQuantile016_;
+    double xQuantile050_;
+    double xQuantile084_;
+    double Lmax_;
+  };
+
   class HistogramTools
   {
    public:
+    static void extractHistogramProperties(const SVfitHistogram& histogram, HistogramProperties& properties);
+    /// compute exact mean and quantiles of the given samples, and the maximum of their Gaussian kernel density estimate;
+    /// the maximum is left unchanged if the samples are (nearly) all identical. The order of the samples is modified
+    static void extractSampleProperties(std::vector<double>& samples, HistogramProperties& properties);
+    /// versions of the above using the given vector as temporary storage, to avoid memory allocations when called repeatedly
+    static void extractHistogramProperties(const SVfitHistogram& histogram, HistogramProperties& properties, std::vector<double>& workspace);
+    static void extractSampleProperties(std::vector<double>& samples, HistogramProperties& properties, std::vector<double>& workspace);
+    static void extractSampleProperties(double* samples, size_t numSamples, HistogramProperties& properties, std::vector<double>& workspace);
+    /// uncertainty on the maximum, computed from the distances of the 16% and 84% quantiles to the maximum
+    static double compUncertainty(const HistogramProperties& properties);
+    /// compute binning of the histograms booked by the functions below
+    static void compBinning_linBinWidth(int numBins, double xMin, double xMax, HistogramBinning& binning);
+    static void compBinning_logBinWidth(double xMin, double xMax, double logBinWidth, HistogramBinning& binning);
+    static void compBinning_adaptiveLogBinWidth(double xMin, double xMax, double xMinCore, double xMaxCore, int numBinsCore, double logBinWidthTails,
+                                                HistogramBinning& binning);
+    /// number of bins of the binning computed by compBinning_logBinWidth
+    static int getNumBins_logBinWidth(double xMin, double xMax, double logBinWidth);
+    /// compute binning with numBins bins, by adding bins above the given binning that continue the logarithmic width of its last bin
+    static void compBinning_extended(const HistogramBinning& binning, int numBins, HistogramBinning& extendedBinning);
+    /// compute binning with at most maxNumBins bins, by merging groups of adjacent bins of the given binning
+    static void compBinning_compact(const HistogramBinning& binning, int maxNumBins, HistogramBinning& compactBinning);
+
+    /// CV: the functions for TH1 histograms are defined in svFitHistogramAdapterROOT.cc, as they need the ROOT libraries
     static TH1* compHistogramDensity(TH1 const* histogram);
+    static void extractHistogramProperties(TH1 const* histogram, HistogramProperties& properties);
+    static void extractHistogramProperties(TH1 const* histogram, HistogramProperties& properties, std::vector<double>& workspace);
     static void extractHistogramProperties(
         TH1 const* histogram,
         double& xMaximum,
@@ -26,32 +75,119 @@ namespace classic_svFit
     static double extractLmax(TH1 const* histogram);
     static TH1* makeHistogram_linBinWidth(const std::string& histogramName, int numBins, double xMin, double xMax);
     static TH1* makeHistogram_logBinWidth(const std::string& histogramName, double xMin, double xMax, double logBinWidth);
+    /// histogram with fine logarithmic binning in the "core" range [xMinCore, xMaxCore], split into numBinsCore bins,
+    /// and coarse logarithmic binning (logBinWidthTails) in the remainder of the range [xMin, xMax]
+    static TH1* makeHistogram_adaptiveLogBinWidth(const std::string& histogramName, double xMin, double xMax,
+                                                  double xMinCore, double xMaxCore, int numBinsCore, double logBinWidthTails);
+    static TH1* makeHistogram(const std::string& histogramName, const HistogramBinning& binning);
+    /// make TH1 histogram with the binning, content and statistics of the given histogram
+    static TH1* makeHistogram(const std::string& histogramName, const SVfitHistogram& histogram);
+    /// copy binning, content and statistics of the given TH1 histogram
+    static void copyHistogram(TH1 const* histogram, SVfitHistogram& histogram_copy);
+    /// change binning of the given histogram and reset its content;
+    /// memory is reallocated only if the number of bins changes
+    static void setBinning(TH1* histogram, const HistogramBinning& binning);
   };
 
   class SVfitQuantity
   {
    public:
+    /// methods for extracting mean and quantiles of the posterior distribution
+    enum ExtractionMode {
+      kHistogram,         // computed from the histogram bin contents (default)
+      kStreamingQuantiles, // computed by a streaming t-digest estimator, independent of the binning;
+                           // the maximum is still taken from a histogram with compact binning (cf. maxNumBins_compact)
+      kSampleStore         // exact mean and quantiles computed from all sampled values, which are kept in memory;
+                           // the maximum is taken from a kernel density estimate
+    };
+
     SVfitQuantity(const std::string& label);
     virtual ~SVfitQuantity();
 
-    const TH1* getHistogram() const;
+    /// set method for extracting mean and quantiles,
+    /// takes effect with the next booking of the histogram
+    void setExtractionMode(int extractionMode);
+
+    /// set memory for storing up to sampleBufferSize samples in kSampleStore mode,
+    /// which is owned by the caller (cf. HistogramAdapter::reserveSamples); discards all samples
+    void setSampleBuffer(double* sampleBuffer, unsigned long sampleBufferSize);
+
+    /// histogram of the posterior distribution (nullptr if not booked)
+    const SVfitHistogram* getHistogram() const;
+
+    /// write histogram to the current ROOT directory or add it to the given archive
+    /// (defined in svFitHistogramAdapterROOT.cc, as they need the ROOT libraries)
     void writeHistogram() const;
+    void writeHistogram(SVfitLikelihoodArchive& archive, unsigned long long eventId) const;
+
+    /// delete histograms, e.g. when the quantity is not needed anymore
+    void resetHistogram();
 
     void fillHistogram(double value);
 
+    /// record range of values sampled during the burnin stage of the Markov Chain
+    void fillBurnin(double value);
+
     double extractValue() const;
     double extractUncertainty() const;
     double extractLmax() const;
 
     bool isValidSolution() const;
 
+    /// summary statistics of the histogram,
+    /// computed on first access and cached until the histogram is booked or filled again
+    const HistogramProperties& getHistogramProperties() const;
+
+    /// set summary statistics, e.g. restored from SVfitResultCache,
+    /// which are used instead of those of the histogram until the histogram is booked or filled again
+    void setHistogramProperties(const HistogramProperties& properties);
+
    protected:
+    /// book histogram with the given binning, reusing the histogram booked for previous events;
+    /// binnings with fewer than numBins_fixed_ bins are extended to this number of bins (cf. HistogramTools::compBinning_extended),
+    /// so that no memory is allocated after the first event
+    void bookHistogram(const HistogramBinning& binning);
+
     std::string label_;
 
-    mutable TH1* histogram_ = nullptr;
+    std::string histogramName_;
+    SVfitHistogram* histogram_ = nullptr;
+
+    HistogramBinning binning_;
+
+    /// number of bins of the histogram booked for each event, for quantities whose binning depends on the event (zero otherwise)
+    int numBins_fixed_ = 0;
+    HistogramBinning binning_extended_;
+
+    /// temporary storage for extracting the summary statistics
+    mutable std::vector<double> workspace_;
+
+    mutable HistogramProperties histogramProperties_;
+    mutable bool histogramProperties_isValid_ = false;
+
+    int extractionMode_ = kHistogram;
+
+    /// streaming estimator of mean and quantiles, allocated in kStreamingQuantiles mode only
+    std::unique_ptr<TDigest> digest_;
+
+    /// binning of the histogram booked in kStreamingQuantiles mode, which is used for the maximum only
+    HistogramBinning binning_compact_;
+    static const int maxNumBins_compact = 128;
+
+    /// values sampled in kSampleStore mode, stored in the buffer set by setSampleBuffer,
+    /// or in samples_overflow_ once their number exceeds the size of the buffer
+    double* sampleBuffer_ = nullptr;
+    unsigned long sampleBufferSize_ = 0;
+    unsigned long numSamples_ = 0;
+    mutable std::vector<double> samples_overflow_;
+
+    /// range of values sampled during the burnin stage
+    double burninMin_ = 0.;
+    double burninMax_ = 0.;
+    unsigned long numBurninValues_ = 0;
 
    private:
-    static int nInstances;
+    static std::atomic<int> nInstances;
    protected:
     std::string uniqueName_;
   };
@@ -62,7 +198,29 @@ namespace classic_svFit
     HistogramAdapter(const std::string& label);
     virtual ~HistogramAdapter();
 
+    /// write histograms to the given ROOT file, or add histograms of given event to archive (cf. SVfitLikelihoodArchive);
+    /// defined in svFitHistogramAdapterROOT.cc, as they need the ROOT libraries
     void writeHistograms(const std::string& likelihoodFileName) const;
+    void writeHistograms(SVfitLikelihoodArchive& archive, unsigned long long eventId) const;
+
+    /// set method for extracting mean and quantiles of all quantities (cf. SVfitQuantity::ExtractionMode)
+    virtual void setExtractionMode(int extractionMode);
+
+    /// preallocate memory for the given number of samples of the quantities with booked histograms (in kSampleStore mode only),
+    /// as slices of a single buffer that is kept and reused for subsequent events.
+    /// Needs to be called after the histograms are booked
+    void reserveSamples(unsigned long numSamples);
+
+    /// append the quantities with booked histograms, i.e. the selected ones, to the given vector
+    virtual void getBookedQuantities(std::vector<SVfitQuantity*>& quantities) const;
+
+    /// get summary statistics of all quantities, appending them to the given vector,
+    /// and set them again (cf. SVfitResultCache); the latter returns the index of the first unused entry of the vector
+    virtual void getHistogramProperties(std::vector<HistogramProperties>& properties) const;
+    virtual size_t setHistogramProperties(const std::vector<HistogramProperties>& properties, size_t idx);
+
+    /// add settings that affect the extracted values to hash of the SVfit configuration
+    virtual void hashConfiguration(SVfitHash& hash) const;
 
     double extractValue(const SVfitQuantity* quantity) const;
     double extractUncertainty(const SVfitQuantity* quantity) const;
@@ -74,6 +232,12 @@ namespace classic_svFit
     std::string label_;
 
     mutable std::vector<SVfitQuantity*> quantities_;
+
+    int extractionMode_;
+
+    /// memory for the samples of all quantities in kSampleStore mode (cf. reserveSamples)
+    std::vector<SVfitQuantity*> quantities_sampled_;
+    std::vector<double> samplePool_;
   };
 
   //-------------------------------------------------------------------------------------------------
@@ -83,7 +247,7 @@ namespace classic_svFit
    public:
     SVfitQuantityTau(const std::string& label);
 
-    virtual TH1* createHistogram(const LorentzVector& visP4) const = 0;
+    virtual void compBinning(const LorentzVector& visP4, HistogramBinning& binning) const = 0;
 
     void bookHistogram(const LorentzVector& visP4);
   };
@@ -92,21 +256,21 @@ namespace classic_svFit
   {
    public:
     SVfitQuantityTauPt(const std::string& label);
-    virtual TH1* createHistogram(const LorentzVector& visP4) const;
+    virtual void compBinning(const LorentzVector& visP4, HistogramBinning& binning) const;
   };
 
   class SVfitQuantityTauEta : public SVfitQuantityTau
   {
    public:
     SVfitQuantityTauEta(const std::string& label);
-    virtual TH1* createHistogram(const LorentzVector& visP4) const;
+    virtual void compBinning(const LorentzVector& visP4, HistogramBinning& binning) const;
   };
 
   class SVfitQuantityTauPhi : public SVfitQuantityTau
   {
    public:
     SVfitQuantityTauPhi(const std::string& label);
-    virtual TH1* createHistogram(const LorentzVector& visP4) const;
+    virtual void compBinning(const LorentzVector& visP4, HistogramBinning& binning) const;
   };
   
   class HistogramAdapterTau : public HistogramAdapter
@@ -115,6 +279,7 @@ namespace classic_svFit
     HistogramAdapterTau(const std::string& label);
 
     void bookHistograms(const LorentzVector& visP4);
+    void resetHistograms();
 
     void setMeasurement(const LorentzVector& visP4);
     void setTauP4(const LorentzVector& tauP4);
@@ -155,52 +320,146 @@ namespace classic_svFit
    public:
     SVfitQuantityDiTau(const std::string& label);
 
-    virtual TH1* createHistogram(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met) const = 0;
+    virtual void compBinning(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met, HistogramBinning& binning) const = 0;
+
+    /// compute binning adapted to the range [xMinCore, xMaxCore] of the posterior distribution;
+    /// returns false for quantities that do not support adaptive binning
+    virtual bool compBinning_adaptive(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met, double xMinCore, double xMaxCore,
+                                      HistogramBinning& binning) const;
 
     void bookHistogram(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met);
+
+    /// replace histogram by one with binning adapted to the range of values sampled during the burnin stage;
+    /// needs to be called before the histogram gets filled. The histogram is kept if no values were sampled during the burnin stage
+    void bookHistogram_adaptive(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met);
   };
 
   class SVfitQuantityDiTauPt : public SVfitQuantityDiTau
   {
    public:
     SVfitQuantityDiTauPt(const std::string& label);
-    virtual TH1* createHistogram(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met) const;
+    virtual void compBinning(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met, HistogramBinning& binning) const;
   };
 
   class SVfitQuantityDiTauEta : public SVfitQuantityDiTau
   {
    public:
     SVfitQuantityDiTauEta(const std::string& label);
-    virtual TH1* createHistogram(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met) const;
+    virtual void compBinning(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met, HistogramBinning& binning) const;
   };
 
   class SVfitQuantityDiTauPhi : public SVfitQuantityDiTau
   {
    public:
     SVfitQuantityDiTauPhi(const std::string& label);
-    virtual TH1* createHistogram(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met) const;
+    virtual void compBinning(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met, HistogramBinning& binning) const;
   };
 
   class SVfitQuantityDiTauMass : public SVfitQuantityDiTau
   {
    public:
     SVfitQuantityDiTauMass(const std::string& label);
-    virtual TH1* createHistogram(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met) const;
+    virtual void compBinning(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met, HistogramBinning& binning) const;
+    virtual bool compBinning_adaptive(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met, double xMinCore, double xMaxCore,
+                                      HistogramBinning& binning) const;
   };
 
   class SVfitQuantityDiTauTransverseMass : public SVfitQuantityDiTau
   {
    public:
     SVfitQuantityDiTauTransverseMass(const std::string& label);
-    virtual TH1* createHistogram(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met) const;
+    virtual void compBinning(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met, HistogramBinning& binning) const;
+    virtual bool compBinning_adaptive(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met, double xMinCore, double xMaxCore,
+                                      HistogramBinning& binning) const;
+  };
+
+  /// function computing a user-defined observable from the four-vectors of the two tau leptons and the MET
+  typedef std::function<double(const LorentzVector& tau1P4, const LorentzVector& tau2P4, const Vector& met)> ObservableFunction;
+
+  class SVfitQuantityDiTauUserDefined : public SVfitQuantityDiTau
+  {
+   public:
+    SVfitQuantityDiTauUserDefined(const std::string& label, const std::string& name, const ObservableFunction& function, int numBins, double xMin, double xMax);
+    virtual void compBinning(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met, HistogramBinning& binning) const;
+
+    double compValue(const LorentzVector& tau1P4, const LorentzVector& tau2P4, const Vector& met) const;
+
+    void hashConfiguration(SVfitHash& hash) const;
+
+   protected:
+    std::string name_;
+    ObservableFunction function_;
+    int numBins_;
+    double xMin_;
+    double xMax_;
+  };
+
+  class HistogramAdapterDiTau;
+
+  /// "call-back" function evaluated during the burnin stage of the Markov Chain,
+  /// recording the range of the posterior distributions for histograms with adaptive binning
+  class HistogramAdapterDiTauBurnin : public ROOT::Math::Functor
+  {
+   public:
+    HistogramAdapterDiTauBurnin(const HistogramAdapterDiTau* adapter);
+
+  private:
+    double DoEval(const double* x) const;
+
+    const HistogramAdapterDiTau* adapter_;
   };
 
   class HistogramAdapterDiTau : public HistogramAdapter
   {
    public:
+    /// flags selecting the observables that are booked, computed and filled during the Markov Chain integration
+    enum Observables {
+      kPt             = 0x00000001,
+      kEta            = 0x00000002,
+      kPhi            = 0x00000004,
+      kMass           = 0x00000008,
+      kTransverseMass = 0x00000010,
+      kTau1           = 0x00000020, // pT, eta, phi of first tau lepton
+      kTau2           = 0x00000040, // pT, eta, phi of second tau lepton
+      kAll            = 0x0000007f
+    };
+
     HistogramAdapterDiTau(const std::string& label = "ditau");
     ~HistogramAdapterDiTau();
 
+    /// select observables by bitmask of Observables flags (default is kAll);
+    /// getter functions for observables that are not selected return zero
+    void setObservables(unsigned observables);
+    unsigned getObservables() const;
+
+    /// register a user-defined observable, computed from the four-vectors of the two tau leptons and the MET;
+    /// returns the index for retrieving the reconstructed value of the observable
+    unsigned addObservable(const std::string& name, const ObservableFunction& function, int numBins, double xMin, double xMax);
+
+    /// get value, uncertainty and maximum of the likelihood for user-defined observable
+    double getObservable(unsigned idx) const;
+    double getObservableErr(unsigned idx) const;
+    double getObservableLmax(unsigned idx) const;
+
+    /// set method for extracting mean and quantiles of all quantities, including those of the two tau leptons
+    void setExtractionMode(int extractionMode);
+    void getBookedQuantities(std::vector<SVfitQuantity*>& quantities) const;
+
+    void getHistogramProperties(std::vector<HistogramProperties>& properties) const;
+    size_t setHistogramProperties(const std::vector<HistogramProperties>& properties, size_t idx);
+
+    /// user-defined observables are identified by their name and binning
+    void hashConfiguration(SVfitHash& hash) const;
+
+    /// enable booking of mass and transverse mass histograms with fine binning around the range of values
+    /// sampled during the burnin stage of the Markov Chain (default is disabled);
+    /// requires fillBurnin, or the function returned by getBurninCallBackFunction, to be evaluated during the burnin stage
+    void setAdaptiveBinning(bool adaptiveBinning);
+    const ROOT::Math::Functor& getBurninCallBackFunction() const;
+
+    /// return true if fillBurnin needs to be called during the burnin stage, i.e. if histograms with adaptive binning are booked
+    bool needsBurnin() const;
+
     void bookHistograms(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met);
 
     void setMeasurement(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met);
@@ -209,6 +468,13 @@ namespace classic_svFit
     void fillHistograms(const LorentzVector& tau1P4, const LorentzVector& tau2P4, const LorentzVector& ditauP4,
 			const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met) const;
 
+    /// fill histograms with the given four-vectors of the tau leptons,
+    /// booking histograms with adaptive binning before the first sample is filled
+    void fill(const LorentzVector& tau1P4, const LorentzVector& tau2P4) const;
+
+    /// record mass and transverse mass for the given four-vectors of the tau leptons during the burnin stage
+    void fillBurnin(const LorentzVector& tau1P4, const LorentzVector& tau2P4) const;
+
     HistogramAdapterTau* tau1() const;
     HistogramAdapterTau* tau2() const;
 
@@ -235,19 +501,27 @@ namespace classic_svFit
   private:
     double DoEval(const double* x) const;
 
+    friend class HistogramAdapterDiTauBurnin;
+
    protected:
     LorentzVector vis1P4_;
     LorentzVector vis2P4_;
     Vector met_;
     LorentzVector tau1P4_;
     LorentzVector tau2P4_;
-    LorentzVector ditauP4_;
+
+    unsigned observables_;
+
+    bool adaptiveBinning_;
+    mutable bool isAdaptiveBookingPending_;
+    HistogramAdapterDiTauBurnin burninCallBackFunction_;
 
     SVfitQuantityDiTauPt* quantity_pt_;
     SVfitQuantityDiTauEta* quantity_eta_;
     SVfitQuantityDiTauPhi* quantity_phi_;
     SVfitQuantityDiTauMass* quantity_mass_;
     SVfitQuantityDiTauTransverseMass* quantity_transverseMass_;
+    std::vector<SVfitQuantityDiTauUserDefined*> quantities_userDefined_;
 
     HistogramAdapterTau* adapter_tau1_;
     HistogramAdapterTau* adapter_tau2_;
@@ -0,0 +1,84 @@
+#ifndef TauAnalysis_ClassicSVfit_svFitHistogramPipeline_h
+#define TauAnalysis_ClassicSVfit_svFitHistogramPipeline_h
+
+#include "TauAnalysis/ClassicSVfit/interface/svFitHistogramAdapter.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitRingBuffer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace classic_svFit
+{
+  /// fills the histograms of a HistogramAdapterDiTau in a separate consumer thread,
+  /// so that the computation of the observables and the histogram filling
+  /// overlap with the sampling of the Markov Chain.
+  /// The consumer thread is started with the first event and kept until the pipeline is deleted;
+  /// the end of each event is passed to it through the ring buffer.
+  /// Both threads block on a condition variable when the buffer is empty (consumer) or full (sampling thread)
+  class HistogramPipelineDiTau
+  {
+   public:
+    HistogramPipelineDiTau(size_t capacity = 4096);
+    ~HistogramPipelineDiTau();
+
+    /// set histogram adapter filled by the consumer thread, starting the thread if needed;
+    /// the histogram adapter must not be accessed by other threads until stop is called
+    void start(const HistogramAdapterDiTau* histogramAdapter);
+
+    /// pass four-vectors of the tau leptons to the consumer thread (sampling thread only);
+    /// waits in case the consumer thread falls behind by more than the capacity of the buffer
+    void push(const LorentzVector& tau1P4, const LorentzVector& tau2P4, bool isBurnin)
+    {
+      record_.tau1P4_ = tau1P4;
+      record_.tau2P4_ = tau2P4;
+      record_.type_ = ( isBurnin ) ? kBurnin : kSample;
+      pushRecord(record_);
+    }
+
+    /// wait until all four-vectors passed to the consumer thread are processed;
+    /// the consumer thread is kept waiting for the next event
+    void stop();
+
+   private:
+    void consume();
+
+    enum RecordType { kSample, kBurnin, kEndOfEvent, kTerminate };
+    struct Record
+    {
+      LorentzVector tau1P4_;
+      LorentzVector tau2P4_;
+      int type_;
+    };
+
+    void pushRecord(const Record& record)
+    {
+      if ( !buffer_.push(record) ) waitForSpace(record);
+      // CV: the fence orders the write of the head index of the buffer before the read of the flag,
+      //     matching the fence in waitForRecord, so that the consumer thread cannot miss the record
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if ( isConsumerWaiting_.load(std::memory_order_relaxed) ) wakeConsumer();
+    }
+    void waitForSpace(const Record& record);
+    void waitForRecord(Record& record);
+    void wakeConsumer();
+    void wakeProducer();
+
+    Record record_;
+    SPSCRingBuffer<Record> buffer_;
+
+    const HistogramAdapterDiTau* histogramAdapter_;
+    std::thread consumer_;
+
+    std::mutex mutex_;
+    std::condition_variable consumerCondition_;
+    std::condition_variable producerCondition_;
+    std::atomic<bool> isConsumerWaiting_;
+    std::atomic<bool> isProducerWaiting_;
+    unsigned long numEventsPushed_;
+    unsigned long numEventsProcessed_; // protected by mutex_
+  };
+}
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef TauAnalysis_ClassicSVfit_svFitIntegratorSettings_h
+#define TauAnalysis_ClassicSVfit_svFitIntegratorSettings_h
+
+/** \class SVfitIntegratorSettings
+ *
+ * Number of integrand evaluations and hyperparameters of the Markov Chain integration
+ * (cf. SVfitIntegratorMarkovChain), which can be chosen separately for each decay channel
+ * by loading presets from a text file (cf. SVfitIntegratorPresets).
+ *
+ * File layout of the presets:
+ *   lines starting with '#' are comments
+ *   "version 1"
+ *   followed by one line per decay channel (cf. getDecayChannelName), e.g.
+ *   "mu_had maxObjFunctionCalls fractionBurnin fractionSimAnnealingPhase1 fractionSimAnnealingPhase2 T0 fractionTemperatureDecay numBatches epsilon0 nu"
+ *
+ * Presets are written by the tuneClassicSVfit executable.
+ *
+ * \class SVfitPrecisionSettings
+ *
+ * Target statistical precision of the reconstructed mass, which sets the number of integrand evaluations for each event:
+ * the sampling of the Markov Chain is extended until the statistical uncertainty of the median of the mass posterior,
+ * estimated from the medians of batches of at least 1000 samples (cf. SVfitBatchMeans), is below the target.
+ *
+ * \class SVfitRefinementSettings
+ *
+ * Settings of the two-tier integration: each event is integrated with a small number of integrand evaluations first,
+ * and the sampling of the Markov Chain is continued to the full number of integrand evaluations only for events
+ * whose mass posterior overlaps with a mass window or whose mass has a large statistical uncertainty.
+ *
+ */
+
+#include "TauAnalysis/ClassicSVfit/interface/svFitHash.h"
+
+#include <map>
+#include <ostream>
+#include <string>
+
+namespace classic_svFit
+{
+  struct SVfitIntegratorSettings
+  {
+    SVfitIntegratorSettings();
+
+    bool operator==(const SVfitIntegratorSettings& settings) const;
+    bool operator!=(const SVfitIntegratorSettings& settings) const { return !(*this == settings); }
+
+    /// add settings to hash used as key for caching results
+    void hash(SVfitHash& hash) const;
+
+    /// total number of integrand evaluations (default is 100000)
+    unsigned maxObjFunctionCalls_;
+
+    /// fraction of integrand evaluations used for "burnin" (default is 0.10)
+    double fractionBurnin_;
+
+    /// number of iterations of the first and second phase of the simulated annealing,
+    /// given as fraction of the "burnin" iterations (default is 0.20 and 0.60)
+    double fractionSimAnnealingPhase1_;
+    double fractionSimAnnealingPhase2_;
+
+    /// initial annealing temperature (default is 15)
+    double T0_;
+
+    /// number of iterations over which the annealing temperature decreases by a factor e,
+    /// given as fraction of the "burnin" iterations (default is 0.10)
+    double fractionTemperatureDecay_;
+
+    /// number of batches used to estimate the uncertainty on the integral (default is 100)
+    unsigned numBatches_;
+
+    /// average step-size and variation of the step-size of the Metropolis moves (default is 1.e-2 and 0.71)
+    double epsilon0_;
+    double nu_;
+  };
+
+  struct SVfitPrecisionSettings
+  {
+    SVfitPrecisionSettings();
+
+    /// return settings of the named preset: "fast" (2%), "standard" (1%) or "reference" (0.2%)
+    static SVfitPrecisionSettings getPreset(const std::string& presetName);
+
+    /// add settings to hash used as key for caching results
+    void hash(SVfitHash& hash) const;
+
+    /// target statistical uncertainty of the median of the mass posterior, relative to the median
+    /// (default is 0 = fixed number of integrand evaluations)
+    double targetMassPrecision_;
+
+    /// number of integrand evaluations of the first integration, before the sampling gets extended
+    /// (default is 0 = number given by the SVfitIntegratorSettings of the decay channel)
+    unsigned minObjFunctionCalls_;
+
+    /// maximum total number of integrand evaluations per event (default is 1000000)
+    unsigned maxObjFunctionCalls_;
+  };
+
+  struct SVfitRefinementSettings
+  {
+    SVfitRefinementSettings();
+
+    /// add settings to hash used as key for caching results
+    void hash(SVfitHash& hash) const;
+
+    /// number of integrand evaluations of the coarse integration (default is 10000)
+    unsigned numObjFunctionCallsCoarse_;
+
+    /// mass window, e.g. of the signal region (default is [0, 0] = refine only events with large statistical uncertainty)
+    double massMin_;
+    double massMax_;
+
+    /// the mass posterior of the coarse integration is taken to overlap with the mass window if the interval
+    /// mass +/- numSigma*massErr intersects the window (default is 1)
+    double numSigma_;
+
+    /// events for which the statistical uncertainty of the median of the mass posterior (cf. SVfitPrecisionSettings), relative to the mass,
+    /// exceeds this value after the coarse integration are refined regardless of the mass window (default is 0.05; 0 = not used)
+    double maxMassStatErr_;
+  };
+
+  class SVfitIntegratorPresets
+  {
+   public:
+    SVfitIntegratorPresets();
+    ~SVfitIntegratorPresets();
+
+    /// read presets from file, replacing the presets of decay channels contained in the file
+    void load(const std::string& fileName);
+
+    /// write presets in the format read by the load method
+    void write(std::ostream& stream) const;
+
+    /// set or replace preset for given decay channel
+    void set(const std::string& channelName, const SVfitIntegratorSettings& settings);
+
+    /// return preset for given decay channel, or nullptr if no preset exists for this channel
+    const SVfitIntegratorSettings* find(const std::string& channelName) const;
+
+    bool empty() const { return presets_.empty(); }
+
+   private:
+    std::map<std::string, SVfitIntegratorSettings> presets_;
+  };
+}
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef TauAnalysis_ClassicSVfit_svFitLikelihoodArchive_h
+#define TauAnalysis_ClassicSVfit_svFitLikelihoodArchive_h
+
+/** \class SVfitLikelihoodArchive
+ *
+ * Stores the likelihood histograms of all events processed in a job in a single ROOT file.
+ *
+ * The histograms are stored in the TTree "likelihoods", with one entry per event and reconstructed quantity:
+ *   eventId:     event identifier
+ *   quantity:    name of the histogram
+ *   binEdges:    edges of the bins from the first to the last non-empty bin
+ *   binContents: contents of the bins from the first to the last non-empty bin,
+ *                quantized to 16 bits relative to the maximum bin content
+ *   scale:       factor for converting the quantized bin contents back to the original bin contents
+ * Empty bins outside of the range covered by the posterior distribution are not stored,
+ * and the entries of many events are compressed together in the baskets of the TTree.
+ *
+ */
+
+#include "TauAnalysis/ClassicSVfit/interface/svFitHistogram.h"
+
+#include <TFile.h>
+#include <TTree.h>
+#include <TH1.h>
+
+#include <string>
+#include <vector>
+
+namespace classic_svFit
+{
+  class SVfitLikelihoodArchive
+  {
+   public:
+    /// compression settings are given as 100*algorithm + level, following the ROOT convention (default is LZMA, level 5)
+    SVfitLikelihoodArchive(const std::string& fileName, int compressionSettings = 205);
+    ~SVfitLikelihoodArchive();
+
+    /// add histogram of given event
+    void addHistogram(unsigned long long eventId, const std::string& quantity, const SVfitHistogram& histogram);
+    void addHistogram(unsigned long long eventId, const std::string& quantity, const TH1* histogram);
+
+    /// make histogram from the bin edges, quantized bin contents and scale factor stored in the archive
+    static TH1* makeHistogram(const std::string& histogramName,
+                              const std::vector<float>& binEdges, const std::vector<unsigned short>& binContents, float scale);
+
+   private:
+    TFile* file_;
+    TTree* tree_;
+
+    unsigned long long eventId_;
+    std::string quantity_;
+    std::vector<float> binEdges_;
+    std::vector<unsigned short> binContents_;
+    float scale_;
+  };
+}
+
+#endif
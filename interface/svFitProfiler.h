@@ -0,0 +1,117 @@
+#ifndef TauAnalysis_ClassicSVfit_svFitProfiler_h
+#define TauAnalysis_ClassicSVfit_svFitProfiler_h
+
+/** \class SVfitProfiler
+ *
+ * Measures the computing time spent in the different stages of the SVfit algorithm
+ * and counts integrand calls, Markov Chain moves and attempts to find a start-position.
+ *
+ * The total CPU and real time of each event are always measured.
+ * The time per stage is measured only if profiling is enabled, as measuring the time spent in filling the histograms
+ * requires two reads of the clock per move of the Markov Chain.
+ *
+ * The timings and counters are available for the last event and summed over all events processed in the job,
+ * and can be written in JSON format.
+ *
+ */
+
+#include <chrono>
+#include <ctime>
+#include <ostream>
+
+namespace classic_svFit
+{
+  /// timings (in seconds) and counters for one event, or summed over several events
+  struct SVfitProfile
+  {
+    enum Stage {
+      kPrepareInputs,      // rounding and sorting of inputs, setup of integrand and histograms, lookup in the result cache
+      kStartPosition,      // search for start-position of Markov Chain
+      kAnnealingPhase1,    // first and second phase of simulated annealing
+      kAnnealingPhase2,
+      kBurnin,             // "burnin" iterations that follow the simulated annealing
+      kSampling,           // iterations entering the computation of the integral
+      kHistogramFill,      // evaluation of observers and "call-back" functions, i.e. filling of histograms
+      kExtractStatistics,  // computation of pT, eta, phi, mass and transverse mass of di-tau system from histograms
+      kFileOutput,         // writing of likelihood histograms
+      kNumStages
+    };
+
+    enum Counter {
+      kNumEvents,
+      kIntegrandCalls,
+      kZeroProbability,      // integrand calls that returned zero probability
+      kMovesAccepted,
+      kMovesRejected,
+      kStartPositionRetries, // attempts to find a start-position that returned zero probability
+      kNumCounters
+    };
+
+    SVfitProfile();
+
+    void reset();
+
+    /// add timings and counters of another profile
+    void add(const SVfitProfile& profile);
+
+    /// write timings and counters in JSON format
+    void writeJSON(std::ostream& stream) const;
+
+    static const char* getStageName(int stage);
+    static const char* getCounterName(int counter);
+
+    double stageTime_real_[kNumStages];
+    unsigned long long counts_[kNumCounters];
+
+    double numSeconds_cpu_;
+    double numSeconds_real_;
+  };
+
+  class SVfitProfiler
+  {
+   public:
+    SVfitProfiler();
+
+    /// enable/disable measurement of time spent per stage (disabled by default)
+    void enable() { isEnabled_ = true; }
+    void disable() { isEnabled_ = false; }
+    bool isEnabled() const { return isEnabled_; }
+
+    /// start measurement for new event
+    void startEvent();
+
+    /// switch to given stage; the time elapsed since the last call is assigned to the previous stage
+    void setStage(SVfitProfile::Stage stage)
+    {
+      if ( !isEnabled_ ) return;
+      Clock::time_point now = Clock::now();
+      if ( stage_ != SVfitProfile::kNumStages ) event_.stageTime_real_[stage_] += std::chrono::duration<double>(now - stageStart_).count();
+      stage_ = stage;
+      stageStart_ = now;
+    }
+
+    void count(SVfitProfile::Counter counter, unsigned long long numCounts = 1) { event_.counts_[counter] += numCounts; }
+
+    /// finish measurement for current event and add it to the sum over all events
+    void stopEvent();
+
+    const SVfitProfile& getEventProfile() const { return event_; }
+    const SVfitProfile& getProcessProfile() const { return process_; }
+
+   private:
+    typedef std::chrono::steady_clock Clock;
+
+    bool isEnabled_;
+
+    SVfitProfile event_;
+    SVfitProfile process_;
+
+    SVfitProfile::Stage stage_; // kNumStages if no stage is active
+    Clock::time_point stageStart_;
+
+    Clock::time_point eventStart_real_;
+    std::clock_t eventStart_cpu_;
+  };
+}
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef TauAnalysis_ClassicSVfit_svFitQuantileEstimator_h
+#define TauAnalysis_ClassicSVfit_svFitQuantileEstimator_h
+
+/** \class TDigest
+ *
+ * Streaming estimator of the quantiles of a distribution,
+ * using constant memory and no binning.
+ *
+ * Observations are collected in a buffer and merged into a bounded number of weighted centroids,
+ * the size of which is limited such that the quantiles in the tails of the distribution are determined precisely.
+ * In contrast to estimators that update a few markers with each observation (e.g. the P2 algorithm),
+ * the result does not depend on the order of the observations, 
+ * which makes the estimator suitable for the strongly correlated samples of a Markov Chain.
+ *
+ * The code is implemented following the description in:
+ *  [1] "Computing Extremely Accurate Quantiles Using t-Digests",
+ *      T. Dunning and O. Ertl, arXiv:1902.04023
+ *
+ */
+
+namespace classic_svFit
+{
+  class TDigest
+  {
+   public:
+    TDigest();
+    ~TDigest();
+
+    /// discard all observations
+    void reset();
+
+    /// add observation
+    void add(double value);
+
+    /// return estimate of the quantile for given probability
+    double getQuantile(double probability) const;
+
+    /// return mean of all observations
+    double getMean() const;
+
+    /// return number of observations added since last reset
+    unsigned long getNumEntries() const;
+
+   private:
+    /// merge buffered observations into centroids
+    void merge() const;
+
+    /// compression parameter delta and scale function k1 (eq. (1) in [1])
+    static const int compression_ = 100;
+    static const int maxCentroids_ = 2*compression_;
+    static const int bufferSize_ = 5*compression_;
+    double compScale(double q) const;
+    double compScaleInverse(double k) const;
+
+    struct Centroid
+    {
+      double mean_;
+      double weight_;
+      bool operator<(const Centroid& other) const { return mean_ < other.mean_; }
+    };
+
+    /// centroids, followed by buffered observations that have not been merged yet
+    mutable Centroid centroids_[maxCentroids_ + bufferSize_];
+    mutable int numCentroids_;
+    mutable int numBuffered_;
+
+    double min_;
+    double max_;
+    double sum_;
+    unsigned long numEntries_;
+  };
+}
+
+#endif
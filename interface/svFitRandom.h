@@ -0,0 +1,68 @@
+#ifndef TauAnalysis_ClassicSVfit_svFitRandom_h
+#define TauAnalysis_ClassicSVfit_svFitRandom_h
+
+/** \class SVfitRandom
+ *
+ * Random number generator of the Markov Chain integration.
+ *
+ * The uniformly distributed numbers are drawn from std::mt19937, which is seeded like TRandom3,
+ * and the Gaussian and Breit-Wigner distributed numbers are computed by the same algorithms as in TRandom,
+ * so that the random numbers are the same as those of TRandom3 for any seed other than zero
+ * (TRandom3 takes seed zero to mean a seed derived from the system clock).
+ * The generator does not need the ROOT libraries.
+ * Define the preprocessor flag USE_TRANDOM3 to use TRandom3 instead, which requires linking against ROOT.
+ *
+ */
+
+#ifdef USE_TRANDOM3
+#include <TRandom3.h>
+#else
+#include <random>
+#endif
+
+namespace classic_svFit
+{
+  class SVfitRandom
+  {
+   public:
+    SVfitRandom();
+
+    void setSeed(unsigned seed);
+
+    /// uniformly distributed number in the interval ]0,1]
+    double rndm()
+    {
+#ifdef USE_TRANDOM3
+      return rnd_.Rndm();
+#else
+      // CV: zero is skipped and the 32-bit integer is converted to double as in TRandom3::Rndm
+      unsigned long y = 0;
+      do {
+        y = engine_();
+      } while ( y == 0 );
+      return y*2.3283064365386963e-10; // 2^-32
+#endif
+    }
+
+    /// uniformly distributed number in the interval ]a,b]
+    double uniform(double a, double b)
+    {
+      return a + (b - a)*rndm();
+    }
+
+    /// Gaussian distributed number with given mean and standard deviation
+    double gaus(double mean, double sigma);
+
+    /// Breit-Wigner (Cauchy) distributed number with given mean and width
+    double breitWigner(double mean, double gamma);
+
+   private:
+#ifdef USE_TRANDOM3
+    TRandom3 rnd_;
+#else
+    std::mt19937 engine_;
+#endif
+  };
+}
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef TauAnalysis_ClassicSVfit_svFitResultCache_h
+#define TauAnalysis_ClassicSVfit_svFitResultCache_h
+
+/** \class SVfitResultCache
+ *
+ * Cache of SVfit results, addressed by a hash of the (rounded) inputs and the configuration of the algorithm
+ * (cf. SVfitHash). As the inputs are rounded and the random number generator is reseeded for each event,
+ * identical inputs give identical results, so that events which are the same in several systematic variations
+ * need to be integrated only once.
+ *
+ * The results are kept in memory for the most recently used keys (LRU),
+ * and optionally in a memory-mapped file, which persists across jobs.
+ * The file is a direct-mapped table of numFileSlots slots of fixed size;
+ * entries in the same slot overwrite each other. The file must not be shared by jobs running concurrently.
+ *
+ * File layout (as written by the host):
+ *   file header: char[8] "SVFITRC3", the last character giving the version of the layout, uint64 numSlots, uint64 slotSize
+ *   followed by numSlots slots, each consisting of
+ *   uint64 key (0 for empty slots), double probMax, double integral, double integralErr, double acceptanceRate, double massStatErr,
+ *   uint32 flags (bit 0: isValidSolution, bit 1: isRefined), uint32 numQuantities,
+ *   and 7 doubles (cf. HistogramProperties) for each of maxNumQuantities quantities.
+ * Files written with a different version of the layout are rejected.
+ *
+ */
+
+#include "TauAnalysis/ClassicSVfit/interface/svFitHistogramAdapter.h"
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+namespace classic_svFit
+{
+  /// results of the SVfit algorithm for one event, as needed to restore the state of the histogram adapter
+  struct SVfitCachedResult
+  {
+    SVfitCachedResult();
+    double probMax_;
+    bool isValidSolution_;
+    double integral_;
+    double integralErr_;
+    double acceptanceRate_;
+    double massStatErr_;
+    bool isRefined_;
+    std::vector<HistogramProperties> properties_;
+  };
+
+  class SVfitResultCache
+  {
+   public:
+    SVfitResultCache(unsigned long capacity = 10000, const std::string& fileName = "", unsigned long numFileSlots = 65536);
+    ~SVfitResultCache();
+
+    /// look up result for given key, in memory first and then in the file;
+    /// returns false if no result is cached
+    bool find(uint64_t key, SVfitCachedResult& result);
+
+    /// add result for given key
+    void insert(uint64_t key, const SVfitCachedResult& result);
+
+    unsigned long getNumHits() const { return numHits_; }
+    unsigned long getNumMisses() const { return numMisses_; }
+
+    /// maximum number of quantities per result that can be stored in the file
+    static const unsigned maxNumQuantities = 16;
+
+   private:
+    void insertInMemory(uint64_t key, const SVfitCachedResult& result);
+    bool findInFile(uint64_t key, SVfitCachedResult& result) const;
+    void insertInFile(uint64_t key, const SVfitCachedResult& result);
+    char* getSlot(uint64_t key) const;
+
+    typedef std::list<std::pair<uint64_t, SVfitCachedResult>> EntryList;
+    EntryList entries_; // most recently used first
+    std::unordered_map<uint64_t, EntryList::iterator> index_;
+    unsigned long capacity_;
+
+    int fd_;
+    char* fileData_;
+    size_t fileSize_;
+    unsigned long numFileSlots_;
+
+    unsigned long numHits_;
+    unsigned long numMisses_;
+  };
+}
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef TauAnalysis_ClassicSVfit_svFitRingBuffer_h
+#define TauAnalysis_ClassicSVfit_svFitRingBuffer_h
+
+/** \class SPSCRingBuffer
+ *
+ * Lock-free ring buffer of fixed capacity,
+ * for passing objects from exactly one producer thread to exactly one consumer thread.
+ *
+ * The producer only writes the head index and the consumer only writes the tail index,
+ * so that both threads can access the buffer concurrently without locks.
+ *
+ */
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+namespace classic_svFit
+{
+  template <typename T>
+  class SPSCRingBuffer
+  {
+   public:
+    /// the capacity is rounded up to the next power of two
+    SPSCRingBuffer(size_t capacity)
+      : head_(0)
+      , tail_(0)
+    {
+      size_t capacity_pow2 = 1;
+      while ( capacity_pow2 < capacity ) capacity_pow2 *= 2;
+      buffer_.resize(capacity_pow2);
+      mask_ = capacity_pow2 - 1;
+    }
+
+    /// add object to buffer (producer thread only);
+    /// returns false if the buffer is full
+    bool push(const T& item)
+    {
+      size_t head = head_.load(std::memory_order_relaxed);
+      if ( (head - tail_.load(std::memory_order_acquire)) > mask_ ) return false;
+      buffer_[head & mask_] = item;
+      head_.store(head + 1, std::memory_order_release);
+      return true;
+    }
+
+    /// remove object from buffer (consumer thread only);
+    /// returns false if the buffer is empty
+    bool pop(T& item)
+    {
+      size_t tail = tail_.load(std::memory_order_relaxed);
+      if ( tail == head_.load(std::memory_order_acquire) ) return false;
+      item = buffer_[tail & mask_];
+      tail_.store(tail + 1, std::memory_order_release);
+      return true;
+    }
+
+    size_t capacity() const { return buffer_.size(); }
+
+   private:
+    std::vector<T> buffer_;
+    size_t mask_;
+
+    // CV: keep head and tail indices on separate cache lines,
+    //     to avoid "false sharing" between producer and consumer thread
+    static const size_t cacheLineSize = 64;
+    char padding0_[cacheLineSize];
+    std::atomic<size_t> head_;
+    char padding1_[cacheLineSize - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> tail_;
+    char padding2_[cacheLineSize - sizeof(std::atomic<size_t>)];
+  };
+}
+
+#endif
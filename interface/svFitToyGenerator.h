@@ -0,0 +1,152 @@
+#ifndef TauAnalysis_ClassicSVfit_svFitToyGenerator_h
+#define TauAnalysis_ClassicSVfit_svFitToyGenerator_h
+
+/** \class SVfitToyGenerator
+ *
+ * Generates H/Z -> tau tau events for benchmarks and closure tests of the SVfit algorithm,
+ * without the need for simulated events of an experiment.
+ *
+ * The mass of the resonance is distributed according to a Breit-Wigner distribution,
+ * its pT according to an exponential distribution and its rapidity uniformly.
+ * The resonance decays isotropically into two tau leptons; spin correlations are not simulated.
+ * The tau leptons decay isotropically in their restframe:
+ *   - leptonic decays tau -> l nu nu according to the energy spectrum of the lepton for massless leptons (Michel spectrum),
+ *     with the two neutrinos forming a system of the mass required by energy and momentum conservation;
+ *   - hadronic decays tau -> h nu into one-prong (pi or rho) and three-prong (a1) final states,
+ *     with the mass of the rho and a1 distributed according to Breit-Wigner distributions within 0.3 and 1.5 GeV.
+ * If the decay type of the first leg is kPrompt, the resonance decays into a prompt muon and a tau lepton
+ * (lepton-flavor-violating H -> mu tau decays).
+ * The momenta of the visible tau decay products are not smeared.
+ * The MET is given by the sum of neutrino momenta, smeared according to a covariance matrix
+ * that is generated randomly for each event.
+ *
+ * The events can be written to and read from binary files (cf. SVfitToyEventWriter, SVfitToyEventReader).
+ *
+ * File layout (little-endian, as written by the host):
+ *   file header: char[8] "SVFITEV1"
+ *   followed by any number of events, each consisting of
+ *   uint64 eventId, double trueMass, double genMETx, double genMETy,
+ *   double measuredMETx, double measuredMETy, double covMETxx, double covMETxy, double covMETyy,
+ *   and for each of the two legs int32 type, int32 decayMode, double pt, double eta, double phi, double mass
+ *
+ */
+
+#include "TauAnalysis/ClassicSVfit/interface/MeasuredTauLepton.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitAuxFunctions.h" // LorentzVector, Matrix2x2
+
+#include <TRandom3.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace classic_svFit
+{
+  /// generated event: measured leptons and MET, as passed to ClassicSVfit::integrate, and the true values
+  struct SVfitToyEvent
+  {
+    SVfitToyEvent();
+
+    uint64_t eventId_;
+
+    /// true mass of the tau pair and true MET (sum of neutrino momenta)
+    double trueMass_;
+    double genMETx_;
+    double genMETy_;
+
+    /// measured leptons, MET and MET covariance matrix
+    std::vector<MeasuredTauLepton> measuredTauLeptons_;
+    double measuredMETx_;
+    double measuredMETy_;
+    Matrix2x2 covMET_;
+  };
+
+  class SVfitToyGenerator
+  {
+   public:
+    /// decay type kUndefinedDecayType generates decays according to the tau branching fractions
+    SVfitToyGenerator(int decayType1 = MeasuredTauLepton::kUndefinedDecayType, int decayType2 = MeasuredTauLepton::kUndefinedDecayType, unsigned seed = 12345);
+    ~SVfitToyGenerator();
+
+    /// set mass and width of the resonance (default is 125 GeV, no width)
+    void setMass(double mass, double width = 0.);
+
+    /// set mean pT and maximum rapidity of the resonance (default is 30 GeV and 2.5)
+    void setResonanceKinematics(double meanPt, double maxRapidity);
+
+    /// set range of the resolution (in GeV) along the two principal axes of the MET covariance matrix (default is 15 to 30 GeV)
+    void setMETResolution(double minSigma, double maxSigma);
+
+    /// set minimum pT of electrons and muons, minimum pT of hadronic tau decays and maximum |eta| of all legs
+    /// (default is 20 GeV, 30 GeV and 2.3)
+    void setAcceptanceCuts(double minPt_lep, double minPt_had, double maxAbsEta);
+
+    /// generate next event that passes the acceptance cuts
+    void generate(SVfitToyEvent& event);
+
+    /// number of events generated and passing the acceptance cuts
+    unsigned long getNumEventsGenerated() const { return numEventsGenerated_; }
+    unsigned long getNumEventsAccepted() const { return numEventsAccepted_; }
+
+   private:
+    /// choose decay type and, for hadronic tau decays, decay mode and mass of the visible decay products
+    void generateDecayType(int requestedDecayType, int& decayType, int& decayMode, double& visMass);
+
+    /// decay particle of given momentum into visible decay products and neutrinos
+    void generateTauDecay(const LorentzVector& tauP4, int decayType, double visMass, LorentzVector& visP4, LorentzVector& nuP4);
+
+    /// momentum of particles with given masses in two-body decay of a particle of mass M, in its restframe
+    double compMomentum_twoBodyDecay(double M, double m1, double m2) const;
+
+    /// vector of given magnitude pointing in random direction
+    Vector generateDirection(double p);
+
+    bool isAccepted(const LorentzVector& visP4, int decayType) const;
+
+    int decayType1_;
+    int decayType2_;
+
+    double mass_;
+    double width_;
+    double meanPt_;
+    double maxRapidity_;
+    double minSigmaMET_;
+    double maxSigmaMET_;
+    double minPt_lep_;
+    double minPt_had_;
+    double maxAbsEta_;
+
+    TRandom3 rnd_;
+
+    unsigned long numEventsGenerated_;
+    unsigned long numEventsAccepted_;
+  };
+
+  class SVfitToyEventWriter
+  {
+   public:
+    SVfitToyEventWriter(const std::string& fileName);
+    ~SVfitToyEventWriter();
+
+    void write(const SVfitToyEvent& event);
+
+   private:
+    std::ofstream file_;
+  };
+
+  class SVfitToyEventReader
+  {
+   public:
+    SVfitToyEventReader(const std::string& fileName);
+    ~SVfitToyEventReader();
+
+    /// read next event; returns false at the end of the file
+    bool read(SVfitToyEvent& event);
+
+   private:
+    std::ifstream file_;
+  };
+}
+
+#endif
@@ -20,12 +20,71 @@ namespace
   {
     return ClassicSVfitIntegrand::gSVfitIntegrand->Eval(x);
   }
+
+  /// observer filling the histograms of the di-tau system
+  /// with the four-vectors of the tau leptons computed by the integrand
+  class HistogramAdapterObserver
+  {
+   public:
+    HistogramAdapterObserver(const HistogramAdapterDiTau* histogramAdapter)
+      : histogramAdapter_(histogramAdapter)
+    {}
+
+    void operator()(const MarkovChainState& state) const
+    {
+      if ( state.isBurnin_ ) histogramAdapter_->fillBurnin(*state.tau1P4_, *state.tau2P4_);
+      else histogramAdapter_->fill(*state.tau1P4_, *state.tau2P4_);
+    }
+
+   private:
+    const HistogramAdapterDiTau* histogramAdapter_;
+  };
+
+  /// observer passing the four-vectors of the tau leptons computed by the integrand
+  /// to the thread filling the histograms of the di-tau system
+  class HistogramPipelineObserver
+  {
+   public:
+    HistogramPipelineObserver(HistogramPipelineDiTau* histogramPipeline)
+      : histogramPipeline_(histogramPipeline)
+    {}
+
+    void operator()(const MarkovChainState& state) const
+    {
+      histogramPipeline_->push(*state.tau1P4_, *state.tau2P4_, state.isBurnin_);
+    }
+
+   private:
+    HistogramPipelineDiTau* histogramPipeline_;
+  };
+
+  /// observer computing the batch medians of the mass of the di-tau system,
+  /// in order to estimate its statistical uncertainty (does nothing if no target precision is set)
+  class MassBatchObserver
+  {
+   public:
+    MassBatchObserver(SVfitBatchMeans* massBatchMeans)
+      : massBatchMeans_(massBatchMeans)
+    {}
+
+    void operator()(const MarkovChainState& state) const
+    {
+      if ( !massBatchMeans_ || state.isBurnin_ ) return;
+      massBatchMeans_->fill((*state.tau1P4_ + *state.tau2P4_).mass());
+    }
+
+   private:
+    SVfitBatchMeans* massBatchMeans_;
+  };
 }
 
 ClassicSVfit::ClassicSVfit(int verbosity)
   : ClassicSVfitBase(verbosity)
   , diTauMassConstraint_(-1.)
   , histogramAdapter_(new HistogramAdapterDiTau("ditau"))
+  , massBatchMeans_(SVfitBatchMeans::kMedian)
+  , usePipelinedFill_(false)
+  , histogramPipeline_(nullptr)
 {
   integrand_ = new ClassicSVfitIntegrand(verbosity_);
   legIntegrationParams_.resize(2);
@@ -35,6 +94,7 @@ ClassicSVfit::ClassicSVfit(int verbosity)
 
 ClassicSVfit::~ClassicSVfit()
 {
+  delete histogramPipeline_;
   delete histogramAdapter_;
 }
 
@@ -44,12 +104,6 @@ void ClassicSVfit::setDiTauMassConstraint(double diTauMass)
   (static_cast<ClassicSVfitIntegrand*>(integrand_))->setDiTauMassConstraint(diTauMassConstraint_);
 }
 
-void ClassicSVfit::initializeMCIntegrator()
-{
-  ClassicSVfitBase::initializeMCIntegrator();
-  intAlgo_->registerCallBackFunction(*histogramAdapter_);
-}
-
 void ClassicSVfit::setIntegrationParams(bool useDiTauMassConstraint)
 {
   numDimensions_ = 0;
@@ -60,10 +114,15 @@ void ClassicSVfit::setIntegrationParams(bool useDiTauMassConstraint)
   if ( verbosity_ >= 1 ) printIntegrationRange();
 }
 
+void ClassicSVfit::hashInputs(SVfitHash& hash) const
+{
+  ClassicSVfitBase::hashInputs(hash);
+  histogramAdapter_->hashConfiguration(hash);
+}
+
 void ClassicSVfit::prepareIntegrand()
 {
   integrand_->setLeptonInputs(measuredTauLeptons_);
-  (static_cast<ClassicSVfitIntegrand*>(integrand_))->setHistogramAdapter(histogramAdapter_);
 #ifdef USE_SVFITTF
   if ( useHadTauTF_ ) integrand_->enableHadTauTF();
   else integrand_->disableHadTauTF();
@@ -93,14 +152,57 @@ void ClassicSVfit::prepareLeptonInput(const std::vector<MeasuredTauLepton>& meas
   }
 }
 
-void ClassicSVfit::integrate(const std::vector<MeasuredTauLepton>& measuredTauLeptons,
-			     double measuredMETx, double measuredMETy,
-			     const TMatrixD& covMET)
+bool ClassicSVfit::isRefinementNeeded() const
+{
+  double mass = histogramAdapter_->getMass();
+  if ( !(mass > 0.) ) return true;
+  if ( refinementSettings_.maxMassStatErr_ > 0. && massBatchMeans_.getMeanErr() > refinementSettings_.maxMassStatErr_*massBatchMeans_.getMean() ) return true;
+  double massErr = histogramAdapter_->getMassErr();
+  return ( (mass - refinementSettings_.numSigma_*massErr) <= refinementSettings_.massMax_ &&
+           (mass + refinementSettings_.numSigma_*massErr) >= refinementSettings_.massMin_ );
+}
+
+template <typename... Observers>
+void ClassicSVfit::extendSampling(double& integral, double& integralErr, Observers&... observers)
+{
+//--- without target precision, continue the sampling of refined events up to the number of function calls of the decay channel
+  if ( !(precisionSettings_.targetMassPrecision_ > 0.) ) {
+    unsigned long numIntegrandCalls = intAlgo_->getNumIntegrandCalls();
+    if ( numIntegrandCalls < maxObjFunctionCalls_refined_ ) {
+      intAlgo_->continueIntegration(maxObjFunctionCalls_refined_ - numIntegrandCalls, integral, integralErr, observers...);
+    }
+    return;
+  }
+
+//--- CV: the statistical uncertainty of the mass decreases with the square root of the number of samples;
+//        extend the sampling by the estimated number of iterations needed to reach the target precision, plus a margin of 20%,
+//        and repeat until the target precision or the maximum number of integrand evaluations is reached
+  while ( !intAlgo_->isStoppedByTimeBudget() && massBatchMeans_.getNumBatches() >= 2 ) {
+    double mass = massBatchMeans_.getMean();
+    double massErr = massBatchMeans_.getMeanErr();
+    double targetMassErr = precisionSettings_.targetMassPrecision_*mass;
+    if ( !(mass > 0.) || massErr <= targetMassErr ) break;
+    unsigned long numIntegrandCalls = intAlgo_->getNumIntegrandCalls();
+    if ( numIntegrandCalls + intAlgo_->getNumIterPerBatch() > precisionSettings_.maxObjFunctionCalls_ ) break;
+    double numIterSampling = 1.2*massBatchMeans_.getNumValues()*(square(massErr/targetMassErr) - 1.);
+    numIterSampling = std::min(numIterSampling, double(precisionSettings_.maxObjFunctionCalls_ - numIntegrandCalls));
+    intAlgo_->continueIntegration(TMath::Nint(numIterSampling), integral, integralErr, observers...);
+  }
+}
+
+SVfitResult ClassicSVfit::integrate(const std::vector<MeasuredTauLepton>& measuredTauLeptons,
+				    double measuredMETx, double measuredMETy,
+				    const TMatrixD& covMET)
 {
   if ( verbosity_ >= 1 ) std::cout << "<ClassicSVfit::integrate>:" << std::endl;
 
-  clock_->Reset();
-  clock_->Start("<ClassicSVfit::integrate>");
+  // CV: the time budget includes the preparation of the integration, so start the clock together with the profiler
+  SVfitIntegratorMarkovChain::Clock::time_point startTime;
+  if ( timeBudget_ > 0. ) startTime = SVfitIntegratorMarkovChain::Clock::now();
+  profiler_.startEvent();
+  profiler_.setStage(SVfitProfile::kPrepareInputs);
+
+  startEvent();
 
   prepareLeptonInput(measuredTauLeptons);
   integrand_->clearMET();
@@ -108,7 +210,16 @@ void ClassicSVfit::integrate(const std::vector<MeasuredTauLepton>& measuredTauLe
   bool useDiTauMassConstraint = (diTauMassConstraint_ > 0);
   setIntegrationParams(useDiTauMassConstraint);
   prepareIntegrand();
-  if ( !intAlgo_ ) initializeMCIntegrator();
+  selectIntegratorSettings();
+  intAlgo_->setEventId(eventId_);
+  intAlgo_->setSeed(getSeed());
+  intAlgo_->setTimeBudget(timeBudget_);
+  if ( timeBudget_ > 0. ) intAlgo_->setStartTime(startTime);
+  intAlgo_->setProfiler(( profiler_.isEnabled() ) ? &profiler_ : nullptr);
+  // CV: the observers use the burnin iterations for the adaptive binning only
+  intAlgo_->setObserveBurnin(histogramAdapter_->needsBurnin());
+  const ClassicSVfitIntegrand* integrand = static_cast<const ClassicSVfitIntegrand*>(integrand_);
+  intAlgo_->setTauP4s(&integrand->getTau1P4(), &integrand->getTau2P4());
 
   // CV: book histograms for evaluation of pT, eta, phi, mass and transverse mass of di-tau system
   if ( measuredTauLeptons_.size() == 2 ) {
@@ -116,23 +227,150 @@ void ClassicSVfit::integrate(const std::vector<MeasuredTauLepton>& measuredTauLe
     met_.SetY(measuredMETy);
     histogramAdapter_->setMeasurement(measuredTauLeptons_[0].p4(), measuredTauLeptons_[1].p4(), met_);
     histogramAdapter_->bookHistograms(measuredTauLeptons_[0].p4(), measuredTauLeptons_[1].p4(), met_);
+    // CV: the sampling may get extended beyond the number of function calls of the first integration,
+    //     by the refinement or up to the target precision, and the last batch may be completed beyond that number
+    unsigned long maxNumSamples = intAlgoSettings_.maxObjFunctionCalls_;
+    if ( useRefinement_ ) maxNumSamples = std::max(maxNumSamples, (unsigned long)maxObjFunctionCalls_refined_);
+    if ( precisionSettings_.targetMassPrecision_ > 0. ) maxNumSamples = std::max(maxNumSamples, (unsigned long)precisionSettings_.maxObjFunctionCalls_);
+    if ( maxNumSamples > intAlgoSettings_.maxObjFunctionCalls_ ) maxNumSamples += intAlgo_->getNumIterPerBatch();
+    histogramAdapter_->reserveSamples(maxNumSamples);
   } else assert(0);
   
-  double theIntegral, theIntegralErr;
-  intAlgo_->integrate(&g_C, xl_, xh_, numDimensions_, theIntegral, theIntegralErr);
-  isValidSolution_ = histogramAdapter_->isValidSolution();
+  // CV: take results from the cache if an event with the same inputs has been processed before
+  bool useCache = useResultCache();
+  uint64_t resultCacheKey = 0;
+  SVfitCachedResult cachedResult;
+  bool isCached = false;
+  double theIntegral = 0.;
+  double theIntegralErr = 0.;
+  unsigned long numIntegrandCalls = 0;
+  double acceptanceRate = 0.;
+  bool isStoppedByTimeBudget = false;
+  double massStatErr = 0.;
+  bool isRefined = false;
+  if ( useCache ) {
+    SVfitHash hash;
+    hashInputs(hash);
+    resultCacheKey = hash.getValue();
+    isCached = resultCache_->find(resultCacheKey, cachedResult);
+  }
+
+  if ( isCached ) {
+    histogramAdapter_->setHistogramProperties(cachedResult.properties_, 0);
+    isValidSolution_ = cachedResult.isValidSolution_;
+    probMax_ = cachedResult.probMax_;
+    theIntegral = cachedResult.integral_;
+    theIntegralErr = cachedResult.integralErr_;
+    acceptanceRate = cachedResult.acceptanceRate_;
+    massStatErr = cachedResult.massStatErr_;
+    isRefined = cachedResult.isRefined_;
+  } else {
+    bool useTargetPrecision = ( precisionSettings_.targetMassPrecision_ > 0. );
+    bool useBatchMeans = ( useTargetPrecision || (useRefinement_ && refinementSettings_.maxMassStatErr_ > 0.) );
+    if ( useBatchMeans ) massBatchMeans_.reset(std::max((unsigned long)minNumIterPerMassBatch, (unsigned long)intAlgo_->getNumIterPerBatch()));
+    MassBatchObserver massBatchObserver(( useBatchMeans ) ? &massBatchMeans_ : nullptr);
+    if ( usePipelinedFill_ ) {
+      if ( !histogramPipeline_ ) histogramPipeline_ = new HistogramPipelineDiTau();
+      histogramPipeline_->start(histogramAdapter_);
+      HistogramPipelineObserver histogramPipelineObserver(histogramPipeline_);
+      intAlgo_->integrate(&g_C, xl_, xh_, numDimensions_, theIntegral, theIntegralErr, histogramPipelineObserver, massBatchObserver);
+      profiler_.setStage(SVfitProfile::kHistogramFill);
+      histogramPipeline_->stop();
+      // CV: the histograms of the coarse integration need to be filled completely before the decision on the refinement is taken
+      isRefined = ( useRefinement_ && isRefinementNeeded() );
+      if ( isRefined || (useTargetPrecision && !useRefinement_) ) {
+        histogramPipeline_->start(histogramAdapter_);
+        extendSampling(theIntegral, theIntegralErr, histogramPipelineObserver, massBatchObserver);
+        profiler_.setStage(SVfitProfile::kHistogramFill);
+        histogramPipeline_->stop();
+      }
+    } else {
+      HistogramAdapterObserver histogramAdapterObserver(histogramAdapter_);
+      intAlgo_->integrate(&g_C, xl_, xh_, numDimensions_, theIntegral, theIntegralErr, histogramAdapterObserver, massBatchObserver);
+      isRefined = ( useRefinement_ && isRefinementNeeded() );
+      if ( isRefined || (useTargetPrecision && !useRefinement_) ) extendSampling(theIntegral, theIntegralErr, histogramAdapterObserver, massBatchObserver);
+    }
+    if ( useBatchMeans ) massStatErr = massBatchMeans_.getMeanErr();
+    isValidSolution_ = histogramAdapter_->isValidSolution();
+    probMax_ = intAlgo_->getProbMax();
+    numIntegrandCalls = intAlgo_->getNumIntegrandCalls();
+    acceptanceRate = intAlgo_->getAcceptanceRate();
+    isStoppedByTimeBudget = intAlgo_->isStoppedByTimeBudget();
+    profiler_.count(SVfitProfile::kIntegrandCalls, numIntegrandCalls);
+    profiler_.count(SVfitProfile::kZeroProbability, intAlgo_->getNumIntegrandCalls_zeroProb());
+    profiler_.count(SVfitProfile::kMovesAccepted, intAlgo_->getNumMovesAccepted());
+    profiler_.count(SVfitProfile::kMovesRejected, intAlgo_->getNumMovesRejected());
+    profiler_.count(SVfitProfile::kStartPositionRetries, intAlgo_->getNumStartPositionRetries());
+#ifdef USE_REJECTION_COUNTERS
+    rejectionCounts_[getChannelName()].add(integrand_->getRejectionCounts());
+#endif
+
+    if ( useCache ) {
+      cachedResult.isValidSolution_ = isValidSolution_;
+      cachedResult.probMax_ = probMax_;
+      cachedResult.integral_ = theIntegral;
+      cachedResult.integralErr_ = theIntegralErr;
+      cachedResult.acceptanceRate_ = acceptanceRate;
+      cachedResult.massStatErr_ = massStatErr;
+      cachedResult.isRefined_ = isRefined;
+      histogramAdapter_->getHistogramProperties(cachedResult.properties_);
+      resultCache_->insert(resultCacheKey, cachedResult);
+    }
+  }
   
+  profiler_.setStage(SVfitProfile::kExtractStatistics);
+  fillResult(theIntegral, theIntegralErr, numIntegrandCalls, acceptanceRate, isStoppedByTimeBudget, massStatErr, isRefined);
+
   if ( likelihoodFileName_ != "" ) {
-    histogramAdapter_->writeHistograms(likelihoodFileName_);
+    profiler_.setStage(SVfitProfile::kFileOutput);
+    if ( !likelihoodArchive_ ) likelihoodArchive_ = new SVfitLikelihoodArchive(likelihoodFileName_);
+    histogramAdapter_->writeHistograms(*likelihoodArchive_, eventId_);
   }
   
-  clock_->Stop("<ClassicSVfit::integrate>");
-  numSeconds_cpu_ = clock_->GetCpuTime("<ClassicSVfit::integrate>");
-  numSeconds_real_ = clock_->GetRealTime("<ClassicSVfit::integrate>");
+  profiler_.stopEvent();
+  numSeconds_cpu_ = profiler_.getEventProfile().numSeconds_cpu_;
+  numSeconds_real_ = profiler_.getEventProfile().numSeconds_real_;
+  result_.numSeconds_cpu_ = numSeconds_cpu_;
+  result_.numSeconds_real_ = numSeconds_real_;
   
   if ( verbosity_ >= 1 ) {
-    clock_->Show("<ClassicSVfit::integrate>");
+    std::cout << "<ClassicSVfit::integrate>: Real Time = " << numSeconds_real_ << " seconds Cpu Time = " << numSeconds_cpu_ << " seconds" << std::endl;
   }
+
+  return result_;
+}
+
+void ClassicSVfit::fillResult(double integral, double integralErr, unsigned long numIntegrandCalls, double acceptanceRate, bool isStoppedByTimeBudget,
+                              double massStatErr, bool isRefined)
+{
+  result_.pt_ = histogramAdapter_->getPt();
+  result_.ptErr_ = histogramAdapter_->getPtErr();
+  result_.ptLmax_ = histogramAdapter_->getPtLmax();
+  result_.eta_ = histogramAdapter_->getEta();
+  result_.etaErr_ = histogramAdapter_->getEtaErr();
+  result_.etaLmax_ = histogramAdapter_->getEtaLmax();
+  result_.phi_ = histogramAdapter_->getPhi();
+  result_.phiErr_ = histogramAdapter_->getPhiErr();
+  result_.phiLmax_ = histogramAdapter_->getPhiLmax();
+  result_.mass_ = histogramAdapter_->getMass();
+  result_.massErr_ = histogramAdapter_->getMassErr();
+  result_.massLmax_ = histogramAdapter_->getMassLmax();
+  result_.massStatErr_ = massStatErr;
+  result_.transverseMass_ = histogramAdapter_->getTransverseMass();
+  result_.transverseMassErr_ = histogramAdapter_->getTransverseMassErr();
+  result_.transverseMassLmax_ = histogramAdapter_->getTransverseMassLmax();
+  LorentzVector tau1P4 = histogramAdapter_->tau1()->getP4();
+  tau1P4.GetCoordinates(result_.tau1P4_);
+  LorentzVector tau2P4 = histogramAdapter_->tau2()->getP4();
+  tau2P4.GetCoordinates(result_.tau2P4_);
+  result_.isValidSolution_ = isValidSolution_;
+  result_.integral_ = integral;
+  result_.integralErr_ = integralErr;
+  result_.probMax_ = probMax_;
+  result_.numIntegrandCalls_ = numIntegrandCalls;
+  result_.acceptanceRate_ = acceptanceRate;
+  result_.isStoppedByTimeBudget_ = isStoppedByTimeBudget;
+  result_.isRefined_ = isRefined;
 }
 
 void ClassicSVfit::setHistogramAdapter(classic_svFit::HistogramAdapterDiTau* histogramAdapter)
@@ -145,3 +383,13 @@ classic_svFit::HistogramAdapterDiTau* ClassicSVfit::getHistogramAdapter() const
 {
   return histogramAdapter_;
 }
+
+void ClassicSVfit::enablePipelinedFill()
+{
+  usePipelinedFill_ = true;
+}
+
+void ClassicSVfit::disablePipelinedFill()
+{
+  usePipelinedFill_ = false;
+}
@@ -7,6 +7,7 @@
 #include <TMatrixD.h>
 #include <TMatrixDSym.h>
 #include <TMatrixDSymEigen.h>
+#include <TString.h>
 #include <TVectorD.h>
 
 #include <algorithm>
@@ -16,34 +17,51 @@ using namespace classic_svFit;
 ClassicSVfitBase::ClassicSVfitBase(int verbosity)
   : integrand_(0)
   , intAlgo_(0)
-  , maxObjFunctionCalls_(100000)
-  , treeFileName_("")
+  , useRefinement_(false)
+  , maxObjFunctionCalls_refined_(0)
+  , timeBudget_(0.)
   , likelihoodFileName_("")
+  , treeFileName_("")
+  , chainTreeWriter_(nullptr)
+  , eventId_(0)
+  , nextEventId_(0)
+  , useEventSeeding_(false)
+  , likelihoodArchive_(nullptr)
+  , chainFileName_("")
+  , chainThinning_(1)
+  , chainRecorder_(nullptr)
+  , resultCache_(nullptr)
   , numDimensions_(0)
   , xl_(nullptr)
   , xh_(nullptr)
   , isValidSolution_(false)
+  , probMax_(0.)
   , useHadTauTF_(false)
-  , clock_(nullptr)
+  , addLogM_dynamic_formula_(nullptr)
   , numSeconds_cpu_(-1.)
   , numSeconds_real_(-1.)
   , verbosity_(verbosity)
 {
-  clock_ = new TBenchmark();
+  intAlgos_.reserve(maxNumIntegrators);
 }
 
 ClassicSVfitBase::~ClassicSVfitBase()
 {
   delete integrand_;
 
-  if ( intAlgo_ ) {
-    delete intAlgo_;
+  for ( std::vector<IntegratorCacheEntry>::iterator intAlgo = intAlgos_.begin();
+        intAlgo != intAlgos_.end(); ++intAlgo ) {
+    delete intAlgo->second;
   }
+  delete chainRecorder_;
+  delete chainTreeWriter_;
+  delete likelihoodArchive_;
+  delete resultCache_;
 
   delete [] xl_;
   delete [] xh_;
 
-  delete clock_;
+  delete addLogM_dynamic_formula_;
 }
 
 void ClassicSVfitBase::setVerbosity(int aVerbosity)
@@ -59,7 +77,18 @@ void ClassicSVfitBase::addLogM_fixed(bool value, double power)
 
 void ClassicSVfitBase::addLogM_dynamic(bool value, const std::string& power)
 {
-  integrand_->addLogM_dynamic(value, power);
+  if ( value && power != "" ) {
+    TString power_tstring = power.data();
+    power_tstring = power_tstring.ReplaceAll("m", "x");
+    power_tstring = power_tstring.ReplaceAll("mass", "x");
+    std::string formulaName = "ClassicSVfitIntegrand_addLogM_dynamic_formula";
+    TFormula* addLogM_dynamic_formula = new TFormula(formulaName.data(), power_tstring.Data());
+    integrand_->addLogM_dynamic(value, power, [addLogM_dynamic_formula](double mTauTau) { return addLogM_dynamic_formula->Eval(mTauTau); });
+    delete addLogM_dynamic_formula_;
+    addLogM_dynamic_formula_ = addLogM_dynamic_formula;
+  } else {
+    integrand_->addLogM_dynamic(value, power);
+  }
 }
 
 #ifdef USE_SVFITTF
@@ -89,7 +118,58 @@ void ClassicSVfitBase::setRhoHadTau(double rhoHadTau)
 
 void ClassicSVfitBase::setMaxObjFunctionCalls(unsigned maxObjFunctionCalls)
 {
-  maxObjFunctionCalls_ = maxObjFunctionCalls;
+  integratorSettings_.maxObjFunctionCalls_ = maxObjFunctionCalls;
+}
+
+void ClassicSVfitBase::setTimeBudget(double timeBudget)
+{
+  timeBudget_ = timeBudget;
+}
+
+void ClassicSVfitBase::setIntegratorSettings(const SVfitIntegratorSettings& integratorSettings)
+{
+  integratorSettings_ = integratorSettings;
+}
+
+const SVfitIntegratorSettings& ClassicSVfitBase::getIntegratorSettings() const
+{
+  return integratorSettings_;
+}
+
+void ClassicSVfitBase::setPrecision(const SVfitPrecisionSettings& precisionSettings)
+{
+  precisionSettings_ = precisionSettings;
+}
+
+void ClassicSVfitBase::setPrecision(const std::string& presetName)
+{
+  precisionSettings_ = SVfitPrecisionSettings::getPreset(presetName);
+}
+
+const SVfitPrecisionSettings& ClassicSVfitBase::getPrecision() const
+{
+  return precisionSettings_;
+}
+
+void ClassicSVfitBase::enableRefinement(const SVfitRefinementSettings& refinementSettings)
+{
+  useRefinement_ = true;
+  refinementSettings_ = refinementSettings;
+}
+
+void ClassicSVfitBase::disableRefinement()
+{
+  useRefinement_ = false;
+}
+
+void ClassicSVfitBase::loadIntegratorPresets(const std::string& presetsFileName)
+{
+  integratorPresets_.load(presetsFileName);
+}
+
+void ClassicSVfitBase::setIntegratorPresets(const SVfitIntegratorPresets& integratorPresets)
+{
+  integratorPresets_ = integratorPresets;
 }
 
 void ClassicSVfitBase::setLikelihoodFileName(const std::string& likelihoodFileName)
@@ -102,11 +182,113 @@ void ClassicSVfitBase::setTreeFileName(const std::string& treeFileName)
   treeFileName_ = treeFileName;
 }
 
+void ClassicSVfitBase::setEventId(unsigned long long eventId)
+{
+  nextEventId_ = eventId;
+}
+
+unsigned long long ClassicSVfitBase::getEventId() const
+{
+  return eventId_;
+}
+
+void ClassicSVfitBase::startEvent()
+{
+  eventId_ = nextEventId_;
+  nextEventId_ = eventId_ + 1;
+}
+
+void ClassicSVfitBase::enableEventSeeding()
+{
+  useEventSeeding_ = true;
+}
+
+void ClassicSVfitBase::disableEventSeeding()
+{
+  useEventSeeding_ = false;
+}
+
+unsigned ClassicSVfitBase::getSeed() const
+{
+  const unsigned defaultSeed = 12345;
+  if ( !useEventSeeding_ ) return defaultSeed;
+  SVfitHash hash;
+  hash.add(eventId_);
+  uint64_t value = hash.getValue();
+  unsigned seed = static_cast<unsigned>(value ^ (value >> 32));
+  // CV: TRandom3 takes seed 0 to mean a seed derived from the system clock
+  return ( seed != 0 ) ? seed : defaultSeed;
+}
+
+void ClassicSVfitBase::setChainFileName(const std::string& chainFileName, unsigned thinning)
+{
+  chainFileName_ = chainFileName;
+  chainThinning_ = thinning;
+}
+
+void ClassicSVfitBase::enableResultCache(unsigned long capacity, const std::string& resultCacheFileName)
+{
+  delete resultCache_;
+  resultCache_ = new SVfitResultCache(capacity, resultCacheFileName);
+}
+
+void ClassicSVfitBase::disableResultCache()
+{
+  delete resultCache_;
+  resultCache_ = nullptr;
+}
+
+const SVfitResultCache* ClassicSVfitBase::getResultCache() const
+{
+  return resultCache_;
+}
+
+bool ClassicSVfitBase::useResultCache() const
+{
+  // CV: with a time budget, the number of function calls depends on the speed of the machine
+  return ( resultCache_ && likelihoodFileName_ == "" && treeFileName_ == "" && chainFileName_ == "" && !(timeBudget_ > 0.) );
+}
+
+void ClassicSVfitBase::hashInputs(SVfitHash& hash) const
+{
+  intAlgoSettings_.hash(hash);
+  precisionSettings_.hash(hash);
+  if ( useRefinement_ ) refinementSettings_.hash(hash);
+  hash.add(getSeed());
+  hash.add(static_cast<unsigned>(measuredTauLeptons_.size()));
+  for ( std::vector<MeasuredTauLepton>::const_iterator measuredTauLepton = measuredTauLeptons_.begin();
+        measuredTauLepton != measuredTauLeptons_.end(); ++measuredTauLepton ) {
+    hash.add(measuredTauLepton->type());
+    hash.add(measuredTauLepton->pt());
+    hash.add(measuredTauLepton->eta());
+    hash.add(measuredTauLepton->phi());
+    hash.add(measuredTauLepton->mass());
+    hash.add(measuredTauLepton->decayMode());
+  }
+  integrand_->hashInputs(hash);
+}
+
+SVfitApproximation ClassicSVfitBase::approximate(const std::vector<MeasuredTauLepton>& measuredTauLeptons,
+                                                double measuredMETx, double measuredMETy, const TMatrixD& covMET) const
+{
+  if ( measuredTauLeptons.size() != 2 ) {
+    std::cerr << "<ClassicSVfitBase::approximate>:"
+              << "Invalid number of measured tau leptons = " << measuredTauLeptons.size() << ", expected 2 --> ABORTING !!\n";
+    assert(0);
+  }
+  return compApproximation(measuredTauLeptons, measuredMETx, measuredMETy, Matrix2x2(covMET[0][0], covMET[0][1], covMET[1][0], covMET[1][1]));
+}
+
 bool ClassicSVfitBase::isValidSolution() const 
 {
   return isValidSolution_;
 }
 
+const SVfitResult& ClassicSVfitBase::getResult() const
+{
+  return result_;
+}
+
 double ClassicSVfitBase::getComputingTime_cpu() const 
 {
   return numSeconds_cpu_;
@@ -117,25 +299,124 @@ double ClassicSVfitBase::getComputingTime_real() const
   return numSeconds_real_;
 }
 
+void ClassicSVfitBase::enableProfiling()
+{
+  profiler_.enable();
+}
+
+void ClassicSVfitBase::disableProfiling()
+{
+  profiler_.disable();
+}
+
+const SVfitProfile& ClassicSVfitBase::getEventProfile() const
+{
+  return profiler_.getEventProfile();
+}
+
+const SVfitProfile& ClassicSVfitBase::getProcessProfile() const
+{
+  return profiler_.getProcessProfile();
+}
+
+#ifdef USE_REJECTION_COUNTERS
+const SVfitRejectionCounts& ClassicSVfitBase::getEventRejectionCounts() const
+{
+  return integrand_->getRejectionCounts();
+}
+
+const std::map<std::string, SVfitRejectionCounts>& ClassicSVfitBase::getProcessRejectionCounts() const
+{
+  return rejectionCounts_;
+}
+
+void ClassicSVfitBase::printRejectionCounts(std::ostream& stream) const
+{
+  for ( std::map<std::string, SVfitRejectionCounts>::const_iterator channel = rejectionCounts_.begin();
+        channel != rejectionCounts_.end(); ++channel ) {
+    const SVfitRejectionCounts& counts = channel->second;
+    stream << "channel = " << channel->first << ": #evaluations = " << counts.numEvaluations_ << std::endl;
+    for ( int iReason = 0; iReason < SVfitRejectionCounts::kNumReasons; ++iReason ) {
+      double fraction = ( counts.numEvaluations_ > 0 ) ? double(counts.numRejections_[iReason])/counts.numEvaluations_ : 0.;
+      stream << " " << SVfitRejectionCounts::getReasonName(iReason) << " = " << counts.numRejections_[iReason]
+             << " (" << 100.*fraction << "%)" << std::endl;
+    }
+  }
+}
+
+#endif
+
+std::string ClassicSVfitBase::getChannelName() const
+{
+  return getDecayChannelName(measuredTauLeptons_);
+}
+
+void ClassicSVfitBase::selectIntegratorSettings()
+{
+  SVfitIntegratorSettings integratorSettings = integratorSettings_;
+  if ( !integratorPresets_.empty() ) {
+    const SVfitIntegratorSettings* integratorPreset = integratorPresets_.find(getChannelName());
+    if ( integratorPreset ) integratorSettings = *integratorPreset;
+  }
+  maxObjFunctionCalls_refined_ = integratorSettings.maxObjFunctionCalls_;
+  if ( useRefinement_ ) {
+    integratorSettings.maxObjFunctionCalls_ = refinementSettings_.numObjFunctionCallsCoarse_;
+  } else if ( precisionSettings_.targetMassPrecision_ > 0. && precisionSettings_.minObjFunctionCalls_ > 0 ) {
+    integratorSettings.maxObjFunctionCalls_ = precisionSettings_.minObjFunctionCalls_;
+  }
+  if ( intAlgo_ && integratorSettings == intAlgoSettings_ ) return;
+  // CV: keep the integrators for the most recently used settings, ordered by the time of their last use,
+  //     so that no memory is allocated when the settings alternate between events of different decay channels
+  for ( std::vector<IntegratorCacheEntry>::iterator intAlgo = intAlgos_.begin();
+        intAlgo != intAlgos_.end(); ++intAlgo ) {
+    if ( intAlgo->first == integratorSettings ) {
+      std::rotate(intAlgos_.begin(), intAlgo, intAlgo + 1);
+      intAlgo_ = intAlgos_.front().second;
+      intAlgoSettings_ = integratorSettings;
+      return;
+    }
+  }
+  if ( intAlgos_.size() >= maxNumIntegrators ) {
+    delete intAlgos_.back().second;
+    intAlgos_.pop_back();
+  }
+  intAlgo_ = 0;
+  intAlgoSettings_ = integratorSettings;
+  initializeMCIntegrator();
+  intAlgos_.insert(intAlgos_.begin(), IntegratorCacheEntry(intAlgoSettings_, intAlgo_));
+}
+
 void ClassicSVfitBase::initializeMCIntegrator()
 {
-  //unsigned numChains = TMath::Nint(maxObjFunctionCalls_/100000.);
+  //unsigned numChains = TMath::Nint(intAlgoSettings_.maxObjFunctionCalls_/100000.);
   unsigned numChains = 1;
-  unsigned numIterBurnin = TMath::Nint(0.10*maxObjFunctionCalls_/numChains);
-  unsigned numIterSampling = TMath::Nint(0.90*maxObjFunctionCalls_/numChains);
-  unsigned numIterSimAnnealingPhase1 = TMath::Nint(0.20*numIterBurnin);
-  unsigned numIterSimAnnealingPhase2 = TMath::Nint(0.60*numIterBurnin);
-  if ( treeFileName_ == "" && verbosity_ >= 2 ) {
-    treeFileName_ = "SVfitIntegratorMarkovChain_ClassicSVfit.root";
+  unsigned numIterBurnin = TMath::Nint(intAlgoSettings_.fractionBurnin_*intAlgoSettings_.maxObjFunctionCalls_/numChains);
+  unsigned numIterSampling = TMath::Nint((1. - intAlgoSettings_.fractionBurnin_)*intAlgoSettings_.maxObjFunctionCalls_/numChains);
+  // CV: the number of sampling iterations needs to be a multiple of the number of batches
+  numIterSampling = intAlgoSettings_.numBatches_*TMath::Nint(double(numIterSampling)/intAlgoSettings_.numBatches_);
+  unsigned numIterSimAnnealingPhase1 = TMath::Nint(intAlgoSettings_.fractionSimAnnealingPhase1_*numIterBurnin);
+  unsigned numIterSimAnnealingPhase2 = TMath::Nint(intAlgoSettings_.fractionSimAnnealingPhase2_*numIterBurnin);
+  // CV: record Markov Chain steps for debugging purposes in a binary file,
+  //     as storing them in a ROOT file slows down the integration by a large factor
+  if ( treeFileName_ == "" && chainFileName_ == "" && verbosity_ >= 2 ) {
+    chainFileName_ = "SVfitIntegratorMarkovChain_ClassicSVfit.bin";
   }
   intAlgo_ = new SVfitIntegratorMarkovChain(
     "uniform",
     numIterBurnin, numIterSampling, numIterSimAnnealingPhase1, numIterSimAnnealingPhase2,
-    15., 1. - 1./(0.1*numIterBurnin),
-    numChains, 100,
-    1.e-2, 0.71,
-    treeFileName_.data(),
+    intAlgoSettings_.T0_, 1. - 1./(intAlgoSettings_.fractionTemperatureDecay_*numIterBurnin),
+    numChains, intAlgoSettings_.numBatches_,
+    intAlgoSettings_.epsilon0_, intAlgoSettings_.nu_,
     0);
+  if ( treeFileName_ != "" ) {
+    if ( !chainTreeWriter_ ) chainTreeWriter_ = new SVfitChainTreeWriter(treeFileName_);
+    intAlgo_->setChainWriter(chainTreeWriter_);
+  }
+  if ( chainFileName_ != "" ) {
+    // CV: the integrator gets reinitialized when the settings change, while the Markov Chain steps of all events are kept in the same file
+    if ( !chainRecorder_ ) chainRecorder_ = new SVfitChainRecorder(chainFileName_, chainThinning_);
+    intAlgo_->setChainRecorder(chainRecorder_);
+  }
 }
 
 void ClassicSVfitBase::printMET(double measuredMETx, double measuredMETy, const TMatrixD& covMET) const
@@ -257,5 +538,5 @@ void ClassicSVfitBase::addMETEstimate(double measuredMETx, double measuredMETy,
   aCovMET[1][1] = roundToNdigits(covMET[1][1]);
   
   if ( verbosity_ >= 1 ) printMET(metX, metY, aCovMET);
-  integrand_->addMETEstimate(metX, metY, aCovMET);
+  integrand_->addMETEstimate(metX, metY, Matrix2x2(aCovMET[0][0], aCovMET[0][1], aCovMET[1][0], aCovMET[1][1]));
 }
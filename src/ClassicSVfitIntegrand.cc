@@ -1,24 +1,20 @@
 #include "TauAnalysis/ClassicSVfit/interface/ClassicSVfitIntegrand.h"
 
-#include "TauAnalysis/ClassicSVfit/interface/SVfitIntegratorMarkovChain.h"
-
-#include <TMath.h>
-#include <TString.h> // Form
 #include <Math/VectorUtil.h>
 
-#include <math.h>
+#include <algorithm>
+#include <cmath>
 
 using namespace classic_svFit;
 
 /// global function pointer, needed for Markov Chain integration
-const ClassicSVfitIntegrand* ClassicSVfitIntegrand::gSVfitIntegrand = 0;
+thread_local const ClassicSVfitIntegrand* ClassicSVfitIntegrand::gSVfitIntegrand = 0;
 
 ClassicSVfitIntegrand::ClassicSVfitIntegrand(int verbosity)
   : ClassicSVfitIntegrandBase(verbosity)
   , fittedTauLepton1_(0, verbosity)
   , fittedTauLepton2_(1, verbosity)
   , diTauMassConstraint_(-1.)
-  , histogramAdapter_(nullptr)
 {
   if ( verbosity_ ) {
     std::cout << "<ClassicSVfitIntegrand::ClassicSVfitIntegrand>:" << std::endl;
@@ -58,9 +54,10 @@ void ClassicSVfitIntegrand::setDiTauMassConstraint(double diTauMass)
   diTauMassConstraint2_ = square(diTauMassConstraint_);
 }
 
-void ClassicSVfitIntegrand::setHistogramAdapter(HistogramAdapterDiTau* histogramAdapter)
+void ClassicSVfitIntegrand::hashInputs(SVfitHash& hash) const
 {
-  histogramAdapter_ = histogramAdapter;
+  ClassicSVfitIntegrandBase::hashInputs(hash);
+  hash.add(diTauMassConstraint_);
 }
 
 void ClassicSVfitIntegrand::setLeptonInputs(const std::vector<MeasuredTauLepton>& measuredTauLeptons)
@@ -83,7 +80,7 @@ void ClassicSVfitIntegrand::setLeptonInputs(const std::vector<MeasuredTauLepton>
   leg2isHadronicTauDecay_ = measuredTauLepton2_.isHadronicTauDecay();
   leg2isPrompt_ = measuredTauLepton2_.isPrompt();
 
-  mVis_measured_ = (measuredTauLepton1_.p4() + measuredTauLepton2_.p4()).mass();
+  mVis_measured_ = compMass(measuredTauLepton1_.p4() + measuredTauLepton2_.p4());
   if ( verbosity_ >= 2 ) {
     std::cout << "mVis(ditau) = " << mVis_measured_ << std::endl;
   }
@@ -108,6 +105,7 @@ double ClassicSVfitIntegrand::EvalPS(const double* q) const
   if ( errorCode_ & MatrixInversion ||
        errorCode_ & LeptonNumber    ||
        errorCode_ & TestMass        ) {
+    countRejection(SVfitRejectionCounts::kInitializationError);
     return 0.; 
   }
 
@@ -119,7 +117,10 @@ double ClassicSVfitIntegrand::EvalPS(const double* q) const
   if( useHadTauTF_ && idx_visPtShift1 != -1 && !leg1isLeptonicTauDecay_ ) visPtShift1 = (1./x_[idx_visPtShift1]);
   if( useHadTauTF_ && idx_visPtShift2 != -1 && !leg2isLeptonicTauDecay_ ) visPtShift2 = (1./x_[idx_visPtShift2]);
 #endif
-  if ( visPtShift1 < 1.e-2 || visPtShift2 < 1.e-2 ) return 0.;
+  if ( visPtShift1 < 1.e-2 || visPtShift2 < 1.e-2 ) {
+    countRejection(SVfitRejectionCounts::kVisPtShift);
+    return 0.;
+  }
 
   // scale momenta of visible tau decays products
   fittedTauLepton1_.updateVisMomentum(visPtShift1);
@@ -133,7 +134,10 @@ double ClassicSVfitIntegrand::EvalPS(const double* q) const
     x1_dash = x_[idx_x1];
   }
   double x1 = x1_dash/visPtShift1;
-  if ( !(x1 >= 1.e-5 && x1 <= 1.) ) return 0.;
+  if ( !(x1 >= 1.e-5 && x1 <= 1.) ) {
+    countRejection(SVfitRejectionCounts::kX1OutOfRange);
+    return 0.;
+  }
 
   double x2_dash = 1.;
   if ( !leg2isPrompt_ ) {
@@ -145,7 +149,10 @@ double ClassicSVfitIntegrand::EvalPS(const double* q) const
     }
   }
   double x2 = x2_dash/visPtShift2;
-  if ( !(x2 >= 1.e-5 && x2 <= 1.) ) return 0.;
+  if ( !(x2 >= 1.e-5 && x2 <= 1.) ) {
+    countRejection(SVfitRejectionCounts::kX2OutOfRange);
+    return 0.;
+  }
 
   // compute neutrino and tau lepton momenta 
   if ( !leg1isPrompt_ ) {
@@ -153,11 +160,12 @@ double ClassicSVfitIntegrand::EvalPS(const double* q) const
     assert(idx_phiNu1 != -1);
     double phiNu1 = x_[idx_phiNu1];
     int idx_nu1Mass = legIntegrationParams_[0].idx_mNuNu_;
-    double nu1Mass = ( idx_nu1Mass != -1 ) ? TMath::Sqrt(x_[idx_nu1Mass]) : 0.;
+    double nu1Mass = ( idx_nu1Mass != -1 ) ? std::sqrt(x_[idx_nu1Mass]) : 0.;
     fittedTauLepton1_.updateTauMomentum(x1, phiNu1, nu1Mass);
     //std::cout << "fittedTauLepton1: errorCode = " << fittedTauLepton1_.errorCode() << std::endl;
     if ( fittedTauLepton1_.errorCode() != FittedTauLepton::None ) {
       errorCode_ |= TauDecayParameters;
+      countRejection(SVfitRejectionCounts::kTauDecayParameters);
       return 0.;
     }
   }
@@ -167,11 +175,12 @@ double ClassicSVfitIntegrand::EvalPS(const double* q) const
     assert(idx_phiNu2 != -1);
     double phiNu2 = x_[idx_phiNu2];
     int idx_nu2Mass = legIntegrationParams_[1].idx_mNuNu_;
-    double nu2Mass = ( idx_nu2Mass != -1 ) ? TMath::Sqrt(x_[idx_nu2Mass]) : 0.;
+    double nu2Mass = ( idx_nu2Mass != -1 ) ? std::sqrt(x_[idx_nu2Mass]) : 0.;
     fittedTauLepton2_.updateTauMomentum(x2, phiNu2, nu2Mass);
     //std::cout << "fittedTauLepton2: errorCode = " << fittedTauLepton2_.errorCode() << std::endl;
     if ( fittedTauLepton2_.errorCode() != FittedTauLepton::None ) {
       errorCode_ |= TauDecayParameters;
+      countRejection(SVfitRejectionCounts::kTauDecayParameters);
       return 0.;
     }
   }
@@ -185,12 +194,12 @@ double ClassicSVfitIntegrand::EvalPS(const double* q) const
       std::cout << "leg" << (iTau + 1) << ": En = " << visP4.E() << ", Px = " << visP4.px()
 		<< ", Py = " << visP4.py() << ", Pz = " << visP4.pz() << ";"
 		<< " Pt = " << visP4.pt() << ", eta = " << visP4.eta()
-		<< ", phi = " << visP4.phi() << ", mass = " << visP4.mass()
+		<< ", phi = " << visP4.phi() << ", mass = " << compMass(visP4)
 		<< " (x = " << fittedTauLepton->x() << ")" << std::endl;
       std::cout << "tau" << (iTau + 1) << ": En = " << tauP4.E() << ", Px = " << tauP4.px() << ", Py = " << tauP4.py() << ", Pz = " << tauP4.pz() << ";"
 		<< " Pt = " << tauP4.pt() << ", eta = " << tauP4.eta() << ", phi = " << tauP4.phi() << std::endl;
       std::cout << "nu" << (iTau + 1) << ": En = " << nuP4.E() << ", Px = " << nuP4.px() << ", Py = " << nuP4.py() << ", Pz = " << nuP4.pz() << ";"
-		<< " Pt = " << nuP4.pt() << ", eta = " << nuP4.eta() << ", phi = " << nuP4.phi() << ", mass = " << nuP4.mass() << std::endl;
+		<< " Pt = " << nuP4.pt() << ", eta = " << nuP4.eta() << ", phi = " << nuP4.phi() << ", mass = " << compMass(nuP4) << std::endl;
     }
   }
 
@@ -226,14 +235,14 @@ double ClassicSVfitIntegrand::EvalPS(const double* q) const
   prob_PS_and_tauDecay *= prob_tauDecay;
   prob_PS_and_tauDecay *= classic_svFit::matrixElementNorm;
 
-  double mTauTau = (fittedTauLepton1_.tauP4() + fittedTauLepton2_.tauP4()).mass();
+  double mTauTau = compMass(fittedTauLepton1_.tauP4() + fittedTauLepton2_.tauP4());
   double prob_logM = 1.;
   if ( addLogM_fixed_ ) {
-    prob_logM = 1./TMath::Power(TMath::Max(1., mTauTau), addLogM_fixed_power_);
+    prob_logM = 1./std::pow(std::max(1., mTauTau), addLogM_fixed_power_);
   }
   if ( addLogM_dynamic_ ) {    
-    double addLogM_power = addLogM_dynamic_formula_->Eval(mTauTau);
-    prob_logM = 1./TMath::Power(TMath::Max(1., mTauTau), TMath::Max(0., addLogM_power));
+    double addLogM_power = addLogM_dynamic_function_(mTauTau);
+    prob_logM = 1./std::pow(std::max(1., mTauTau), std::max(0., addLogM_power));
   }
 
   double jacobiFactor = 1./(visPtShift1*visPtShift2); // product of derrivatives dx1/dx1' and dx2/dx2' for parametrization of x1, x2 by x1', x2'
@@ -253,8 +262,12 @@ double ClassicSVfitIntegrand::EvalPS(const double* q) const
               << " TF = " << prob_TF << ", log(M) = " << prob_logM << ", Jacobi = " << jacobiFactor 
 	      << " --> returning " << prob << std::endl;
   }
-  if ( TMath::IsNaN(prob) ) {
+  if ( std::isnan(prob) ) {
+    countRejection(SVfitRejectionCounts::kNaN);
     prob = 0.;
+  } else if ( prob < 1.e-300 ) {
+    if ( prob_tauDecay == 0. ) countRejection(SVfitRejectionCounts::kPhaseSpaceFactor);
+    else countRejection(SVfitRejectionCounts::kSmallProbability);
   }
 
   return prob;
@@ -263,6 +276,7 @@ double ClassicSVfitIntegrand::EvalPS(const double* q) const
 double ClassicSVfitIntegrand::Eval(const double* x, unsigned int iComponent) const
 {
   if ( iComponent == 0 ) {
+    countEvaluation();
     phaseSpaceComponentCache_ = EvalPS(x);
   }
   if ( phaseSpaceComponentCache_ < 1.e-300 ) return 0.;
@@ -273,8 +287,11 @@ double ClassicSVfitIntegrand::Eval(const double* x, unsigned int iComponent) con
 	      << " phaseSpaceComponentCache: " << phaseSpaceComponentCache_
 	      << " --> returning " << prob << std::endl;
   }
-  if ( histogramAdapter_ && prob > 1.e-300 ){
-    histogramAdapter_->setTau1And2P4(fittedTauLepton1_.tauP4(), fittedTauLepton2_.tauP4());
+  if ( prob > 1.e-300 ) {
+    tau1P4_ = fittedTauLepton1_.tauP4();
+    tau2P4_ = fittedTauLepton2_.tauP4();
+  } else if ( iComponent == 0 ) {
+    countRejection(SVfitRejectionCounts::kSmallProbability);
   }
   return prob;
 }
@@ -1,13 +1,50 @@
 #include "TauAnalysis/ClassicSVfit/interface/ClassicSVfitIntegrandBase.h"
 
-#include <TMath.h>
+#ifdef USE_SVFITTF
 #include <TString.h> // Form
+#endif
 #include <Math/VectorUtil.h>
 
-#include <math.h>
+#include <cmath>
 
 using namespace classic_svFit;
 
+SVfitRejectionCounts::SVfitRejectionCounts()
+{
+  reset();
+}
+
+void SVfitRejectionCounts::reset()
+{
+  numEvaluations_ = 0;
+  for ( int iReason = 0; iReason < kNumReasons; ++iReason ) {
+    numRejections_[iReason] = 0;
+  }
+}
+
+void SVfitRejectionCounts::add(const SVfitRejectionCounts& counts)
+{
+  numEvaluations_ += counts.numEvaluations_;
+  for ( int iReason = 0; iReason < kNumReasons; ++iReason ) {
+    numRejections_[iReason] += counts.numRejections_[iReason];
+  }
+}
+
+const char* SVfitRejectionCounts::getReasonName(int reason)
+{
+  switch ( reason ) {
+    case kInitializationError: return "initializationError";
+    case kVisPtShift:          return "visPtShift";
+    case kX1OutOfRange:        return "x1OutOfRange";
+    case kX2OutOfRange:        return "x2OutOfRange";
+    case kTauDecayParameters:  return "tauDecayParameters";
+    case kPhaseSpaceFactor:    return "phaseSpaceFactor";
+    case kNaN:                 return "NaN";
+    case kSmallProbability:    return "smallProbability";
+  }
+  return "undefined";
+}
+
 ClassicSVfitIntegrandBase::ClassicSVfitIntegrandBase(int verbosity)
   : numTaus_(0)
 #ifdef USE_SVFITTF
@@ -22,7 +59,6 @@ ClassicSVfitIntegrandBase::ClassicSVfitIntegrandBase(int verbosity)
   , addLogM_fixed_(false)
   , addLogM_fixed_power_(0.)
   , addLogM_dynamic_(false)
-  , addLogM_dynamic_formula_(0)
   , errorCode_(0)
   , verbosity_(verbosity)
 {}
@@ -39,8 +75,6 @@ ClassicSVfitIntegrandBase::~ClassicSVfitIntegrandBase()
   delete xMin_;
   delete xMax_;
   delete x_;
-
-  delete addLogM_dynamic_formula_;
 }
 
 
@@ -59,17 +93,13 @@ void ClassicSVfitIntegrandBase::addLogM_fixed(bool value, double power)
   }
 }
 
-void ClassicSVfitIntegrandBase::addLogM_dynamic(bool value, const std::string& power)
+void ClassicSVfitIntegrandBase::addLogM_dynamic(bool value, const std::string& power, const LogMPowerFunction& powerFunction)
 {
   addLogM_dynamic_ = value;
   if ( addLogM_dynamic_ ) {
-    if ( power != "" ) {
-      TString power_tstring = power.data();
-      power_tstring = power_tstring.ReplaceAll("m", "x");
-      power_tstring = power_tstring.ReplaceAll("mass", "x");
-      std::string formulaName = "ClassicSVfitIntegrand_addLogM_dynamic_formula";
-      delete addLogM_dynamic_formula_;
-      addLogM_dynamic_formula_ = new TFormula(formulaName.data(), power_tstring.Data());
+    if ( power != "" && powerFunction ) {
+      addLogM_dynamic_power_ = power;
+      addLogM_dynamic_function_ = powerFunction;
     } else {
       std::cerr << "Warning: expression = '" << power << "' is invalid --> disabling dynamic logM term !!" << std::endl;
       addLogM_dynamic_ = false;
@@ -148,6 +178,10 @@ void ClassicSVfitIntegrandBase::setLeptonInputs(const std::vector<MeasuredTauLep
 
   phaseSpaceComponentCache_ = 0;
 
+#ifdef USE_REJECTION_COUNTERS
+  rejectionCounts_.reset();
+#endif
+
 #ifdef USE_SVFITTF
   if ( useHadTauTF_ ) {
     for ( unsigned iTau = 0; iTau < numTaus_; ++iTau ) {
@@ -161,7 +195,7 @@ void ClassicSVfitIntegrandBase::setLeptonInputs(const std::vector<MeasuredTauLep
 #endif
 }
 
-void ClassicSVfitIntegrandBase::addMETEstimate(double measuredMETx, double measuredMETy, const TMatrixD& covMET)
+void ClassicSVfitIntegrandBase::addMETEstimate(double measuredMETx, double measuredMETy, const Matrix2x2& covMET)
 {
   measuredMETx_.push_back(measuredMETx);
   measuredMETy_.push_back(measuredMETy);
@@ -180,6 +214,28 @@ void ClassicSVfitIntegrandBase::clearMET()
   covMET_.clear();
 }
 
+void ClassicSVfitIntegrandBase::hashInputs(SVfitHash& hash) const
+{
+  hash.add(static_cast<unsigned>(measuredMETx_.size()));
+  for ( size_t iComponent = 0; iComponent < measuredMETx_.size(); ++iComponent ) {
+    hash.add(measuredMETx_[iComponent]);
+    hash.add(measuredMETy_[iComponent]);
+    const Matrix2x2& covMET = covMET_[iComponent];
+    hash.add(covMET.xx_);
+    hash.add(covMET.xy_);
+    hash.add(covMET.yx_);
+    hash.add(covMET.yy_);
+  }
+#ifdef USE_SVFITTF
+  hash.add(useHadTauTF_);
+  hash.add(rhoHadTau_);
+#endif
+  hash.add(addLogM_fixed_);
+  if ( addLogM_fixed_ ) hash.add(addLogM_fixed_power_);
+  hash.add(addLogM_dynamic_);
+  if ( addLogM_dynamic_ ) hash.add(addLogM_dynamic_power_);
+}
+
 void ClassicSVfitIntegrandBase::rescaleX(const double* q) const
 {
   for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
@@ -193,13 +249,13 @@ double ClassicSVfitIntegrandBase::EvalMET_TF(unsigned int iComponent) const
   return EvalMET_TF(measuredMETx_[iComponent], measuredMETy_[iComponent], covMET_[iComponent]);
 }
 
-double ClassicSVfitIntegrandBase::EvalMET_TF(double aMETx, double aMETy, const TMatrixD& covMET) const
+double ClassicSVfitIntegrandBase::EvalMET_TF(double aMETx, double aMETy, const Matrix2x2& covMET) const
 {
   // determine transfer matrix for MET
-  double invCovMETxx =  covMET(1,1);
-  double invCovMETxy = -covMET(0,1);
-  double invCovMETyx = -covMET(1,0);
-  double invCovMETyy =  covMET(0,0);
+  double invCovMETxx =  covMET.yy_;
+  double invCovMETxy = -covMET.xy_;
+  double invCovMETyx = -covMET.yx_;
+  double invCovMETyy =  covMET.xx_;
   double covDet = invCovMETxx*invCovMETyy - invCovMETxy*invCovMETyx;
 
   if( std::abs(covDet) < 1.e-10 ){
@@ -207,7 +263,7 @@ double ClassicSVfitIntegrandBase::EvalMET_TF(double aMETx, double aMETy, const T
     errorCode_ |= MatrixInversion;
     return 0;
   }
-  double const_MET = 1./(2.*TMath::Pi()*TMath::Sqrt(covDet));
+  double const_MET = 1./(2.*M_PI*std::sqrt(covDet));
 
   // compute sum of momenta of all neutrinos produced in tau decays
   double sumNuPx = 0.;
@@ -241,7 +297,7 @@ double ClassicSVfitIntegrandBase::EvalMET_TF(double aMETx, double aMETy, const T
   double pull2 = residualX*(invCovMETxx*residualX + invCovMETxy*residualY) +
                  residualY*(invCovMETyx*residualX + invCovMETyy*residualY);
   pull2 /= covDet;
-  double prob = const_MET*TMath::Exp(-0.5*pull2);
+  double prob = const_MET*std::exp(-0.5*pull2);
 
   if ( verbosity_ >= 2 ) {    
     std::cout << "TF(met): recPx = " << aMETx << ", recPy = " << aMETy << ","
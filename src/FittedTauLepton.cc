@@ -1,6 +1,7 @@
 #include "TauAnalysis/ClassicSVfit/interface/FittedTauLepton.h"
 
-#include <TMath.h>
+#include <algorithm>
+#include <cmath>
 
 using namespace classic_svFit;
 
@@ -22,7 +23,7 @@ namespace
 {
   double norm(const Vector& v)
   {
-    return TMath::Sqrt(v.mag2());
+    return std::sqrt(v.mag2());
   }
 }
 
@@ -66,8 +67,8 @@ void FittedTauLepton::updateVisMomentum(double visPtShift)
   double visPx = visPtShift*measuredTauLepton_.px();
   double visPy = visPtShift*measuredTauLepton_.py();
   double visPz = visPtShift*measuredTauLepton_.pz();
-  double visEn = TMath::Sqrt(square(visPx) + square(visPy) + square(visPz) + measuredTauLepton_mass2_);
-  //std::cout << "vis: En = " << visEn << ", Pt = " << TMath::Sqrt(square(visPx) + square(visPy)) << std::endl;
+  double visEn = std::sqrt(square(visPx) + square(visPy) + square(visPz) + measuredTauLepton_mass2_);
+  //std::cout << "vis: En = " << visEn << ", Pt = " << std::sqrt(square(visPx) + square(visPy)) << std::endl;
   visP4_.SetPxPyPzE(visPx, visPy, visPz, visEn);
 
   // set tau lepton four-vector to four-vector of visible decay products and neutrino four-vector to zero,
@@ -89,7 +90,7 @@ void FittedTauLepton::updateTauMomentum(double x, double phiNu, double nuMass)
   // compute neutrino and tau lepton four-vector 
   double nuEn = visP4_.E()*(1. - x_)/x_;
   double nuMass2 = square(nuMass_);
-  double nuP = TMath::Sqrt(TMath::Max(0., square(nuEn) - nuMass2));
+  double nuP = std::sqrt(std::max(0., square(nuEn) - nuMass2));
   double cosThetaNu = compCosThetaNuNu(visP4_.E(), visP4_.P(), measuredTauLepton_mass2_, nuEn, nuP, nuMass2);
   if ( !(cosThetaNu >= -1. && cosThetaNu <= +1.) ) {
     errorCode_ |= TauDecayParameters;
@@ -98,8 +99,8 @@ void FittedTauLepton::updateTauMomentum(double x, double phiNu, double nuMass)
 
   double cosPhiNu, sinPhiNu;
   sincos(phiNu_, &sinPhiNu, &cosPhiNu);
-  double thetaNu = TMath::ACos(cosThetaNu);
-  double sinThetaNu = TMath::Sin(thetaNu);
+  double thetaNu = std::acos(cosThetaNu);
+  double sinThetaNu = std::sin(thetaNu);
 
   double nuPx_local = nuP*cosPhiNu*sinThetaNu;
   double nuPy_local = nuP*sinPhiNu*sinThetaNu;
@@ -107,14 +108,14 @@ void FittedTauLepton::updateTauMomentum(double x, double phiNu, double nuMass)
   double nuPx = nuPx_local*eX_x_ + nuPy_local*eY_x_ + nuPz_local*eZ_x_;
   double nuPy = nuPx_local*eX_y_ + nuPy_local*eY_y_ + nuPz_local*eZ_y_;
   double nuPz = nuPx_local*eX_z_ + nuPy_local*eY_z_ + nuPz_local*eZ_z_;
-  //std::cout << "nu1: En = " << nuEn << ", Pt = " << TMath::Sqrt(square(nuPx) + square(nuPy)) << std::endl;
+  //std::cout << "nu1: En = " << nuEn << ", Pt = " << std::sqrt(square(nuPx) + square(nuPy)) << std::endl;
   nuP4_.SetPxPyPzE(nuPx, nuPy, nuPz, nuEn);
 
   double tauEn = visP4_.E() + nuEn;
   double tauPx = visP4_.px() + nuPx;
   double tauPy = visP4_.py() + nuPy;
   double tauPz = visP4_.pz() + nuPz;
-  //std::cout << "tau: En = " << tauEn << ", Pt = " << TMath::Sqrt(square(tauPx) + square(tauPy)) << std::endl;
+  //std::cout << "tau: En = " << tauEn << ", Pt = " << std::sqrt(square(tauPx) + square(tauPy)) << std::endl;
   tauP4_.SetPxPyPzE(tauPx, tauPy, tauPz, tauEn);
 }
 
@@ -1,6 +1,6 @@
 #include "TauAnalysis/ClassicSVfit/interface/MeasuredTauLepton.h"
 
-#include <TMath.h>
+#include <cmath>
 
 using namespace classic_svFit;
 
@@ -173,17 +173,17 @@ void MeasuredTauLepton::roundToNdigits(unsigned int nDigis)
 void MeasuredTauLepton::initialize()
 {
   // CV: relations between pT and p, energy taken from http://en.wikipedia.org/wiki/Pseudorapidity
-  p_  = pt_*TMath::CosH(eta_);
-  px_ = pt_*TMath::Cos(phi_);
-  py_ = pt_*TMath::Sin(phi_);
-  pz_ = pt_*TMath::SinH(eta_);
-  energy_ = TMath::Sqrt(p_*p_ + preciseVisMass_*preciseVisMass_);
+  p_  = pt_*std::cosh(eta_);
+  px_ = pt_*std::cos(phi_);
+  py_ = pt_*std::sin(phi_);
+  pz_ = pt_*std::sinh(eta_);
+  energy_ = std::sqrt(p_*p_ + preciseVisMass_*preciseVisMass_);
   p4_ = LorentzVector(px_, py_, pz_, energy_);
   p3_ = Vector(px_, py_, pz_);
   double theta = p4_.theta();
-  cosPhi_sinTheta_ = TMath::Cos(phi_)*TMath::Sin(theta);
-  sinPhi_sinTheta_ = TMath::Sin(phi_)*TMath::Sin(theta);
-  cosTheta_ = TMath::Cos(theta);
+  cosPhi_sinTheta_ = std::cos(phi_)*std::sin(theta);
+  sinPhi_sinTheta_ = std::sin(phi_)*std::sin(theta);
+  cosTheta_ = std::cos(theta);
   isLeptonicTauDecay_ = (type_ == MeasuredTauLepton::kTauToElecDecay || type_ == MeasuredTauLepton::kTauToMuDecay);
   isHadronicTauDecay_ = (type_ == MeasuredTauLepton::kTauToHadDecay);
   isPrompt_ = (type_ == MeasuredTauLepton::kPrompt);
@@ -226,3 +226,24 @@ bool sortMeasuredTauLeptons::operator() (const MeasuredTauLepton& measuredTauLep
   return ( measuredTauLepton1.pt() > measuredTauLepton2.pt() );
 }
 //---------------------------------------------------------------------------------------------------
+
+std::string classic_svFit::getDecayChannelName(const std::vector<MeasuredTauLepton>& measuredTauLeptons)
+{
+  // CV: order the legs as prompt leptons, electrons, muons, hadronic tau decays
+  const int numDecayTypes = 5;
+  const int decayTypes_ordered[numDecayTypes] = {
+    MeasuredTauLepton::kPrompt, MeasuredTauLepton::kTauToElecDecay, MeasuredTauLepton::kTauToMuDecay,
+    MeasuredTauLepton::kTauToHadDecay, MeasuredTauLepton::kUndefinedDecayType
+  };
+  const char* decayTypeNames_ordered[numDecayTypes] = { "prompt", "e", "mu", "had", "undefined" };
+  std::string channelName;
+  for ( int idxDecayType = 0; idxDecayType < numDecayTypes; ++idxDecayType ) {
+    for ( std::vector<MeasuredTauLepton>::const_iterator measuredTauLepton = measuredTauLeptons.begin();
+          measuredTauLepton != measuredTauLeptons.end(); ++measuredTauLepton ) {
+      if ( measuredTauLepton->type() != decayTypes_ordered[idxDecayType] ) continue;
+      if ( channelName != "" ) channelName += "_";
+      channelName += decayTypeNames_ordered[idxDecayType];
+    }
+  }
+  return channelName;
+}
@@ -0,0 +1,152 @@
+#include "TauAnalysis/ClassicSVfit/interface/SVfitChainRecorder.h"
+
+#include <iostream>
+#include <assert.h>
+
+using namespace classic_svFit;
+
+namespace
+{
+  const char fileHeader[8] = { 'S', 'V', 'F', 'I', 'T', 'M', 'C', '1' };
+}
+
+SVfitChainRecorder::SVfitChainRecorder(const std::string& fileName, unsigned thinning, unsigned blockSize, unsigned numBlocks)
+  : file_(fileName.data(), std::ios::out | std::ios::binary | std::ios::trunc)
+  , thinning_(( thinning > 0 ) ? thinning : 1)
+  , blockSize_(blockSize)
+  , eventId_(0)
+  , numDimensions_(0)
+  , recordSize_(0)
+  , currentBlock_(nullptr)
+  , isDone_(false)
+{
+  if ( !file_ ) {
+    std::cerr << "<SVfitChainRecorder>:"
+              << "Failed to open file = " << fileName << " --> ABORTING !!\n";
+    assert(0);
+  }
+  file_.write(fileHeader, sizeof(fileHeader));
+
+  assert(numBlocks >= 2);
+  blocks_.resize(numBlocks);
+  for ( std::vector<Block>::iterator block = blocks_.begin();
+        block != blocks_.end(); ++block ) {
+    block->data_.resize(blockSize_*(2 + maxNumDimensions)*sizeof(float));
+    freeBlocks_.push_back(&(*block));
+  }
+
+  writer_ = std::thread(&SVfitChainRecorder::write, this);
+}
+
+SVfitChainRecorder::~SVfitChainRecorder()
+{
+  endEvent();
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    isDone_ = true;
+  }
+  condition_.notify_all();
+  writer_.join();
+  file_.close();
+}
+
+void SVfitChainRecorder::beginEvent(uint64_t eventId, unsigned numDimensions)
+{
+  endEvent();
+  assert(numDimensions <= maxNumDimensions);
+  eventId_ = eventId;
+  numDimensions_ = numDimensions;
+  recordSize_ = (2 + numDimensions_)*sizeof(float);
+}
+
+void SVfitChainRecorder::endEvent()
+{
+  if ( !currentBlock_ ) return;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if ( currentBlock_->numMoves_ > 0 ) filledBlocks_.push_back(currentBlock_);
+    else freeBlocks_.push_back(currentBlock_);
+  }
+  condition_.notify_all();
+  currentBlock_ = nullptr;
+}
+
+void SVfitChainRecorder::nextBlock()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  if ( currentBlock_ ) filledBlocks_.push_back(currentBlock_);
+  condition_.notify_all();
+//--- wait for the writer thread to return a block, in case all blocks are filled
+  condition_.wait(lock, [this]{ return !freeBlocks_.empty(); });
+  currentBlock_ = freeBlocks_.back();
+  freeBlocks_.pop_back();
+  currentBlock_->eventId_ = eventId_;
+  currentBlock_->numDimensions_ = numDimensions_;
+  currentBlock_->numMoves_ = 0;
+}
+
+void SVfitChainRecorder::write()
+{
+  while ( true ) {
+    Block* block = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait(lock, [this]{ return isDone_ || !filledBlocks_.empty(); });
+      if ( filledBlocks_.empty() ) break;
+      block = filledBlocks_.front();
+      filledBlocks_.pop_front();
+    }
+    file_.write(reinterpret_cast<const char*>(&block->eventId_), sizeof(uint64_t));
+    file_.write(reinterpret_cast<const char*>(&block->numDimensions_), sizeof(uint32_t));
+    file_.write(reinterpret_cast<const char*>(&block->numMoves_), sizeof(uint32_t));
+    file_.write(block->data_.data(), block->numMoves_*(2 + block->numDimensions_)*sizeof(float));
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      freeBlocks_.push_back(block);
+    }
+    condition_.notify_all();
+  }
+}
+
+SVfitChainReader::SVfitChainReader(const std::string& fileName)
+  : file_(fileName.data(), std::ios::in | std::ios::binary)
+  , isValid_(false)
+  , eventId_(0)
+  , numDimensions_(0)
+  , numMoves_(0)
+{
+  char header[sizeof(fileHeader)];
+  if ( file_.read(header, sizeof(header)) && memcmp(header, fileHeader, sizeof(fileHeader)) == 0 ) isValid_ = true;
+}
+
+bool SVfitChainReader::nextBlock()
+{
+  if ( !isValid_ ) return false;
+  if ( !file_.read(reinterpret_cast<char*>(&eventId_), sizeof(uint64_t)) ) return false;
+  file_.read(reinterpret_cast<char*>(&numDimensions_), sizeof(uint32_t));
+  file_.read(reinterpret_cast<char*>(&numMoves_), sizeof(uint32_t));
+  data_.resize(numMoves_*(2 + numDimensions_)*sizeof(float));
+  file_.read(data_.data(), data_.size());
+  return bool(file_);
+}
+
+unsigned SVfitChainReader::getMove(unsigned idxMove) const
+{
+  uint32_t move;
+  memcpy(&move, &data_[idxMove*(2 + numDimensions_)*sizeof(float)], sizeof(uint32_t));
+  return move;
+}
+
+float SVfitChainReader::getIntegrand(unsigned idxMove) const
+{
+  float integrand;
+  memcpy(&integrand, &data_[(idxMove*(2 + numDimensions_) + 1)*sizeof(float)], sizeof(float));
+  return integrand;
+}
+
+float SVfitChainReader::getX(unsigned idxMove, unsigned iDimension) const
+{
+  float x_i;
+  memcpy(&x_i, &data_[(idxMove*(2 + numDimensions_) + 2 + iDimension)*sizeof(float)], sizeof(float));
+  return x_i;
+}
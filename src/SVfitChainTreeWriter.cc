@@ -0,0 +1,51 @@
+#include "TauAnalysis/ClassicSVfit/interface/SVfitChainTreeWriter.h"
+
+#include <TString.h>
+
+using namespace classic_svFit;
+
+SVfitChainTreeWriter::SVfitChainTreeWriter(const std::string& fileName)
+  : fileName_(fileName)
+  , file_(nullptr)
+  , tree_(nullptr)
+  , move_(0)
+  , integrand_(0.)
+{}
+
+SVfitChainTreeWriter::~SVfitChainTreeWriter()
+{
+  endIntegration();
+}
+
+void SVfitChainTreeWriter::beginIntegration(unsigned numDimensions, const double* x)
+{
+  endIntegration();
+  file_ = new TFile(fileName_.data(), "RECREATE");
+  tree_ = new TTree("tree", "Markov Chain transitions");
+  for ( unsigned iDimension = 0; iDimension < numDimensions; ++iDimension ) {
+    std::string branchName = Form("x%u", iDimension);
+    // CV: the branches are only read when the TTree is filled
+    tree_->Branch(branchName.data(), const_cast<double*>(&x[iDimension]));
+  }
+  tree_->Branch("move", &move_);
+  tree_->Branch("integrand", &integrand_);
+}
+
+void SVfitChainTreeWriter::write(unsigned move, double integrand)
+{
+  if ( !tree_ ) return;
+  move_ = move;
+  integrand_ = integrand;
+  tree_->Fill();
+}
+
+void SVfitChainTreeWriter::endIntegration()
+{
+  if ( tree_ ) {
+    tree_->Write();
+  }
+  // CV: the TTree is owned by the file
+  delete file_;
+  file_ = nullptr;
+  tree_ = nullptr;
+}
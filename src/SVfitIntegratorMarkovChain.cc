@@ -1,9 +1,9 @@
 #include "TauAnalysis/ClassicSVfit/interface/SVfitIntegratorMarkovChain.h"
 
 #include "TauAnalysis/ClassicSVfit/interface/svFitAuxFunctions.h"
+#include "TauAnalysis/ClassicSVfit/interface/svFitHash.h"
 
-#include <TMath.h>
-
+#include <cmath>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
@@ -36,6 +36,12 @@ namespace
   {
     return format_vT(vd);
   }
+
+  int nint(double x)
+  {
+    // CV: round half to even, like TMath::Nint
+    return (int)std::nearbyint(x);
+  }
 }
 
 using namespace classic_svFit;
@@ -45,17 +51,32 @@ SVfitIntegratorMarkovChain::SVfitIntegratorMarkovChain(const std::string& initMo
                    double T0, double alpha,
                    unsigned numChains, unsigned numBatches,
                    double epsilon0, double nu,
-                   const std::string& treeFileName, int verbosity)
+                   int verbosity)
   : integrand_(0),
     x_(0),
+    x_size_(0),
+    seed_(12345),
+    probLastChain_(0.),
+    numMoves_accepted_(0),
+    numMoves_rejected_(0),
+    numIntegrandCalls_(0),
+    numIntegrandCalls_zeroProb_(0),
+    numStartPositionRetries_(0),
     numIntegrationCalls_(0),    
     numMovesTotal_accepted_(0),
     numMovesTotal_rejected_(0),
     probMax_(-1.),
     errorFlag_(0),
-    treeFileName_(treeFileName),
-    treeFile_(0),
-    tree_(0)
+    observeBurnin_(true),
+    tau1P4_(nullptr),
+    tau2P4_(nullptr),
+    chainRecorder_(nullptr),
+    chainWriter_(nullptr),
+    eventId_(0),
+    profiler_(nullptr),
+    timeBudget_(0.),
+    isStartTimeSet_(false),
+    isStoppedByTimeBudget_(false)
 {
   if      ( initMode == "uniform" ) initMode_ = kUniform;
   else if ( initMode == "Gaus"    ) initMode_ = kGaus;
@@ -70,6 +91,10 @@ SVfitIntegratorMarkovChain::SVfitIntegratorMarkovChain(const std::string& initMo
 //--- get parameters defining number of "stochastic moves" performed per integration
   numIterBurnin_ = numIterBurnin;
   numIterSampling_ = numIterSampling;
+  numIterBurnin_max_ = numIterBurnin_;
+  numIterSampling_max_ = numIterSampling_;
+  numBatchesCompleted_ = 0;
+  numIterSampling_done_ = 0;
 
 //--- get parameters defining maximum number of attempts to find a valid starting-position for the Markov Chain
   maxCallsStartingPos_ = 1000000;
@@ -78,6 +103,8 @@ SVfitIntegratorMarkovChain::SVfitIntegratorMarkovChain(const std::string& initMo
   numIterSimAnnealingPhase1_ = numIterSimAnnealingPhase1;
   numIterSimAnnealingPhase2_ = numIterSimAnnealingPhase2;
   numIterSimAnnealingPhase1plus2_ = numIterSimAnnealingPhase1_ + numIterSimAnnealingPhase2_;
+  numIterSimAnnealingPhase1_max_ = numIterSimAnnealingPhase1_;
+  numIterSimAnnealingPhase2_max_ = numIterSimAnnealingPhase2_;
   if ( numIterSimAnnealingPhase1plus2_ > numIterBurnin_ ) {
     std::cerr << "<SVfitIntegratorMarkovChain>:"
               << "Invalid Configuration Parameters 'numIterSimAnnealingPhase1' = " << numIterSimAnnealingPhase1_ << ","
@@ -86,7 +113,7 @@ SVfitIntegratorMarkovChain::SVfitIntegratorMarkovChain(const std::string& initMo
     assert(0);
   }
   T0_ = T0;
-  sqrtT0_ = TMath::Sqrt(T0_);
+  sqrtT0_ = std::sqrt(T0_);
   alpha_ = alpha;
   if ( !(alpha_ > 0. && alpha_ < 1.) ) {
     std::cerr << "<SVfitIntegratorMarkovChain>:"
@@ -95,6 +122,7 @@ SVfitIntegratorMarkovChain::SVfitIntegratorMarkovChain(const std::string& initMo
     assert(0);
   }
   alpha2_ = square(alpha_);
+  alpha_max_ = alpha_;
 
 //--- get parameter specifying how many Markov Chains are run in parallel
   numChains_ = numChains;
@@ -141,8 +169,12 @@ void SVfitIntegratorMarkovChain::setIntegrand(gPtr_C g, const double* xl, const
 {
   numDimensions_ = d;
 
-  delete [] x_;
-  x_ = new double[numDimensions_];
+  // CV: reallocate memory only if the number of dimensions exceeds the one of all previous integrations
+  if ( numDimensions_ > x_size_ ) {
+    delete [] x_;
+    x_ = new double[numDimensions_];
+    x_size_ = numDimensions_;
+  }
 
   xMin_.resize(numDimensions_);
   xMax_.resize(numDimensions_);
@@ -180,7 +212,17 @@ void SVfitIntegratorMarkovChain::registerCallBackFunction(const ROOT::Math::Func
   callBackFunctions_.push_back(&function);
 }
 
+void SVfitIntegratorMarkovChain::registerBurninCallBackFunction(const ROOT::Math::Functor& function)
+{
+  burninCallBackFunctions_.push_back(&function);
+}
+
 void SVfitIntegratorMarkovChain::integrate(gPtr_C g, const double* xl, const double* xu, unsigned d, double& integral, double& integralErr)
+{
+  integrate<>(g, xl, xu, d, integral, integralErr);
+}
+
+void SVfitIntegratorMarkovChain::startIntegration(gPtr_C g, const double* xl, const double* xu, unsigned d)
 {
   setIntegrand(g, xl, xu, d);
 
@@ -200,121 +242,203 @@ void SVfitIntegratorMarkovChain::integrate(gPtr_C g, const double* xl, const dou
 
 //--- CV: set random number generator used to initialize starting-position
 //        for each integration, in order to make integration results independent of processing history
-  rnd_.SetSeed(12345);
+  rnd_.setSeed(seed_);
 
   numMoves_accepted_ = 0;
   numMoves_rejected_ = 0;
 
-  probMax_ = -1.;
+  numIntegrandCalls_ = 0;
+  numIntegrandCalls_zeroProb_ = 0;
+  numStartPositionRetries_ = 0;
 
-  unsigned k = numChains_*numBatches_;
-  unsigned m = numIterSampling_/numBatches_;
+  probMax_ = -1.;
 
   numChainsRun_ = 0;
 
-  if ( treeFileName_ != "" ) {
-    treeFile_ = new TFile(treeFileName_.data(), "RECREATE");
-    tree_ = new TTree("tree", "Markov Chain transitions");
-    for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
-      std::string branchName = Form("x%u", iDimension);
-      tree_->Branch(branchName.data(), &x_[iDimension]);
+//--- reset numbers of iterations, which may have been scaled down to fit into the time budget of the previous integration
+  numIterBurnin_ = numIterBurnin_max_;
+  numIterSampling_ = numIterSampling_max_;
+  numIterSimAnnealingPhase1_ = numIterSimAnnealingPhase1_max_;
+  numIterSimAnnealingPhase2_ = numIterSimAnnealingPhase2_max_;
+  numIterSimAnnealingPhase1plus2_ = numIterSimAnnealingPhase1_ + numIterSimAnnealingPhase2_;
+  alpha_ = alpha_max_;
+  alpha2_ = square(alpha_);
+  numBatchesCompleted_ = 0;
+  numIterSampling_done_ = 0;
+  isStoppedByTimeBudget_ = false;
+  if ( timeBudget_ > 0. && !isStartTimeSet_ ) startTime_ = Clock::now();
+  isStartTimeSet_ = false;
+
+  if ( chainWriter_ ) {
+    chainWriter_->beginIntegration(numDimensions_, x_);
+  }
+
+  if ( chainRecorder_ ) {
+    chainRecorder_->beginEvent(eventId_, numDimensions_);
+  }
+}
+
+void SVfitIntegratorMarkovChain::startRandomStream(unsigned iChain)
+{
+  // CV: the first chain continues the stream started by startIntegration,
+  //     so that results of integrations with a single chain do not change
+  if ( iChain == 0 ) return;
+  SVfitHash hash;
+  hash.add(seed_);
+  hash.add(iChain);
+  uint64_t value = hash.getValue();
+  unsigned seed = static_cast<unsigned>(value ^ (value >> 32));
+  // CV: TRandom3 takes seed 0 to mean a seed derived from the system clock (cf. SVfitRandom)
+  rnd_.setSeed(( seed != 0 ) ? seed : seed_);
+}
+
+bool SVfitIntegratorMarkovChain::checkTimeBudget_burnin(unsigned iMove)
+{
+  double numSeconds = std::chrono::duration<double>(Clock::now() - startTime_).count();
+//--- end the "burnin" at half of the time budget, keeping the other half for the sampling;
+//    the simulated annealing ends together with the "burnin", so that all samples are taken at temperature one
+  if ( numSeconds > 0.5*timeBudget_ ) {
+    numIterBurnin_ = iMove;
+    numIterSimAnnealingPhase1_ = std::min(numIterSimAnnealingPhase1_, iMove);
+    numIterSimAnnealingPhase2_ = std::min(numIterSimAnnealingPhase2_, iMove - numIterSimAnnealingPhase1_);
+    numIterSimAnnealingPhase1plus2_ = numIterSimAnnealingPhase1_ + numIterSimAnnealingPhase2_;
+    return false;
+  }
+//--- scale the numbers of iterations down to the number of iterations that fit into the time budget,
+//    estimated from the computing time of the first iterations of the first chain
+  if ( iMove == numIterTimeCheck && numChainsRun_ == 0 && numSeconds > 0. ) {
+    double numIter = numChains_*(double(numIterBurnin_) + numIterSampling_);
+    double scale = (timeBudget_*iMove/numSeconds)/numIter;
+    if ( scale < 1. ) {
+      numIterBurnin_ = std::max(iMove + 1, (unsigned)nint(scale*numIterBurnin_));
+      numIterSimAnnealingPhase1_ = nint(scale*numIterSimAnnealingPhase1_);
+      numIterSimAnnealingPhase2_ = std::min((unsigned)nint(scale*numIterSimAnnealingPhase2_), numIterBurnin_ - numIterSimAnnealingPhase1_);
+      numIterSimAnnealingPhase1plus2_ = numIterSimAnnealingPhase1_ + numIterSimAnnealingPhase2_;
+      numIterSampling_ = numBatches_*std::max(1, nint(scale*numIterSampling_/numBatches_));
+      // CV: decrease the temperature by the same factor over the (shorter) simulated annealing
+      alpha_ = std::max(0., 1. - (1. - alpha_)/scale);
+      alpha2_ = square(alpha_);
     }
-    tree_->Branch("move", &treeMove_);
-    tree_->Branch("integrand", &treeIntegrand_);
   }
+  return true;
+}
 
-  for ( unsigned iChain = 0; iChain < numChains_; ++iChain ) {
-    bool isValidStartPos = false;
-    if ( initMode_ == kNone ) {
-      prob_ = evalProb(q_);
-      if ( prob_ > 0. ) {
-      bool isWithinBounds = true;
-      for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
-        double q_i = q_[iDimension];
-        if ( !(q_i > 0. && q_i < 1.) ) isWithinBounds = false;
-      }
-      if ( isWithinBounds ) {
-        isValidStartPos = true;
-      } else {
-        if ( verbosity_ >= 1 ) {
-          std::cerr << "<SVfitIntegratorMarkovChain>:"
-                    << "Warning: Requested start-position = " << format_vdouble(q_) << " not within interval ]0..1[ --> searching for valid alternative !!\n";
-        }
+bool SVfitIntegratorMarkovChain::checkTimeBudget()
+{
+  if ( std::chrono::duration<double>(Clock::now() - startTime_).count() > timeBudget_ ) {
+    isStoppedByTimeBudget_ = true;
+    return false;
+  }
+  return true;
+}
+
+bool SVfitIntegratorMarkovChain::startChain()
+{
+  bool isValidStartPos = false;
+  if ( initMode_ == kNone ) {
+    prob_ = evalProb(q_);
+    if ( prob_ > 0. ) {
+    bool isWithinBounds = true;
+    for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
+      double q_i = q_[iDimension];
+      if ( !(q_i > 0. && q_i < 1.) ) isWithinBounds = false;
+    }
+    if ( isWithinBounds ) {
+      isValidStartPos = true;
+    } else {
+      if ( verbosity_ >= 1 ) {
+        std::cerr << "<SVfitIntegratorMarkovChain>:"
+                  << "Warning: Requested start-position = " << format_vdouble(q_) << " not within interval ]0..1[ --> searching for valid alternative !!\n";
       }
-      } else {
-        if ( verbosity_ >= 1 ) {
-          std::cerr << "<SVfitIntegratorMarkovChain>:"
-                    << "Warning: Requested start-position = " << format_vdouble(q_) << " returned probability zero --> searching for valid alternative !!";
-        }
+    }
+    } else {
+      if ( verbosity_ >= 1 ) {
+        std::cerr << "<SVfitIntegratorMarkovChain>:"
+                  << "Warning: Requested start-position = " << format_vdouble(q_) << " returned probability zero --> searching for valid alternative !!";
       }
     }
-    unsigned iTry = 0;
-    while ( !isValidStartPos && iTry < maxCallsStartingPos_ ) {
-      initializeStartPosition_and_Momentum();
-      prob_ = evalProb(q_);
-      if ( prob_ > 0. ) {
-        isValidStartPos = true;
-      } else {
-        if ( iTry > 0 && (iTry % 100000) == 0 ) {
-          if ( iTry == 100000 ) std::cout << "<SVfitIntegratorMarkovChain::integrate>:" << std::endl;
-          std::cout << "try #" << iTry << ": did not find valid start-position yet." << std::endl;
-        }
+  }
+  unsigned iTry = 0;
+  while ( !isValidStartPos && iTry < maxCallsStartingPos_ ) {
+    if ( timeBudget_ > 0. && (iTry % numIterTimeCheck) == 0 && !checkTimeBudget() ) break;
+    initializeStartPosition_and_Momentum();
+    prob_ = evalProb(q_);
+    if ( prob_ > 0. ) {
+      isValidStartPos = true;
+    } else {
+      ++numStartPositionRetries_;
+      if ( iTry > 0 && (iTry % 100000) == 0 ) {
+        if ( iTry == 100000 ) std::cout << "<SVfitIntegratorMarkovChain::integrate>:" << std::endl;
+        std::cout << "try #" << iTry << ": did not find valid start-position yet." << std::endl;
       }
-      ++iTry;
     }
-    if ( !isValidStartPos ) continue;
+    ++iTry;
+  }
+  return isValidStartPos;
+}
 
-    for ( unsigned iMove = 0; iMove < numIterBurnin_; ++iMove ) {
+void SVfitIntegratorMarkovChain::makeValidStochasticMove(unsigned idxMove, bool& isAccepted)
+{
 //--- propose Markov Chain transition to new, randomly chosen, point
-      bool isAccepted = false;
-      bool isValid = true;
-      do {
-	makeStochasticMove(iMove, isAccepted, isValid);
-      } while ( !isValid );
-    }
-
-    unsigned idxBatch = iChain*numBatches_;
-
-    for ( unsigned iMove = 0; iMove < numIterSampling_; ++iMove ) {
-//--- propose Markov Chain transition to new, randomly chosen, point;
-//    evaluate "call-back" functions at this point
-      bool isAccepted = false;
-      bool isValid = true;
-      do {
-        makeStochasticMove(numIterBurnin_ + iMove, isAccepted, isValid);
-      } while ( !isValid );
-      if ( isAccepted ) {
-	if ( prob_ > probMax_ ) probMax_ = prob_;
-        ++numMoves_accepted_;
-      } else {
-        ++numMoves_rejected_;
-      }
+  isAccepted = false;
+  bool isValid = true;
+  do {
+    makeStochasticMove(idxMove, isAccepted, isValid);
+  } while ( !isValid );
+}
 
-      updateX(q_);
-      for ( std::vector<const ROOT::Math::Functor*>::const_iterator callBackFunction = callBackFunctions_.begin();
-            callBackFunction != callBackFunctions_.end(); ++callBackFunction ) {
-        (**callBackFunction)(x_);
-      }
+void SVfitIntegratorMarkovChain::evalCallBackFunctions(const std::vector<const ROOT::Math::Functor*>& callBackFunctions) const
+{
+  for ( std::vector<const ROOT::Math::Functor*>::const_iterator callBackFunction = callBackFunctions.begin();
+        callBackFunction != callBackFunctions.end(); ++callBackFunction ) {
+    (**callBackFunction)(x_);
+  }
+}
 
-      if ( tree_ ) {
-        treeMove_ = iMove;
-        treeIntegrand_ = prob_;
-        tree_->Fill();
-      }
+void SVfitIntegratorMarkovChain::recordSample(unsigned iMove, bool isAccepted, unsigned& idxBatch)
+{
+  if ( isAccepted ) {
+    if ( prob_ > probMax_ ) probMax_ = prob_;
+    ++numMoves_accepted_;
+  } else {
+    ++numMoves_rejected_;
+  }
 
-      if ( iMove > 0 && (iMove % m) == 0 ) ++idxBatch;
-      assert(idxBatch < (numChains_*numBatches_));
-      probSum_[idxBatch] += prob_;
-    }
+  updateX(q_);
 
-    ++numChainsRun_;
+  if ( chainWriter_ ) {
+    chainWriter_->write(iMove, prob_);
+  }
+  if ( chainRecorder_ ) {
+    chainRecorder_->record(iMove, prob_, x_);
   }
 
+  unsigned m = numIterSampling_/numBatches_;
+  if ( iMove > 0 && (iMove % m) == 0 ) ++idxBatch;
+  assert(idxBatch < probSum_.size());
+  probSum_[idxBatch] += prob_;
+}
+
+void SVfitIntegratorMarkovChain::compIntegral(double& integral, double& integralErr)
+{
+  unsigned k = probSum_.size();
+  unsigned m = numIterSampling_/numBatches_;
+
   for ( unsigned idxBatch = 0; idxBatch < probSum_.size(); ++idxBatch ) {
     integral_[idxBatch] = probSum_[idxBatch]/m;
     if ( verbosity_ >= 1 ) std::cout << "integral[" << idxBatch << "] = " << integral_[idxBatch] << std::endl;
   }
 
+//--- CV: if the integration was stopped by the time budget, use the batches completed before;
+//        if not even the first batch was completed, use the iterations of the first batch that were made
+  if ( isStoppedByTimeBudget_ ) {
+    k = numBatchesCompleted_;
+    if ( k == 0 ) {
+      integral_[0] = ( numIterSampling_done_ > 0 ) ? probSum_[0]/numIterSampling_done_ : 0.;
+      k = 1;
+    }
+  }
+
 //--- compute integral value and uncertainty
 //   (eqs. (6.39) and (6.40) in [1])
   integral = 0.;
@@ -328,9 +452,14 @@ void SVfitIntegratorMarkovChain::integrate(gPtr_C g, const double* xl, const dou
     integralErr += square(integral_[i] - integral);
   }
   if ( k >= 2 ) integralErr /= (k*(k - 1));
-  integralErr = TMath::Sqrt(integralErr);
+  integralErr = std::sqrt(integralErr);
 
   if ( verbosity_ >= 1 ) std::cout << "--> returning integral = " << integral << " +/- " << integralErr << std::endl;
+}
+
+void SVfitIntegratorMarkovChain::finishIntegration(double& integral, double& integralErr)
+{
+  compIntegral(integral, integralErr);
 
   errorFlag_ = ( numChainsRun_ >= 0.5*numChains_ ) ? 0 : 1;
 
@@ -338,17 +467,30 @@ void SVfitIntegratorMarkovChain::integrate(gPtr_C g, const double* xl, const dou
   numMovesTotal_accepted_ += numMoves_accepted_;
   numMovesTotal_rejected_ += numMoves_rejected_;
 
-  if ( tree_ ) {
-    tree_->Write();
+  if ( chainWriter_ ) {
+    chainWriter_->endIntegration();
+  }
+
+  if ( chainRecorder_ ) {
+    chainRecorder_->endEvent();
   }
-  delete treeFile_;
-  treeFile_ = 0;
-  //delete tree_;
-  tree_ = 0;
+  ++eventId_;
 
   if ( verbosity_ >= 1 ) print(std::cout);
 }
 
+void SVfitIntegratorMarkovChain::finishContinuation(double& integral, double& integralErr, long numMoves_accepted, long numMoves_rejected)
+{
+  compIntegral(integral, integralErr);
+
+  numMovesTotal_accepted_ += (numMoves_accepted_ - numMoves_accepted);
+  numMovesTotal_rejected_ += (numMoves_rejected_ - numMoves_rejected);
+
+  if ( chainRecorder_ ) {
+    chainRecorder_->endEvent();
+  }
+}
+
 void SVfitIntegratorMarkovChain::print(std::ostream& stream) const
 {
   stream << "<SVfitIntegratorMarkovChain::print>:" << std::endl;
@@ -368,7 +510,7 @@ void SVfitIntegratorMarkovChain::print(std::ostream& stream) const
       integralErr += square(integral_i - integral);
     }
     if ( numBatches_ >= 2 ) integralErr /= (numBatches_*(numBatches_ - 1));
-    integralErr = TMath::Sqrt(integralErr);
+    integralErr = std::sqrt(integralErr);
 
     std::cout << " chain #" << iChain << ": integral = " << integral << " +/- " << integralErr << std::endl;
   }
@@ -388,8 +530,8 @@ void SVfitIntegratorMarkovChain::initializeStartPosition_and_Momentum()
     bool isInitialized = false;
     while ( !isInitialized ) {
       double q0 = 0.;
-      if ( initMode_ == kGaus ) q0 = rnd_.Gaus(0.5, 0.5);
-      else q0 = rnd_.Uniform(0., 1.);
+      if ( initMode_ == kGaus ) q0 = rnd_.gaus(0.5, 0.5);
+      else q0 = rnd_.uniform(0., 1.);
       if ( q0 > 0. && q0 < 1. ) {
   q_[iDimension] = q0;
   isInitialized = true;
@@ -413,11 +555,11 @@ void SVfitIntegratorMarkovChain::sampleSphericallyRandom()
 //
   double uMag2 = 0.;
   for ( unsigned iDimension = 0; iDimension < 2*numDimensions_; ++iDimension ) {
-    double u_i = rnd_.Gaus(0., 1.);
+    double u_i = rnd_.gaus(0., 1.);
     u_[iDimension] = u_i;
     uMag2 += (u_i*u_i);
   }
-  double uMag = TMath::Sqrt(uMag2);
+  double uMag = std::sqrt(uMag2);
   for ( unsigned iDimension = 0; iDimension < 2*numDimensions_; ++iDimension ) {
     u_[iDimension] /= uMag;
   }
@@ -431,7 +573,7 @@ void SVfitIntegratorMarkovChain::makeStochasticMove(unsigned idxMove, bool& isAc
 //--- perform random updates of momentum components
   if ( idxMove < numIterSimAnnealingPhase1_ ) {
     for ( unsigned iDimension = 0; iDimension < 2*numDimensions_; ++iDimension ) {
-      p_[iDimension] = sqrtT0_*rnd_.Gaus(0., 1.);
+      p_[iDimension] = sqrtT0_*rnd_.gaus(0., 1.);
     }
   } else if ( idxMove < numIterSimAnnealingPhase1plus2_ ) {
     double pMag2 = 0.;
@@ -439,23 +581,23 @@ void SVfitIntegratorMarkovChain::makeStochasticMove(unsigned idxMove, bool& isAc
       double p_i = p_[iDimension];
       pMag2 += p_i*p_i;
     }
-    double pMag = TMath::Sqrt(pMag2);
+    double pMag = std::sqrt(pMag2);
     sampleSphericallyRandom();
     for ( unsigned iDimension = 0; iDimension < 2*numDimensions_; ++iDimension ) {
-      p_[iDimension] = alpha_*pMag*u_[iDimension] + (1. - alpha2_)*rnd_.Gaus(0., 1.);
+      p_[iDimension] = alpha_*pMag*u_[iDimension] + (1. - alpha2_)*rnd_.gaus(0., 1.);
     }
   } else {
     for ( unsigned iDimension = 0; iDimension < 2*numDimensions_; ++iDimension ) {
-      p_[iDimension] = rnd_.Gaus(0., 1.);
+      p_[iDimension] = rnd_.gaus(0., 1.);
     }
   }
 
 //--- choose random step size
   double exp_nu_times_C = 0.;
   do {
-    double C = rnd_.BreitWigner(0., 1.);
-    exp_nu_times_C = TMath::Exp(nu_*C);
-  } while ( TMath::IsNaN(exp_nu_times_C) || !TMath::Finite(exp_nu_times_C) || exp_nu_times_C > 1.e+6 );
+    double C = rnd_.breitWigner(0., 1.);
+    exp_nu_times_C = std::exp(nu_*C);
+  } while ( std::isnan(exp_nu_times_C) || !std::isfinite(exp_nu_times_C) || exp_nu_times_C > 1.e+6 );
   for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
     epsilon_[iDimension] = epsilon0s_[iDimension]*exp_nu_times_C;
   }
@@ -472,7 +614,7 @@ void SVfitIntegratorMarkovChain::makeStochasticMove(unsigned idxMove, bool& isAc
 //   (take integration region to be "cyclic")
   for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
     double q_i = qProposal_[iDimension];
-    q_i = q_i - TMath::Floor(q_i);
+    q_i = q_i - std::floor(q_i);
     assert(q_i >= 0. && q_i <= 1.);
     qProposal_[iDimension] = q_i;
   }
@@ -483,15 +625,15 @@ void SVfitIntegratorMarkovChain::makeStochasticMove(unsigned idxMove, bool& isAc
   double probProposal = evalProb(qProposal_);
 
   double deltaE = 0.;
-  if      ( probProposal > 0. && prob_ > 0. ) deltaE = -TMath::Log(probProposal/prob_);
+  if      ( probProposal > 0. && prob_ > 0. ) deltaE = -std::log(probProposal/prob_);
   else if ( probProposal > 0.               ) deltaE = -std::numeric_limits<double>::max();
   else if (                      prob_ > 0. ) deltaE = +std::numeric_limits<double>::max();
   else assert(0);
 
   // Metropolis algorithm: move according to eq. (13) in [2]
-  double pAccept = TMath::Exp(-deltaE);
+  double pAccept = std::exp(-deltaE);
 
-  double u = rnd_.Uniform(0., 1.);
+  double u = rnd_.uniform(0., 1.);
 
   if ( u < pAccept ) {
     for ( unsigned iDimension = 0; iDimension < numDimensions_; ++iDimension ) {
@@ -515,5 +657,7 @@ void SVfitIntegratorMarkovChain::updateX(const std::vector<double>& q)
 double SVfitIntegratorMarkovChain::evalProb(const std::vector<double>& q)
 {
   double prob = (*integrand_)(q.data(), numDimensions_, 0);
+  ++numIntegrandCalls_;
+  if ( !(prob > 0.) ) ++numIntegrandCalls_zeroProb_;
   return prob;
 }
@@ -0,0 +1,103 @@
+#include "TauAnalysis/ClassicSVfit/interface/svFitCollinearApproximation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <assert.h>
+
+using namespace classic_svFit;
+
+namespace
+{
+  double compTransverseMass2(double px1, double py1, double pt1, double px2, double py2, double pt2)
+  {
+    // CV: mT^2 = 2 pT1 pT2 (1 - cos(dPhi))
+    return std::max(0., 2.*(pt1*pt2 - (px1*px2 + py1*py2)));
+  }
+}
+
+SVfitApproximation::SVfitApproximation()
+  : visibleMass_(0.)
+  , collinearMass_(0.)
+  , collinearMassErr_(0.)
+  , x1_(0.)
+  , x2_(0.)
+  , isValidCollinearSolution_(false)
+  , totalTransverseMass_(0.)
+{}
+
+bool SVfitApproximation::isCompatible(double massMin, double massMax, double numSigma, double margin) const
+{
+  if ( visibleMass_ > massMax ) return false;
+  if ( isValidCollinearSolution_ && (collinearMass_ + numSigma*collinearMassErr_) < (1. - margin)*massMin ) return false;
+  return true;
+}
+
+SVfitApproximation classic_svFit::compApproximation(const std::vector<MeasuredTauLepton>& measuredTauLeptons,
+                                                    double measuredMETx, double measuredMETy, const Matrix2x2& covMET)
+{
+  assert(measuredTauLeptons.size() == 2);
+  const MeasuredTauLepton& measuredTauLepton1 = measuredTauLeptons[0];
+  const MeasuredTauLepton& measuredTauLepton2 = measuredTauLeptons[1];
+
+  SVfitApproximation approximation;
+  approximation.visibleMass_ = compMass(measuredTauLepton1.p4() + measuredTauLepton2.p4());
+
+  double px1 = measuredTauLepton1.px();
+  double py1 = measuredTauLepton1.py();
+  double pt1 = measuredTauLepton1.pt();
+  double px2 = measuredTauLepton2.px();
+  double py2 = measuredTauLepton2.py();
+  double pt2 = measuredTauLepton2.pt();
+  double met = std::sqrt(square(measuredMETx) + square(measuredMETy));
+  approximation.totalTransverseMass_ = std::sqrt(compTransverseMass2(px1, py1, pt1, px2, py2, pt2)
+                                               + compTransverseMass2(px1, py1, pt1, measuredMETx, measuredMETy, met)
+                                               + compTransverseMass2(px2, py2, pt2, measuredMETx, measuredMETy, met));
+
+//--- collinear approximation: MET = a1*vis1 + a2*vis2 in the transverse plane, with ai = (1 - xi)/xi,
+//    solved for both ai if both leptons originate from tau decays, else for the tau lepton only (least squares).
+//    The derivatives dai/dMET are used to propagate the MET covariance to the collinear mass
+  bool isPrompt1 = ( measuredTauLepton1.type() == MeasuredTauLepton::kPrompt );
+  bool isPrompt2 = ( measuredTauLepton2.type() == MeasuredTauLepton::kPrompt );
+  double a1 = 0.;
+  double a2 = 0.;
+  double da1_dMETx = 0.;
+  double da1_dMETy = 0.;
+  double da2_dMETx = 0.;
+  double da2_dMETy = 0.;
+  if ( !isPrompt1 && !isPrompt2 ) {
+    double det = px1*py2 - py1*px2;
+    // CV: no solution if the visible decay products are (anti)parallel in the transverse plane
+    if ( std::fabs(det) < 1.e-6*pt1*pt2 ) return approximation;
+    a1 = (measuredMETx*py2 - measuredMETy*px2)/det;
+    a2 = (px1*measuredMETy - py1*measuredMETx)/det;
+    da1_dMETx = py2/det;
+    da1_dMETy = -px2/det;
+    da2_dMETx = -py1/det;
+    da2_dMETy = px1/det;
+  } else if ( !isPrompt1 ) {
+    if ( !(pt1 > 0.) ) return approximation;
+    a1 = (measuredMETx*px1 + measuredMETy*py1)/square(pt1);
+    da1_dMETx = px1/square(pt1);
+    da1_dMETy = py1/square(pt1);
+  } else if ( !isPrompt2 ) {
+    if ( !(pt2 > 0.) ) return approximation;
+    a2 = (measuredMETx*px2 + measuredMETy*py2)/square(pt2);
+    da2_dMETx = px2/square(pt2);
+    da2_dMETy = py2/square(pt2);
+  }
+  if ( !(a1 > -1. && a2 > -1.) ) return approximation;
+  approximation.x1_ = 1./(1. + a1);
+  approximation.x2_ = 1./(1. + a2);
+  approximation.isValidCollinearSolution_ = ( a1 >= 0. && a2 >= 0. );
+  approximation.collinearMass_ = approximation.visibleMass_*std::sqrt((1. + a1)*(1. + a2));
+
+//--- dm/dai = m/(2*(1 + ai))
+  double dm_da1 = 0.5*approximation.collinearMass_/(1. + a1);
+  double dm_da2 = 0.5*approximation.collinearMass_/(1. + a2);
+  double dm_dMETx = dm_da1*da1_dMETx + dm_da2*da2_dMETx;
+  double dm_dMETy = dm_da1*da1_dMETy + dm_da2*da2_dMETy;
+  double collinearMassErr2 = dm_dMETx*(covMET.xx_*dm_dMETx + covMET.xy_*dm_dMETy) + dm_dMETy*(covMET.yx_*dm_dMETx + covMET.yy_*dm_dMETy);
+  approximation.collinearMassErr_ = std::sqrt(std::max(0., collinearMassErr2));
+
+  return approximation;
+}
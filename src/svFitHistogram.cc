@@ -0,0 +1,82 @@
+#include "TauAnalysis/ClassicSVfit/interface/svFitHistogram.h"
+
+using namespace classic_svFit;
+
+HistogramBinning::HistogramBinning()
+  : numBins_(0)
+  , xMin_(0.)
+  , xMax_(0.)
+{}
+
+SVfitHistogram::SVfitHistogram()
+  : numEntries_(0.)
+  , sumw_(0.)
+  , sumwx_(0.)
+  , sumwx2_(0.)
+{}
+
+void SVfitHistogram::setBinning(const HistogramBinning& binning)
+{
+  binning_.numBins_ = binning.numBins_;
+  binning_.xMin_ = binning.xMin_;
+  binning_.xMax_ = binning.xMax_;
+  // CV: assign reuses the memory of the vectors if their capacity is sufficient
+  binning_.binEdges_.assign(binning.binEdges_.begin(), binning.binEdges_.end());
+  if ( !binning_.binEdges_.empty() ) {
+    binning_.xMin_ = binning_.binEdges_.front();
+    binning_.xMax_ = binning_.binEdges_.back();
+  }
+  binContents_.assign(binning_.numBins_ + 2, 0.);
+  reset();
+}
+
+void SVfitHistogram::reset()
+{
+  std::fill(binContents_.begin(), binContents_.end(), 0.);
+  numEntries_ = 0.;
+  sumw_ = 0.;
+  sumwx_ = 0.;
+  sumwx2_ = 0.;
+}
+
+//--- CV: the bin edges and widths are computed by the same expressions as in TAxis
+double SVfitHistogram::getBinLowEdge(int bin) const
+{
+  if ( !binning_.binEdges_.empty() && bin > 0 && bin <= binning_.numBins_ ) return binning_.binEdges_[bin - 1];
+  double binWidth = (binning_.xMax_ - binning_.xMin_)/binning_.numBins_;
+  return binning_.xMin_ + (bin - 1)*binWidth;
+}
+
+double SVfitHistogram::getBinWidth(int bin) const
+{
+  if ( binning_.numBins_ <= 0 ) return 0.;
+  if ( binning_.binEdges_.empty() ) return (binning_.xMax_ - binning_.xMin_)/binning_.numBins_;
+  bin = std::max(1, std::min(bin, binning_.numBins_));
+  return binning_.binEdges_[bin] - binning_.binEdges_[bin - 1];
+}
+
+double SVfitHistogram::getBinCenter(int bin) const
+{
+  if ( binning_.binEdges_.empty() || bin < 1 || bin > binning_.numBins_ ) {
+    double binWidth = (binning_.xMax_ - binning_.xMin_)/binning_.numBins_;
+    return binning_.xMin_ + (bin - 1)*binWidth + 0.5*binWidth;
+  } else {
+    double binWidth = binning_.binEdges_[bin] - binning_.binEdges_[bin - 1];
+    return binning_.binEdges_[bin - 1] + 0.5*binWidth;
+  }
+}
+
+void SVfitHistogram::getStats(double* stats) const
+{
+  stats[0] = sumw_;
+  stats[1] = sumw_; // CV: all entries have unit weight
+  stats[2] = sumwx_;
+  stats[3] = sumwx2_;
+}
+
+void SVfitHistogram::putStats(const double* stats)
+{
+  sumw_ = stats[0];
+  sumwx_ = stats[2];
+  sumwx2_ = stats[3];
+}
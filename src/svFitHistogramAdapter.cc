@@ -1,128 +1,332 @@
 #include "TauAnalysis/ClassicSVfit/interface/svFitHistogramAdapter.h"
 
-#include <TMath.h>
-#include <TFile.h>
-#include <TObject.h>
-#include <TLorentzVector.h>
-
 #include <numeric>
-
-#include <boost/algorithm/string/replace.hpp>
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+#include <limits>
 
 using namespace classic_svFit;
 
-TH1* HistogramTools::compHistogramDensity(TH1 const* histogram)
+namespace
+{
+  /// index of the last element of the given sorted array that is smaller than or equal to the given value, as TMath::BinarySearch
+  long binarySearch(long n, const double* array, double value)
+  {
+    const double* pind = std::lower_bound(array, array + n, value);
+    if ( pind != (array + n) && (*pind) == value ) return pind - array;
+    else return pind - array - 1;
+  }
+}
+
+HistogramProperties::HistogramProperties()
+  : xMaximum_(0.)
+  , xMaximum_interpol_(0.)
+  , xMean_(0.)
+  , xQuantile016_(0.)
+  , xQuantile050_(0.)
+  , xQuantile084_(0.)
+  , Lmax_(0.)
+{}
+
+void HistogramTools::extractHistogramProperties(const SVfitHistogram& histogram, HistogramProperties& properties)
 {
-  TH1* histogram_density = static_cast<TH1*>(histogram->Clone((std::string(histogram->GetName()) + "_density").c_str()));
-  histogram_density->Scale(1.0, "width");
-  return histogram_density;
+  std::vector<double> workspace;
+  extractHistogramProperties(histogram, properties, workspace);
 }
 
-void HistogramTools::extractHistogramProperties(
-    TH1 const* histogram,
-    double& xMaximum,
-    double& xMaximum_interpol,
-    double& xMean,
-    double& xQuantile016,
-    double& xQuantile050,
-    double& xQuantile084
-)
+void HistogramTools::extractHistogramProperties(const SVfitHistogram& histogram, HistogramProperties& properties, std::vector<double>& workspace)
 {
+  // CV: compute all properties in a single pass over the histogram bins,
+  //     avoiding to clone the histogram in order to obtain its density.
+  //     The quantiles are computed following the same algorithm as TH1::GetQuantiles
+  int numBins = histogram.getNumBins();
+  workspace.assign(numBins + 1, 0.);
+  double* integral = workspace.data();
+  int binMaximum = 0;
+  double yMaximum = -std::numeric_limits<double>::max();
+  for ( int idxBin = 1; idxBin <= numBins; ++idxBin ) {
+    double binContent = histogram.getBinContent(idxBin);
+    integral[idxBin] = integral[idxBin - 1] + binContent;
+    double binDensity = binContent/histogram.getBinWidth(idxBin);
+    if ( binDensity > yMaximum ) {
+      binMaximum = idxBin;
+      yMaximum = binDensity;
+    }
+  }
+
   // compute median, -1 sigma and +1 sigma limits on reconstructed mass
-  if ( histogram->Integral() > 0. ) {
-    Double_t q[3];
-    Double_t probSum[3];
-    probSum[0] = 0.16;
-    probSum[1] = 0.50;
-    probSum[2] = 0.84;
-    (const_cast<TH1*>(histogram))->GetQuantiles(3, q, probSum);
-    xQuantile016 = q[0];
-    xQuantile050 = q[1];
-    xQuantile084 = q[2];
+  if ( integral[numBins] > 0. ) {
+    for ( int idxBin = 1; idxBin <= numBins; ++idxBin ) {
+      integral[idxBin] /= integral[numBins];
+    }
+    const double probSum[3] = { 0.16, 0.50, 0.84 };
+    double q[3];
+    for ( int idxQuantile = 0; idxQuantile < 3; ++idxQuantile ) {
+      int idxBin = binarySearch(numBins, integral, probSum[idxQuantile]);
+      while ( idxBin < (numBins - 1) && integral[idxBin + 1] == probSum[idxQuantile] ) {
+        if ( integral[idxBin + 2] == probSum[idxQuantile] ) ++idxBin;
+        else break;
+      }
+      q[idxQuantile] = histogram.getBinLowEdge(idxBin + 1);
+      double dIntegral = integral[idxBin + 1] - integral[idxBin];
+      if ( dIntegral > 0. ) q[idxQuantile] += histogram.getBinWidth(idxBin + 1)*(probSum[idxQuantile] - integral[idxBin])/dIntegral;
+    }
+    properties.xQuantile016_ = q[0];
+    properties.xQuantile050_ = q[1];
+    properties.xQuantile084_ = q[2];
   } else {
-    xQuantile016 = 0.;
-    xQuantile050 = 0.;
-    xQuantile084 = 0.;
+    properties.xQuantile016_ = 0.;
+    properties.xQuantile050_ = 0.;
+    properties.xQuantile084_ = 0.;
   }
 
-  xMean = histogram->GetMean();
+  properties.xMean_ = histogram.getMean();
 
-  TH1* histogram_density = HistogramTools::compHistogramDensity(histogram);
-  if ( histogram_density->Integral() > 0. ) {
-    int binMaximum = histogram_density->GetMaximumBin();
-    xMaximum = histogram_density->GetBinCenter(binMaximum);
-    double yMaximum = histogram_density->GetBinContent(binMaximum);
-    if ( binMaximum > 1 && binMaximum < histogram_density->GetNbinsX() ) {
+  if ( integral[numBins] > 0. ) {
+    properties.xMaximum_ = histogram.getBinCenter(binMaximum);
+    if ( binMaximum > 1 && binMaximum < numBins ) {
       int binLeft       = binMaximum - 1;
-      double xLeft      = histogram_density->GetBinCenter(binLeft);
-      double yLeft      = histogram_density->GetBinContent(binLeft);
+      double xLeft      = histogram.getBinCenter(binLeft);
+      double yLeft      = histogram.getBinContent(binLeft)/histogram.getBinWidth(binLeft);
 
       int binRight      = binMaximum + 1;
-      double xRight     = histogram_density->GetBinCenter(binRight);
-      double yRight     = histogram_density->GetBinContent(binRight);
+      double xRight     = histogram.getBinCenter(binRight);
+      double yRight     = histogram.getBinContent(binRight)/histogram.getBinWidth(binRight);
 
-      double xMinus     = xLeft - xMaximum;
+      double xMinus     = xLeft - properties.xMaximum_;
       double yMinus     = yLeft - yMaximum;
-      double xPlus      = xRight - xMaximum;
+      double xPlus      = xRight - properties.xMaximum_;
       double yPlus      = yRight - yMaximum;
 
-      xMaximum_interpol = xMaximum + 0.5*(yPlus*square(xMinus) - yMinus*square(xPlus))/(yPlus*xMinus - yMinus*xPlus);
+      properties.xMaximum_interpol_ = properties.xMaximum_ + 0.5*(yPlus*square(xMinus) - yMinus*square(xPlus))/(yPlus*xMinus - yMinus*xPlus);
     } else {
-      xMaximum_interpol = xMaximum;
+      properties.xMaximum_interpol_ = properties.xMaximum_;
     }
   } else {
-    xMaximum = 0.;
-    xMaximum_interpol = 0.;
+    properties.xMaximum_ = 0.;
+    properties.xMaximum_interpol_ = 0.;
   }
-  delete histogram_density;
+
+  properties.Lmax_ = ( numBins > 0 ) ? yMaximum : 0.;
+}
+
+void HistogramTools::extractSampleProperties(std::vector<double>& samples, HistogramProperties& properties)
+{
+  std::vector<double> workspace;
+  extractSampleProperties(samples, properties, workspace);
 }
 
-double HistogramTools::extractValue(TH1 const* histogram)
+void HistogramTools::extractSampleProperties(std::vector<double>& samples, HistogramProperties& properties, std::vector<double>& workspace)
 {
-  double maximum, maximum_interpol, mean, quantile016, quantile050, quantile084;
-  HistogramTools::extractHistogramProperties(histogram, maximum, maximum_interpol, mean, quantile016, quantile050, quantile084);
-  double value = maximum;
-  return value;
+  extractSampleProperties(samples.data(), samples.size(), properties, workspace);
 }
 
-double HistogramTools::extractUncertainty(TH1 const* histogram)
+void HistogramTools::extractSampleProperties(double* samples, size_t numSamples, HistogramProperties& properties, std::vector<double>& workspace)
 {
-  double maximum, maximum_interpol, mean, quantile016, quantile050, quantile084;
-  HistogramTools::extractHistogramProperties(histogram, maximum, maximum_interpol, mean, quantile016, quantile050, quantile084);
-  double uncertainty = TMath::Sqrt(0.5*(TMath::Power(quantile084 - maximum, 2.) + TMath::Power(maximum - quantile016, 2.)));
-  return uncertainty;
+  if ( numSamples == 0 ) return;
+  double* samples_end = samples + numSamples;
+
+  double sum = 0.;
+  double sum2 = 0.;
+  for ( const double* sample = samples; sample != samples_end; ++sample ) {
+    sum += (*sample);
+    sum2 += square(*sample);
+  }
+  properties.xMean_ = sum/numSamples;
+  double sigma = std::sqrt(std::max(0., sum2/numSamples - square(properties.xMean_)));
+
+  // CV: compute quantiles by linear interpolation between adjacent order statistics.
+  //     The probabilities are processed in increasing order,
+  //     so that each call to nth_element only needs to consider the samples above the previous quantile
+  const double probSum[5] = { 0.01, 0.16, 0.50, 0.84, 0.99 };
+  double q[5];
+  double* first = samples;
+  for ( int idxQuantile = 0; idxQuantile < 5; ++idxQuantile ) {
+    double h = probSum[idxQuantile]*(numSamples - 1);
+    size_t k = (size_t)h;
+    double* kth = samples + k;
+    std::nth_element(first, kth, samples_end);
+    q[idxQuantile] = (*kth);
+    if ( (k + 1) < numSamples ) {
+      double next = *std::min_element(kth + 1, samples_end);
+      q[idxQuantile] += (h - k)*(next - (*kth));
+    }
+    first = kth;
+  }
+  properties.xQuantile016_ = q[1];
+  properties.xQuantile050_ = q[2];
+  properties.xQuantile084_ = q[3];
+
+  // CV: locate the maximum of a Gaussian kernel density estimate,
+  //     computed on a grid spanning the central 98% of the samples, with the bandwidth given by Silverman's rule of thumb.
+  //     The samples are assigned to the grid points by linear binning before the convolution with the kernel
+  //    (B. W. Silverman, "Density Estimation for Statistics and Data Analysis", Chapman & Hall (1986))
+  double xMin = q[0];
+  double xMax = q[4];
+  double spread = std::min(sigma, 0.5*(q[3] - q[1]));
+  double bandwidth = 0.9*spread*std::pow(numSamples, -0.2);
+  if ( !(xMax > xMin) || !(bandwidth > 0.) ) return;
+  const int numGridPoints = 512;
+  double dx = (xMax - xMin)/(numGridPoints - 1);
+  int numKernelPoints = std::min(numGridPoints - 1, (int)std::ceil(4.*bandwidth/dx));
+  workspace.assign(2*numGridPoints + numKernelPoints + 1, 0.);
+  double* counts = workspace.data();
+  double* density = counts + numGridPoints;
+  double* kernel = density + numGridPoints;
+  for ( const double* sample = samples; sample != samples_end; ++sample ) {
+    if ( (*sample) < xMin || (*sample) > xMax ) continue;
+    double u = ((*sample) - xMin)/dx;
+    int idx = std::min((int)u, numGridPoints - 2);
+    double w = u - idx;
+    counts[idx] += (1. - w);
+    counts[idx + 1] += w;
+  }
+  for ( int idx = 0; idx <= numKernelPoints; ++idx ) {
+    kernel[idx] = std::exp(-0.5*square(idx*dx/bandwidth))/(std::sqrt(2.*M_PI)*bandwidth);
+  }
+  int idxMaximum = 0;
+  for ( int idx = 0; idx < numGridPoints; ++idx ) {
+    double density_i = 0.;
+    int idxMin = std::max(0, idx - numKernelPoints);
+    int idxMax = std::min(numGridPoints - 1, idx + numKernelPoints);
+    for ( int idx_j = idxMin; idx_j <= idxMax; ++idx_j ) {
+      density_i += counts[idx_j]*kernel[std::abs(idx - idx_j)];
+    }
+    density[idx] = density_i;
+    if ( density_i > density[idxMaximum] ) idxMaximum = idx;
+  }
+  properties.xMaximum_ = xMin + idxMaximum*dx;
+  properties.xMaximum_interpol_ = properties.xMaximum_;
+  if ( idxMaximum > 0 && idxMaximum < (numGridPoints - 1) ) {
+    double yLeft = density[idxMaximum - 1];
+    double yRight = density[idxMaximum + 1];
+    double curvature = yLeft - 2.*density[idxMaximum] + yRight;
+    if ( curvature < 0. ) properties.xMaximum_interpol_ += 0.5*dx*(yLeft - yRight)/curvature;
+  }
+  // CV: normalize maximum to number of samples per unit of x, as for histograms
+  properties.Lmax_ = density[idxMaximum];
 }
 
-double HistogramTools::extractLmax(TH1 const* histogram)
+double HistogramTools::compUncertainty(const HistogramProperties& properties)
 {
-  TH1* histogram_density = HistogramTools::compHistogramDensity(histogram);
-  double Lmax = histogram_density->GetMaximum();
-  delete histogram_density;
-  return Lmax;
+  return std::sqrt(0.5*(square(properties.xQuantile084_ - properties.xMaximum_) + square(properties.xMaximum_ - properties.xQuantile016_)));
 }
 
-TH1* HistogramTools::makeHistogram_linBinWidth(const std::string& histogramName, int numBins, double xMin, double xMax)
+void HistogramTools::compBinning_linBinWidth(int numBins, double xMin, double xMax, HistogramBinning& binning)
 {
-  TH1* histogram = new TH1D(histogramName.data(), histogramName.data(), numBins, xMin, xMax);
-  return histogram;
+  binning.numBins_ = numBins;
+  binning.xMin_ = xMin;
+  binning.xMax_ = xMax;
+  binning.binEdges_.clear();
 }
 
-TH1* HistogramTools::makeHistogram_logBinWidth(const std::string& histogramName, double xMin, double xMax, double logBinWidth)
+int HistogramTools::getNumBins_logBinWidth(double xMin, double xMax, double logBinWidth)
 {
   if ( xMin <= 0. ) xMin = 0.1;
-  int numBins = 1 + TMath::Log(xMax/xMin)/TMath::Log(logBinWidth);
-  TArrayF binning(numBins + 1);
-  binning[0] = 0.;
+  return 1 + std::log(xMax/xMin)/std::log(logBinWidth);
+}
+
+void HistogramTools::compBinning_logBinWidth(double xMin, double xMax, double logBinWidth, HistogramBinning& binning)
+{
+  if ( xMin <= 0. ) xMin = 0.1;
+  int numBins = getNumBins_logBinWidth(xMin, xMax, logBinWidth);
+  // CV: bin edges are rounded to single precision, for compatibility with histograms booked by previous versions
+  binning.binEdges_.resize(numBins + 1);
+  binning.binEdges_[0] = 0.;
   double x = xMin;
   for ( int idxBin = 1; idxBin <= numBins; ++idxBin ) {
-    binning[idxBin] = x;
+    binning.binEdges_[idxBin] = (float)x;
+    x *= logBinWidth;
+  }
+  binning.numBins_ = numBins;
+  binning.xMin_ = binning.binEdges_.front();
+  binning.xMax_ = binning.binEdges_.back();
+}
+
+void HistogramTools::compBinning_adaptiveLogBinWidth(double xMin, double xMax, double xMinCore, double xMaxCore, int numBinsCore, double logBinWidthTails,
+                                                     HistogramBinning& binning)
+{
+  if ( xMin <= 0. ) xMin = 0.1;
+  xMinCore = std::max(xMin, xMinCore);
+  xMaxCore = std::min(xMax, xMaxCore);
+  if ( !(xMaxCore > xMinCore) ) {
+    compBinning_logBinWidth(xMin, xMax, logBinWidthTails, binning);
+    return;
+  }
+  // CV: number of bins in the tails is rounded up, so that the core range is covered exactly
+  int numBinsLow = (int)std::ceil(std::log(xMinCore/xMin)/std::log(logBinWidthTails));
+  int numBinsHigh = (int)std::ceil(std::log(xMax/xMaxCore)/std::log(logBinWidthTails));
+  int numBins = 1 + numBinsLow + numBinsCore + numBinsHigh;
+  binning.binEdges_.resize(numBins + 1);
+  binning.binEdges_[0] = 0.;
+  int idxBin = 1;
+  double x = xMin;
+  double logBinWidth = ( numBinsLow > 0 ) ? std::pow(xMinCore/xMin, 1./numBinsLow) : 1.;
+  for ( int idxBinLow = 0; idxBinLow < numBinsLow; ++idxBinLow ) {
+    binning.binEdges_[idxBin++] = (float)x;
+    x *= logBinWidth;
+  }
+  x = xMinCore;
+  logBinWidth = std::pow(xMaxCore/xMinCore, 1./numBinsCore);
+  for ( int idxBinCore = 0; idxBinCore < numBinsCore; ++idxBinCore ) {
+    binning.binEdges_[idxBin++] = (float)x;
+    x *= logBinWidth;
+  }
+  x = xMaxCore;
+  logBinWidth = ( numBinsHigh > 0 ) ? std::pow(xMax/xMaxCore, 1./numBinsHigh) : 1.;
+  for ( int idxBinHigh = 0; idxBinHigh <= numBinsHigh; ++idxBinHigh ) {
+    binning.binEdges_[idxBin++] = (float)x;
+    x *= logBinWidth;
+  }
+  assert(idxBin == (numBins + 1));
+  binning.numBins_ = numBins;
+  binning.xMin_ = binning.binEdges_.front();
+  binning.xMax_ = binning.binEdges_.back();
+}
+
+void HistogramTools::compBinning_compact(const HistogramBinning& binning, int maxNumBins, HistogramBinning& compactBinning)
+{
+  assert(maxNumBins > 0);
+  int numBinsMerged = (binning.numBins_ + maxNumBins - 1)/maxNumBins;
+  if ( numBinsMerged <= 1 ) {
+    compactBinning = binning;
+    return;
+  }
+  int numBins = (binning.numBins_ + numBinsMerged - 1)/numBinsMerged;
+  if ( binning.binEdges_.empty() ) {
+    compactBinning.binEdges_.clear();
+  } else {
+    // CV: the last bin contains the remaining numBins_ % numBinsMerged bins, so that the range is kept
+    compactBinning.binEdges_.resize(numBins + 1);
+    for ( int idxBin = 0; idxBin < numBins; ++idxBin ) {
+      compactBinning.binEdges_[idxBin] = binning.binEdges_[idxBin*numBinsMerged];
+    }
+    compactBinning.binEdges_[numBins] = binning.binEdges_.back();
+  }
+  compactBinning.numBins_ = numBins;
+  compactBinning.xMin_ = binning.xMin_;
+  compactBinning.xMax_ = binning.xMax_;
+}
+
+void HistogramTools::compBinning_extended(const HistogramBinning& binning, int numBins, HistogramBinning& extendedBinning)
+{
+  int numBins_given = binning.numBins_;
+  assert(binning.binEdges_.size() == (size_t)(numBins_given + 1) && numBins_given >= 2 && binning.binEdges_[numBins_given - 1] > 0. && numBins >= numBins_given);
+  extendedBinning.binEdges_.resize(numBins + 1);
+  std::copy(binning.binEdges_.begin(), binning.binEdges_.end(), extendedBinning.binEdges_.begin());
+  double logBinWidth = binning.binEdges_[numBins_given]/binning.binEdges_[numBins_given - 1];
+  double x = binning.binEdges_[numBins_given];
+  for ( int idxBin = numBins_given + 1; idxBin <= numBins; ++idxBin ) {
     x *= logBinWidth;
+    extendedBinning.binEdges_[idxBin] = (float)x;
   }
-  TH1* histogram = new TH1D(histogramName.data(), histogramName.data(), numBins, binning.GetArray());
-  return histogram;
+  extendedBinning.numBins_ = numBins;
+  extendedBinning.xMin_ = extendedBinning.binEdges_.front();
+  extendedBinning.xMax_ = extendedBinning.binEdges_.back();
 }
 
-int SVfitQuantity::nInstances = 0;
+std::atomic<int> SVfitQuantity::nInstances(0);
 
 SVfitQuantity::SVfitQuantity(const std::string& label) 
   : label_(label)
@@ -131,41 +335,125 @@ SVfitQuantity::SVfitQuantity(const std::string& label)
 
 SVfitQuantity::~SVfitQuantity()
 {
-  if ( histogram_ != nullptr ) delete histogram_;
+  delete histogram_;
 }
 
-const TH1* SVfitQuantity::getHistogram() const 
+const SVfitHistogram* SVfitQuantity::getHistogram() const 
 { 
   return histogram_;
 }
 
-void SVfitQuantity::writeHistogram() const
+void SVfitQuantity::setExtractionMode(int extractionMode)
 {
-  if ( histogram_ != nullptr ) {
-    std::string histogramName = histogram_->GetName();
-    boost::replace_all(histogramName, uniqueName_, "");
-    histogram_->Write(histogramName.c_str(), TObject::kWriteDelete);
+  extractionMode_ = extractionMode;
+  if ( extractionMode_ == kStreamingQuantiles ) {
+    if ( !digest_ ) digest_.reset(new TDigest());
+  } else {
+    digest_.reset();
+  }
+}
+
+void SVfitQuantity::setSampleBuffer(double* sampleBuffer, unsigned long sampleBufferSize)
+{
+  sampleBuffer_ = sampleBuffer;
+  sampleBufferSize_ = sampleBufferSize;
+  numSamples_ = 0;
+  samples_overflow_.clear();
+}
+
+void SVfitQuantity::bookHistogram(const HistogramBinning& binning_full)
+{
+  // CV: the memory of a histogram is reallocated whenever its number of bins exceeds the number of bins of the previous events.
+  //     Binnings that depend on the event are therefore extended by empty bins above their range to the same number of bins for all events,
+  //     which leaves the extracted values unchanged
+  const HistogramBinning* binning_booked = &binning_full;
+  if ( binning_full.numBins_ < numBins_fixed_ ) {
+    HistogramTools::compBinning_extended(binning_full, numBins_fixed_, binning_extended_);
+    binning_booked = &binning_extended_;
+  }
+  // CV: in kStreamingQuantiles mode, the histogram is used to determine the maximum only,
+  //     so a coarser binning is sufficient
+  if ( extractionMode_ == kStreamingQuantiles ) {
+    HistogramTools::compBinning_compact(*binning_booked, maxNumBins_compact, binning_compact_);
+    binning_booked = &binning_compact_;
   }
+  if ( histogram_ == nullptr ) histogram_ = new SVfitHistogram();
+  histogram_->setBinning(*binning_booked);
+  histogramProperties_isValid_ = false;
+}
+
+void SVfitQuantity::resetHistogram()
+{
+  delete histogram_;
+  histogram_ = nullptr;
+  histogramProperties_isValid_ = false;
+  setSampleBuffer(nullptr, 0);
 }
 
 void SVfitQuantity::fillHistogram(double value)
 {
-  histogram_->Fill(value);
+  histogram_->fill(value);
+  if ( extractionMode_ == kStreamingQuantiles ) {
+    digest_->add(value);
+  } else if ( extractionMode_ == kSampleStore ) {
+    if ( numSamples_ < sampleBufferSize_ ) {
+      sampleBuffer_[numSamples_] = value;
+    } else {
+      // CV: the number of samples exceeds the size of the slice of the sample pool,
+      //     so continue in a separate vector, which is allocated only in this case
+      if ( numSamples_ == sampleBufferSize_ ) samples_overflow_.assign(sampleBuffer_, sampleBuffer_ + numSamples_);
+      samples_overflow_.push_back(value);
+    }
+    ++numSamples_;
+  }
+  histogramProperties_isValid_ = false;
+}
+
+void SVfitQuantity::fillBurnin(double value)
+{
+  if ( numBurninValues_ == 0 || value < burninMin_ ) burninMin_ = value;
+  if ( numBurninValues_ == 0 || value > burninMax_ ) burninMax_ = value;
+  ++numBurninValues_;
+}
+
+const HistogramProperties& SVfitQuantity::getHistogramProperties() const
+{
+  if ( !histogramProperties_isValid_ ) {
+    if ( histogram_ != nullptr ) HistogramTools::extractHistogramProperties(*histogram_, histogramProperties_, workspace_);
+    else histogramProperties_ = HistogramProperties();
+    if ( extractionMode_ == kStreamingQuantiles && digest_ && digest_->getNumEntries() > 0 ) {
+      histogramProperties_.xMean_ = digest_->getMean();
+      histogramProperties_.xQuantile016_ = digest_->getQuantile(0.16);
+      histogramProperties_.xQuantile050_ = digest_->getQuantile(0.50);
+      histogramProperties_.xQuantile084_ = digest_->getQuantile(0.84);
+    } else if ( extractionMode_ == kSampleStore && numSamples_ > 0 ) {
+      double* samples = ( numSamples_ > sampleBufferSize_ ) ? samples_overflow_.data() : sampleBuffer_;
+      HistogramTools::extractSampleProperties(samples, numSamples_, histogramProperties_, workspace_);
+    }
+    histogramProperties_isValid_ = true;
+  }
+  return histogramProperties_;
+}
+
+void SVfitQuantity::setHistogramProperties(const HistogramProperties& properties)
+{
+  histogramProperties_ = properties;
+  histogramProperties_isValid_ = true;
 }
 
 double SVfitQuantity::extractValue() const
 {
-  return HistogramTools::extractValue(histogram_);
+  return getHistogramProperties().xMaximum_;
 }
 
 double SVfitQuantity::extractUncertainty() const
 {
-  return HistogramTools::extractUncertainty(histogram_);
+  return HistogramTools::compUncertainty(getHistogramProperties());
 }
 
 double SVfitQuantity::extractLmax() const
 {
-  return HistogramTools::extractLmax(histogram_);
+  return getHistogramProperties().Lmax_;
 }
 
 bool SVfitQuantity::isValidSolution() const
@@ -175,6 +463,7 @@ bool SVfitQuantity::isValidSolution() const
 
 HistogramAdapter::HistogramAdapter(const std::string& label) 
   : label_(label)
+  , extractionMode_(SVfitQuantity::kHistogram)
 {}
 
 HistogramAdapter::~HistogramAdapter()
@@ -185,19 +474,61 @@ HistogramAdapter::~HistogramAdapter()
   }
 }
 
-void HistogramAdapter::writeHistograms(const std::string& likelihoodFileName) const
+void HistogramAdapter::setExtractionMode(int extractionMode)
+{
+  extractionMode_ = extractionMode;
+  for ( std::vector<SVfitQuantity*>::iterator quantity = quantities_.begin();
+        quantity != quantities_.end(); ++quantity ) {
+    (*quantity)->setExtractionMode(extractionMode_);
+  }
+}
+
+void HistogramAdapter::reserveSamples(unsigned long numSamples)
+{
+  if ( extractionMode_ != SVfitQuantity::kSampleStore ) return;
+  quantities_sampled_.clear();
+  getBookedQuantities(quantities_sampled_);
+  // CV: the pool is never shrunk, so that memory is allocated only for the first event with the largest number of samples
+  size_t poolSize = quantities_sampled_.size()*numSamples;
+  if ( samplePool_.size() < poolSize ) samplePool_.resize(poolSize);
+  double* sampleBuffer = samplePool_.data();
+  for ( std::vector<SVfitQuantity*>::iterator quantity = quantities_sampled_.begin();
+        quantity != quantities_sampled_.end(); ++quantity ) {
+    (*quantity)->setSampleBuffer(sampleBuffer, numSamples);
+    sampleBuffer += numSamples;
+  }
+}
+
+void HistogramAdapter::getBookedQuantities(std::vector<SVfitQuantity*>& quantities) const
 {
-  TFile* likelihoodFile = new TFile(likelihoodFileName.data(), "RECREATE");
-  likelihoodFile->cd();
+  for ( std::vector<SVfitQuantity*>::const_iterator quantity = quantities_.begin();
+        quantity != quantities_.end(); ++quantity ) {
+    if ( (*quantity)->getHistogram() ) quantities.push_back(*quantity);
+  }
+}
 
-  for (std::vector<SVfitQuantity*>::iterator quantity = quantities_.begin(); 
-       quantity != quantities_.end(); ++quantity ) {
-    (*quantity)->writeHistogram();
+void HistogramAdapter::getHistogramProperties(std::vector<HistogramProperties>& properties) const
+{
+  for ( std::vector<SVfitQuantity*>::const_iterator quantity = quantities_.begin();
+        quantity != quantities_.end(); ++quantity ) {
+    properties.push_back((*quantity)->getHistogramProperties());
   }
+}
 
-  likelihoodFile->Write();
-  likelihoodFile->Close();
-  delete likelihoodFile;
+size_t HistogramAdapter::setHistogramProperties(const std::vector<HistogramProperties>& properties, size_t idx)
+{
+  for ( std::vector<SVfitQuantity*>::iterator quantity = quantities_.begin();
+        quantity != quantities_.end(); ++quantity ) {
+    assert(idx < properties.size());
+    (*quantity)->setHistogramProperties(properties[idx++]);
+  }
+  return idx;
+}
+
+void HistogramAdapter::hashConfiguration(SVfitHash& hash) const
+{
+  hash.add(extractionMode_);
+  hash.add(static_cast<unsigned>(quantities_.size()));
 }
 
 double HistogramAdapter::extractValue(const SVfitQuantity* quantity) const
@@ -218,7 +549,7 @@ double HistogramAdapter::extractLmax(const SVfitQuantity* quantity) const
 bool HistogramAdapter::isValidSolution() const
 {
   return std::accumulate(quantities_.begin(), quantities_.end(), true,
-                         [](bool result, SVfitQuantity* quantity) { return result && quantity->isValidSolution(); });
+                         [](bool result, SVfitQuantity* quantity) { return result && (!quantity->getHistogram() || quantity->isValidSolution()); });
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -229,36 +560,44 @@ SVfitQuantityTau::SVfitQuantityTau(const std::string& label)
 
 void SVfitQuantityTau::bookHistogram(const LorentzVector& visP4)
 {
-  if ( histogram_ != nullptr ) delete histogram_;
-  histogram_ = createHistogram(visP4);
-  histogram_->SetName(std::string(histogram_->GetName() + uniqueName_).c_str());
+  compBinning(visP4, binning_);
+  SVfitQuantity::bookHistogram(binning_);
+  if ( digest_ ) digest_->reset();
+  numSamples_ = 0;
+  samples_overflow_.clear();
 }
 
 SVfitQuantityTauPt::SVfitQuantityTauPt(const std::string& label)
   : SVfitQuantityTau(label)
-{}
+{
+  histogramName_ = "ClassicSVfitIntegrand_" + label_ + "_histogramPt";
+}
 
-TH1* SVfitQuantityTauPt::createHistogram(const LorentzVector& visP4) const
+void SVfitQuantityTauPt::compBinning(const LorentzVector& visP4, HistogramBinning& binning) const
 {
-  return HistogramTools::makeHistogram_logBinWidth("ClassicSVfitIntegrand_" + label_ + "_histogramPt", 1., 1.e+3, 1.025);
+  HistogramTools::compBinning_logBinWidth(1., 1.e+3, 1.025, binning);
 }
 
 SVfitQuantityTauEta::SVfitQuantityTauEta(const std::string& label)
   : SVfitQuantityTau(label)
-{}
+{
+  histogramName_ = "ClassicSVfitIntegrand_" + label_ + "_histogramEta";
+}
 
-TH1* SVfitQuantityTauEta::createHistogram(const LorentzVector& visP4) const
+void SVfitQuantityTauEta::compBinning(const LorentzVector& visP4, HistogramBinning& binning) const
 {
-  return HistogramTools::makeHistogram_linBinWidth("ClassicSVfitIntegrand_" + label_ + "_histogramEta", 198, -9.9, +9.9);
+  HistogramTools::compBinning_linBinWidth(198, -9.9, +9.9, binning);
 }
 
 SVfitQuantityTauPhi::SVfitQuantityTauPhi(const std::string& label)
   : SVfitQuantityTau(label)
-{}
+{
+  histogramName_ = "ClassicSVfitIntegrand_" + label_ + "_histogramEta";
+}
 
-TH1* SVfitQuantityTauPhi::createHistogram(const LorentzVector& visP4) const
+void SVfitQuantityTauPhi::compBinning(const LorentzVector& visP4, HistogramBinning& binning) const
 {
-  return HistogramTools::makeHistogram_linBinWidth("ClassicSVfitIntegrand_" + label_ + "_histogramEta", 180, -TMath::Pi(), +TMath::Pi());
+  HistogramTools::compBinning_linBinWidth(180, -M_PI, +M_PI, binning);
 }
 
 HistogramAdapterTau::HistogramAdapterTau(const std::string& label)
@@ -292,6 +631,13 @@ void HistogramAdapterTau::bookHistograms(const LorentzVector& visP4)
   quantity_phi_->bookHistogram(visP4);
 }
 
+void HistogramAdapterTau::resetHistograms()
+{
+  quantity_pt_->resetHistogram();
+  quantity_eta_->resetHistogram();
+  quantity_phi_->resetHistogram();
+}
+
 void HistogramAdapterTau::fillHistograms(const LorentzVector& tauP4, const LorentzVector& visP4) const
 {
   quantity_pt_->fillHistogram(tauP4.pt());
@@ -346,9 +692,7 @@ double HistogramAdapterTau::getPhiLmax() const
 
 classic_svFit::LorentzVector HistogramAdapterTau::getP4() const
 {
-  TLorentzVector p4;
-  p4.SetPtEtaPhiM(this->getPt(), this->getEta(), this->getPhi(), tauLeptonMass);
-  return classic_svFit::LorentzVector(p4.Px(), p4.Py(), p4.Pz(), p4.E());
+  return makeP4_PtEtaPhiM(this->getPt(), this->getEta(), this->getPhi(), tauLeptonMass);
 }
 
 double HistogramAdapterTau::DoEval(const double* x) const
@@ -360,72 +704,189 @@ double HistogramAdapterTau::DoEval(const double* x) const
 
 //-------------------------------------------------------------------------------------------------
 // auxiliary classes to reconstruct pT, eta, phi, mass, and transverse mass of tau lepton pairs
+namespace
+{
+  // CV: the mass and transverse mass histograms have logarithmic binning starting at the visible (transverse) mass, but at least 1 GeV,
+  //     and extending to at least 10 TeV; the histograms are booked with the number of bins of the range 1 GeV to 10 TeV,
+  //     which is the largest number of bins of any event
+  const double minMass_logBinWidth = 1.;
+  const double maxMass_logBinWidth = 1.e+4;
+}
+
 SVfitQuantityDiTau::SVfitQuantityDiTau(const std::string& label)
   : SVfitQuantity(label)
 {}
 
 void SVfitQuantityDiTau::bookHistogram(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met)
 {
-  if ( histogram_ != nullptr ) delete histogram_;
-  histogram_ = createHistogram(vis1P4, vis2P4, met);
-  histogram_->SetName(std::string(histogram_->GetName() + uniqueName_).c_str());
+  compBinning(vis1P4, vis2P4, met, binning_);
+  SVfitQuantity::bookHistogram(binning_);
+  if ( digest_ ) digest_->reset();
+  numSamples_ = 0;
+  samples_overflow_.clear();
+  numBurninValues_ = 0;
+}
+
+bool SVfitQuantityDiTau::compBinning_adaptive(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met, double xMinCore, double xMaxCore,
+                                              HistogramBinning& binning) const
+{
+  return false;
+}
+
+void SVfitQuantityDiTau::bookHistogram_adaptive(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met)
+{
+  if ( numBurninValues_ == 0 ) return;
+  // CV: the burnin stage samples only a small part of the tails of the posterior distribution,
+  //     so extend the range by a safety margin; values outside of the core range are still covered by coarse bins
+  const double margin = 1.1;
+  if ( !compBinning_adaptive(vis1P4, vis2P4, met, burninMin_/margin, burninMax_*margin, binning_) ) return;
+  SVfitQuantity::bookHistogram(binning_);
 }
 
 SVfitQuantityDiTauPt::SVfitQuantityDiTauPt(const std::string& label)
   : SVfitQuantityDiTau(label)
-{}
+{
+  histogramName_ = "ClassicSVfitIntegrand_" + label_ + "_histogramPt";
+}
 
-TH1* SVfitQuantityDiTauPt::createHistogram(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met) const
+void SVfitQuantityDiTauPt::compBinning(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met, HistogramBinning& binning) const
 {
-  return HistogramTools::makeHistogram_logBinWidth("ClassicSVfitIntegrand_" + label_ + "_histogramPt", 1., 1.e+3, 1.025);
+  HistogramTools::compBinning_logBinWidth(1., 1.e+3, 1.025, binning);
 }
 
 SVfitQuantityDiTauEta::SVfitQuantityDiTauEta(const std::string& label)
   : SVfitQuantityDiTau(label)
-{}
+{
+  histogramName_ = "ClassicSVfitIntegrand_" + label_ + "_histogramEta";
+}
 
-TH1* SVfitQuantityDiTauEta::createHistogram(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met) const
+void SVfitQuantityDiTauEta::compBinning(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met, HistogramBinning& binning) const
 {
-  return HistogramTools::makeHistogram_linBinWidth("ClassicSVfitIntegrand_" + label_ + "_histogramEta", 198, -9.9, +9.9);
+  HistogramTools::compBinning_linBinWidth(198, -9.9, +9.9, binning);
 }
 
 SVfitQuantityDiTauPhi::SVfitQuantityDiTauPhi(const std::string& label)
   : SVfitQuantityDiTau(label)
-{}
+{
+  histogramName_ = "ClassicSVfitIntegrand_" + label_ + "_histogramPhi";
+}
 
-TH1* SVfitQuantityDiTauPhi::createHistogram(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met) const
+void SVfitQuantityDiTauPhi::compBinning(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met, HistogramBinning& binning) const
 {
-  return HistogramTools::makeHistogram_linBinWidth("ClassicSVfitIntegrand_" + label_ + "_histogramPhi", 180, -TMath::Pi(), +TMath::Pi());
+  HistogramTools::compBinning_linBinWidth(180, -M_PI, +M_PI, binning);
 }
 
 SVfitQuantityDiTauMass::SVfitQuantityDiTauMass(const std::string& label)
   : SVfitQuantityDiTau(label)
-{}
+{
+  histogramName_ = "ClassicSVfitIntegrand_" + label_ + "_histogramMass";
+  numBins_fixed_ = HistogramTools::getNumBins_logBinWidth(minMass_logBinWidth, maxMass_logBinWidth, 1.025);
+  binning_.binEdges_.reserve(numBins_fixed_ + 1);
+}
+
+void SVfitQuantityDiTauMass::compBinning(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met, HistogramBinning& binning) const
+{
+  double visMass = compMass(vis1P4 + vis2P4);
+  double minMass = std::max(minMass_logBinWidth, visMass/1.0125);
+  double maxMass = std::max(maxMass_logBinWidth, 1.e+1*minMass);
+  HistogramTools::compBinning_logBinWidth(minMass, maxMass, 1.025, binning);
+}
 
-TH1* SVfitQuantityDiTauMass::createHistogram(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met) const
+bool SVfitQuantityDiTauMass::compBinning_adaptive(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met, double xMinCore, double xMaxCore,
+                                                  HistogramBinning& binning) const
 {
-  double visMass = (vis1P4 + vis2P4).mass();
-  double minMass = visMass/1.0125;
-  double maxMass = TMath::Max(1.e+4, 1.e+1*minMass);
-  return HistogramTools::makeHistogram_logBinWidth("ClassicSVfitIntegrand_" + label_ + "_histogramMass", minMass, maxMass, 1.025);
+  double visMass = compMass(vis1P4 + vis2P4);
+  double minMass = std::max(minMass_logBinWidth, visMass/1.0125);
+  double maxMass = std::max(maxMass_logBinWidth, 1.e+1*minMass);
+  HistogramTools::compBinning_adaptiveLogBinWidth(minMass, maxMass, xMinCore, xMaxCore, 100, 1.1, binning);
+  return true;
 }
 
 SVfitQuantityDiTauTransverseMass::SVfitQuantityDiTauTransverseMass(const std::string& label)
   : SVfitQuantityDiTau(label)
-{}
+{
+  histogramName_ = "ClassicSVfitIntegrand_" + label_ + "_histogramTransverseMass";
+  numBins_fixed_ = HistogramTools::getNumBins_logBinWidth(minMass_logBinWidth, maxMass_logBinWidth, 1.025);
+  binning_.binEdges_.reserve(numBins_fixed_ + 1);
+}
 
-TH1* SVfitQuantityDiTauTransverseMass::createHistogram(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met) const
+void SVfitQuantityDiTauTransverseMass::compBinning(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met, HistogramBinning& binning) const
 {
   classic_svFit::LorentzVector measuredDiTauSystem = vis1P4 + vis2P4;
   double visTransverseMass2 = square(vis1P4.Et() + vis2P4.Et()) - (square(measuredDiTauSystem.px()) + square(measuredDiTauSystem.py()));
-  double visTransverseMass = TMath::Sqrt(TMath::Max(1., visTransverseMass2));
-  double minTransverseMass = visTransverseMass/1.0125;
-  double maxTransverseMass = TMath::Max(1.e+4, 1.e+1*minTransverseMass);
-  return HistogramTools::makeHistogram_logBinWidth("ClassicSVfitIntegrand_" + label_ + "_histogramTransverseMass", minTransverseMass, maxTransverseMass, 1.025);
+  double visTransverseMass = std::sqrt(std::max(1., visTransverseMass2));
+  double minTransverseMass = std::max(minMass_logBinWidth, visTransverseMass/1.0125);
+  double maxTransverseMass = std::max(maxMass_logBinWidth, 1.e+1*minTransverseMass);
+  HistogramTools::compBinning_logBinWidth(minTransverseMass, maxTransverseMass, 1.025, binning);
+}
+
+bool SVfitQuantityDiTauTransverseMass::compBinning_adaptive(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met, double xMinCore, double xMaxCore,
+                                                            HistogramBinning& binning) const
+{
+  classic_svFit::LorentzVector measuredDiTauSystem = vis1P4 + vis2P4;
+  double visTransverseMass2 = square(vis1P4.Et() + vis2P4.Et()) - (square(measuredDiTauSystem.px()) + square(measuredDiTauSystem.py()));
+  double visTransverseMass = std::sqrt(std::max(1., visTransverseMass2));
+  double minTransverseMass = std::max(minMass_logBinWidth, visTransverseMass/1.0125);
+  double maxTransverseMass = std::max(maxMass_logBinWidth, 1.e+1*minTransverseMass);
+  HistogramTools::compBinning_adaptiveLogBinWidth(minTransverseMass, maxTransverseMass, xMinCore, xMaxCore, 100, 1.1, binning);
+  return true;
+}
+
+SVfitQuantityDiTauUserDefined::SVfitQuantityDiTauUserDefined(const std::string& label, const std::string& name, const ObservableFunction& function,
+                                                             int numBins, double xMin, double xMax)
+  : SVfitQuantityDiTau(label)
+  , name_(name)
+  , function_(function)
+  , numBins_(numBins)
+  , xMin_(xMin)
+  , xMax_(xMax)
+{
+  histogramName_ = "ClassicSVfitIntegrand_" + label_ + "_histogram" + name_;
+}
+
+void SVfitQuantityDiTauUserDefined::compBinning(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met, HistogramBinning& binning) const
+{
+  HistogramTools::compBinning_linBinWidth(numBins_, xMin_, xMax_, binning);
+}
+
+double SVfitQuantityDiTauUserDefined::compValue(const LorentzVector& tau1P4, const LorentzVector& tau2P4, const Vector& met) const
+{
+  return function_(tau1P4, tau2P4, met);
+}
+
+void SVfitQuantityDiTauUserDefined::hashConfiguration(SVfitHash& hash) const
+{
+  hash.add(name_);
+  hash.add(numBins_);
+  hash.add(xMin_);
+  hash.add(xMax_);
 }
     
+HistogramAdapterDiTauBurnin::HistogramAdapterDiTauBurnin(const HistogramAdapterDiTau* adapter)
+  : adapter_(adapter)
+{}
+
+double HistogramAdapterDiTauBurnin::DoEval(const double* x) const
+{
+  adapter_->fillBurnin(adapter_->tau1P4_, adapter_->tau2P4_);
+  return 0.;
+}
+
+namespace
+{
+  double compTransverseMass(const LorentzVector& tau1P4, const LorentzVector& tau2P4, const LorentzVector& ditauP4)
+  {
+    double transverseMass2 = square(tau1P4.Et() + tau2P4.Et()) - (square(ditauP4.px()) + square(ditauP4.py()));
+    return std::sqrt(std::max(1., transverseMass2));
+  }
+}
+
 HistogramAdapterDiTau::HistogramAdapterDiTau(const std::string& label)
   : HistogramAdapter(label)
+  , observables_(kAll)
+  , adaptiveBinning_(false)
+  , isAdaptiveBookingPending_(false)
+  , burninCallBackFunction_(this)
   , quantity_pt_(nullptr)
   , quantity_eta_(nullptr)
   , quantity_phi_(nullptr)
@@ -454,6 +915,88 @@ HistogramAdapterDiTau::~HistogramAdapterDiTau()
   delete adapter_tau2_;
 }
 
+void HistogramAdapterDiTau::setObservables(unsigned observables)
+{
+  observables_ = observables;
+  // CV: free memory of histograms for observables that are not selected anymore
+  if ( !(observables_ & kPt)             ) quantity_pt_->resetHistogram();
+  if ( !(observables_ & kEta)            ) quantity_eta_->resetHistogram();
+  if ( !(observables_ & kPhi)            ) quantity_phi_->resetHistogram();
+  if ( !(observables_ & kMass)           ) quantity_mass_->resetHistogram();
+  if ( !(observables_ & kTransverseMass) ) quantity_transverseMass_->resetHistogram();
+  if ( !(observables_ & kTau1)           ) adapter_tau1_->resetHistograms();
+  if ( !(observables_ & kTau2)           ) adapter_tau2_->resetHistograms();
+}
+
+void HistogramAdapterDiTau::setExtractionMode(int extractionMode)
+{
+  HistogramAdapter::setExtractionMode(extractionMode);
+  adapter_tau1_->setExtractionMode(extractionMode);
+  adapter_tau2_->setExtractionMode(extractionMode);
+}
+
+void HistogramAdapterDiTau::getBookedQuantities(std::vector<SVfitQuantity*>& quantities) const
+{
+  HistogramAdapter::getBookedQuantities(quantities);
+  adapter_tau1_->getBookedQuantities(quantities);
+  adapter_tau2_->getBookedQuantities(quantities);
+}
+
+void HistogramAdapterDiTau::getHistogramProperties(std::vector<HistogramProperties>& properties) const
+{
+  HistogramAdapter::getHistogramProperties(properties);
+  adapter_tau1_->getHistogramProperties(properties);
+  adapter_tau2_->getHistogramProperties(properties);
+}
+
+size_t HistogramAdapterDiTau::setHistogramProperties(const std::vector<HistogramProperties>& properties, size_t idx)
+{
+  idx = HistogramAdapter::setHistogramProperties(properties, idx);
+  idx = adapter_tau1_->setHistogramProperties(properties, idx);
+  idx = adapter_tau2_->setHistogramProperties(properties, idx);
+  return idx;
+}
+
+void HistogramAdapterDiTau::hashConfiguration(SVfitHash& hash) const
+{
+  HistogramAdapter::hashConfiguration(hash);
+  hash.add(observables_);
+  hash.add(adaptiveBinning_);
+  for ( std::vector<SVfitQuantityDiTauUserDefined*>::const_iterator quantity = quantities_userDefined_.begin();
+        quantity != quantities_userDefined_.end(); ++quantity ) {
+    (*quantity)->hashConfiguration(hash);
+  }
+}
+
+void HistogramAdapterDiTau::setAdaptiveBinning(bool adaptiveBinning)
+{
+  adaptiveBinning_ = adaptiveBinning;
+}
+
+const ROOT::Math::Functor& HistogramAdapterDiTau::getBurninCallBackFunction() const
+{
+  return burninCallBackFunction_;
+}
+
+bool HistogramAdapterDiTau::needsBurnin() const
+{
+  return ( adaptiveBinning_ && (observables_ & (kMass | kTransverseMass)) );
+}
+
+unsigned HistogramAdapterDiTau::getObservables() const
+{
+  return observables_;
+}
+
+unsigned HistogramAdapterDiTau::addObservable(const std::string& name, const ObservableFunction& function, int numBins, double xMin, double xMax)
+{
+  SVfitQuantityDiTauUserDefined* quantity = new SVfitQuantityDiTauUserDefined(label_, name, function, numBins, xMin, xMax);
+  quantity->setExtractionMode(extractionMode_);
+  quantities_.push_back(quantity);
+  quantities_userDefined_.push_back(quantity);
+  return quantities_userDefined_.size() - 1;
+}
+
 void HistogramAdapterDiTau::setMeasurement(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met)
 {
   vis1P4_ = vis1P4;
@@ -467,33 +1010,59 @@ void HistogramAdapterDiTau::setTau1And2P4(const LorentzVector& tau1P4, const Lor
 {
   tau1P4_ = tau1P4;
   tau2P4_ = tau2P4;
-  ditauP4_ = tau1P4_ + tau2P4_;
   adapter_tau1_->setTauP4(tau1P4);
   adapter_tau2_->setTauP4(tau2P4);
 }
 
 void HistogramAdapterDiTau::bookHistograms(const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met)
 {
-  quantity_pt_->bookHistogram(vis1P4, vis2P4, met);
-  quantity_eta_->bookHistogram(vis1P4, vis2P4, met);
-  quantity_phi_->bookHistogram(vis1P4, vis2P4, met);
-  quantity_mass_->bookHistogram(vis1P4, vis2P4, met);
-  quantity_transverseMass_->bookHistogram(vis1P4, vis2P4, met);
-  adapter_tau1_->bookHistograms(vis1P4);
-  adapter_tau2_->bookHistograms(vis2P4);
+  if ( observables_ & kPt             ) quantity_pt_->bookHistogram(vis1P4, vis2P4, met);
+  if ( observables_ & kEta            ) quantity_eta_->bookHistogram(vis1P4, vis2P4, met);
+  if ( observables_ & kPhi            ) quantity_phi_->bookHistogram(vis1P4, vis2P4, met);
+  if ( observables_ & kMass           ) quantity_mass_->bookHistogram(vis1P4, vis2P4, met);
+  if ( observables_ & kTransverseMass ) quantity_transverseMass_->bookHistogram(vis1P4, vis2P4, met);
+  for ( std::vector<SVfitQuantityDiTauUserDefined*>::iterator quantity = quantities_userDefined_.begin();
+        quantity != quantities_userDefined_.end(); ++quantity ) {
+    (*quantity)->bookHistogram(vis1P4, vis2P4, met);
+  }
+  if ( observables_ & kTau1 ) adapter_tau1_->bookHistograms(vis1P4);
+  if ( observables_ & kTau2 ) adapter_tau2_->bookHistograms(vis2P4);
+  isAdaptiveBookingPending_ = adaptiveBinning_;
 }
 
 void HistogramAdapterDiTau::fillHistograms(const LorentzVector& tau1P4, const LorentzVector& tau2P4, const LorentzVector& ditauP4,
 					   const LorentzVector& vis1P4, const LorentzVector& vis2P4, const Vector& met) const
 {
-  quantity_pt_->fillHistogram(ditauP4.pt());
-  quantity_eta_->fillHistogram(ditauP4.eta());
-  quantity_phi_->fillHistogram(ditauP4.phi());
-  quantity_mass_->fillHistogram(ditauP4.mass());
-  double transverseMass2 = square(tau1P4.Et() + tau2P4.Et()) - (square(ditauP4.px()) + square(ditauP4.py()));
-  quantity_transverseMass_->fillHistogram(TMath::Sqrt(TMath::Max(1., transverseMass2)));
-  adapter_tau1_->fillHistograms(tau1P4, vis1P4);
-  adapter_tau2_->fillHistograms(tau2P4, vis2P4);
+  if ( observables_ & kPt   ) quantity_pt_->fillHistogram(ditauP4.pt());
+  if ( observables_ & kEta  ) quantity_eta_->fillHistogram(ditauP4.eta());
+  if ( observables_ & kPhi  ) quantity_phi_->fillHistogram(ditauP4.phi());
+  if ( observables_ & kMass ) quantity_mass_->fillHistogram(compMass(ditauP4));
+  if ( observables_ & kTransverseMass ) quantity_transverseMass_->fillHistogram(compTransverseMass(tau1P4, tau2P4, ditauP4));
+  for ( std::vector<SVfitQuantityDiTauUserDefined*>::const_iterator quantity = quantities_userDefined_.begin();
+        quantity != quantities_userDefined_.end(); ++quantity ) {
+    (*quantity)->fillHistogram((*quantity)->compValue(tau1P4, tau2P4, met));
+  }
+  if ( observables_ & kTau1 ) adapter_tau1_->fillHistograms(tau1P4, vis1P4);
+  if ( observables_ & kTau2 ) adapter_tau2_->fillHistograms(tau2P4, vis2P4);
+}
+
+void HistogramAdapterDiTau::fill(const LorentzVector& tau1P4, const LorentzVector& tau2P4) const
+{
+  // CV: book histograms with adaptive binning when the first sample is taken after the burnin stage
+  if ( isAdaptiveBookingPending_ ) {
+    if ( observables_ & kMass           ) quantity_mass_->bookHistogram_adaptive(vis1P4_, vis2P4_, met_);
+    if ( observables_ & kTransverseMass ) quantity_transverseMass_->bookHistogram_adaptive(vis1P4_, vis2P4_, met_);
+    isAdaptiveBookingPending_ = false;
+  }
+  fillHistograms(tau1P4, tau2P4, tau1P4 + tau2P4, vis1P4_, vis2P4_, met_);
+}
+
+void HistogramAdapterDiTau::fillBurnin(const LorentzVector& tau1P4, const LorentzVector& tau2P4) const
+{
+  if ( !isAdaptiveBookingPending_ ) return;
+  LorentzVector ditauP4 = tau1P4 + tau2P4;
+  if ( observables_ & kMass           ) quantity_mass_->fillBurnin(compMass(ditauP4));
+  if ( observables_ & kTransverseMass ) quantity_transverseMass_->fillBurnin(compTransverseMass(tau1P4, tau2P4, ditauP4));
 }
 
 HistogramAdapterTau* HistogramAdapterDiTau::tau1() const 
@@ -551,6 +1120,24 @@ double HistogramAdapterDiTau::getPhiLmax() const
   return extractLmax(quantity_phi_);
 }
 
+double HistogramAdapterDiTau::getObservable(unsigned idx) const
+{
+  assert(idx < quantities_userDefined_.size());
+  return extractValue(quantities_userDefined_[idx]);
+}
+
+double HistogramAdapterDiTau::getObservableErr(unsigned idx) const
+{
+  assert(idx < quantities_userDefined_.size());
+  return extractUncertainty(quantities_userDefined_[idx]);
+}
+
+double HistogramAdapterDiTau::getObservableLmax(unsigned idx) const
+{
+  assert(idx < quantities_userDefined_.size());
+  return extractLmax(quantities_userDefined_[idx]);
+}
+
 double HistogramAdapterDiTau::getMass() const
 {
   return extractValue(quantity_mass_);
@@ -583,14 +1170,12 @@ double HistogramAdapterDiTau::getTransverseMassLmax() const
 
 classic_svFit::LorentzVector HistogramAdapterDiTau::getP4() const
 {
-  TLorentzVector p4;
-  p4.SetPtEtaPhiM(this->getPt(), this->getEta(), this->getPhi(), this->getMass());
-  return classic_svFit::LorentzVector(p4.Px(), p4.Py(), p4.Pz(), p4.E());
+  return makeP4_PtEtaPhiM(this->getPt(), this->getEta(), this->getPhi(), this->getMass());
 }
 
 double HistogramAdapterDiTau::DoEval(const double* x) const
 {
-  fillHistograms(tau1P4_, tau2P4_, ditauP4_, vis1P4_, vis2P4_, met_);
+  fill(tau1P4_, tau2P4_);
   return 0.;
 }
 //-------------------------------------------------------------------------------------------------
@@ -0,0 +1,189 @@
+#include "TauAnalysis/ClassicSVfit/interface/svFitHistogramAdapter.h"
+
+#include "TauAnalysis/ClassicSVfit/interface/svFitLikelihoodArchive.h"
+
+#include <TH1.h>
+#include <TFile.h>
+#include <TObject.h>
+
+using namespace classic_svFit;
+
+TH1* HistogramTools::compHistogramDensity(TH1 const* histogram)
+{
+  TH1* histogram_density = static_cast<TH1*>(histogram->Clone((std::string(histogram->GetName()) + "_density").c_str()));
+  histogram_density->Scale(1.0, "width");
+  return histogram_density;
+}
+
+void HistogramTools::extractHistogramProperties(TH1 const* histogram, HistogramProperties& properties)
+{
+  std::vector<double> workspace;
+  extractHistogramProperties(histogram, properties, workspace);
+}
+
+void HistogramTools::extractHistogramProperties(TH1 const* histogram, HistogramProperties& properties, std::vector<double>& workspace)
+{
+  SVfitHistogram histogram_copy;
+  copyHistogram(histogram, histogram_copy);
+  extractHistogramProperties(histogram_copy, properties, workspace);
+}
+
+void HistogramTools::extractHistogramProperties(
+    TH1 const* histogram,
+    double& xMaximum,
+    double& xMaximum_interpol,
+    double& xMean,
+    double& xQuantile016,
+    double& xQuantile050,
+    double& xQuantile084
+)
+{
+  HistogramProperties properties;
+  HistogramTools::extractHistogramProperties(histogram, properties);
+  xMaximum          = properties.xMaximum_;
+  xMaximum_interpol = properties.xMaximum_interpol_;
+  xMean             = properties.xMean_;
+  xQuantile016      = properties.xQuantile016_;
+  xQuantile050      = properties.xQuantile050_;
+  xQuantile084      = properties.xQuantile084_;
+}
+
+double HistogramTools::extractValue(TH1 const* histogram)
+{
+  HistogramProperties properties;
+  HistogramTools::extractHistogramProperties(histogram, properties);
+  return properties.xMaximum_;
+}
+
+double HistogramTools::extractUncertainty(TH1 const* histogram)
+{
+  HistogramProperties properties;
+  HistogramTools::extractHistogramProperties(histogram, properties);
+  return compUncertainty(properties);
+}
+
+double HistogramTools::extractLmax(TH1 const* histogram)
+{
+  HistogramProperties properties;
+  HistogramTools::extractHistogramProperties(histogram, properties);
+  return properties.Lmax_;
+}
+
+TH1* HistogramTools::makeHistogram_linBinWidth(const std::string& histogramName, int numBins, double xMin, double xMax)
+{
+  HistogramBinning binning;
+  compBinning_linBinWidth(numBins, xMin, xMax, binning);
+  return makeHistogram(histogramName, binning);
+}
+
+TH1* HistogramTools::makeHistogram_logBinWidth(const std::string& histogramName, double xMin, double xMax, double logBinWidth)
+{
+  HistogramBinning binning;
+  compBinning_logBinWidth(xMin, xMax, logBinWidth, binning);
+  return makeHistogram(histogramName, binning);
+}
+
+TH1* HistogramTools::makeHistogram_adaptiveLogBinWidth(const std::string& histogramName, double xMin, double xMax,
+                                                       double xMinCore, double xMaxCore, int numBinsCore, double logBinWidthTails)
+{
+  HistogramBinning binning;
+  compBinning_adaptiveLogBinWidth(xMin, xMax, xMinCore, xMaxCore, numBinsCore, logBinWidthTails, binning);
+  return makeHistogram(histogramName, binning);
+}
+
+TH1* HistogramTools::makeHistogram(const std::string& histogramName, const HistogramBinning& binning)
+{
+  TH1* histogram = nullptr;
+  if ( binning.binEdges_.empty() ) {
+    histogram = new TH1D(histogramName.data(), histogramName.data(), binning.numBins_, binning.xMin_, binning.xMax_);
+  } else {
+    histogram = new TH1D(histogramName.data(), histogramName.data(), binning.numBins_, binning.binEdges_.data());
+  }
+  return histogram;
+}
+
+TH1* HistogramTools::makeHistogram(const std::string& histogramName, const SVfitHistogram& histogram)
+{
+  TH1* histogram_root = makeHistogram(histogramName, histogram.getBinning());
+  for ( int idxBin = 0; idxBin <= (histogram.getNumBins() + 1); ++idxBin ) {
+    histogram_root->SetBinContent(idxBin, histogram.getBinContent(idxBin));
+  }
+  double stats[4];
+  histogram.getStats(stats);
+  histogram_root->PutStats(stats);
+  histogram_root->SetEntries(histogram.getEntries());
+  return histogram_root;
+}
+
+void HistogramTools::copyHistogram(TH1 const* histogram, SVfitHistogram& histogram_copy)
+{
+  const TAxis* xAxis = histogram->GetXaxis();
+  HistogramBinning binning;
+  binning.numBins_ = xAxis->GetNbins();
+  binning.xMin_ = xAxis->GetXmin();
+  binning.xMax_ = xAxis->GetXmax();
+  const TArrayD* binEdges = xAxis->GetXbins();
+  if ( binEdges && binEdges->GetSize() > 0 ) {
+    binning.binEdges_.assign(binEdges->GetArray(), binEdges->GetArray() + binEdges->GetSize());
+  }
+  histogram_copy.setBinning(binning);
+  for ( int idxBin = 0; idxBin <= (binning.numBins_ + 1); ++idxBin ) {
+    histogram_copy.setBinContent(idxBin, histogram->GetBinContent(idxBin));
+  }
+  double stats[4];
+  histogram->GetStats(stats);
+  histogram_copy.putStats(stats);
+  histogram_copy.setEntries(histogram->GetEntries());
+}
+
+void HistogramTools::setBinning(TH1* histogram, const HistogramBinning& binning)
+{
+  if ( binning.binEdges_.empty() ) {
+    histogram->SetBins(binning.numBins_, binning.xMin_, binning.xMax_);
+  } else {
+    histogram->SetBins(binning.numBins_, binning.binEdges_.data());
+  }
+  histogram->Reset();
+}
+
+void SVfitQuantity::writeHistogram() const
+{
+  if ( histogram_ != nullptr ) {
+    TH1* histogram = HistogramTools::makeHistogram(histogramName_ + uniqueName_, *histogram_);
+    // CV: the histograms of different instances have identical names,
+    //     so they must not be registered in the current ROOT directory
+    histogram->SetDirectory(nullptr);
+    histogram->Write(histogramName_.c_str(), TObject::kWriteDelete);
+    delete histogram;
+  }
+}
+
+void SVfitQuantity::writeHistogram(SVfitLikelihoodArchive& archive, unsigned long long eventId) const
+{
+  if ( histogram_ != nullptr ) {
+    archive.addHistogram(eventId, histogramName_, *histogram_);
+  }
+}
+
+void HistogramAdapter::writeHistograms(const std::string& likelihoodFileName) const
+{
+  TFile* likelihoodFile = new TFile(likelihoodFileName.data(), "RECREATE");
+  likelihoodFile->cd();
+
+  for (std::vector<SVfitQuantity*>::iterator quantity = quantities_.begin();
+       quantity != quantities_.end(); ++quantity ) {
+    (*quantity)->writeHistogram();
+  }
+
+  likelihoodFile->Write();
+  likelihoodFile->Close();
+  delete likelihoodFile;
+}
+
+void HistogramAdapter::writeHistograms(SVfitLikelihoodArchive& archive, unsigned long long eventId) const
+{
+  for ( std::vector<SVfitQuantity*>::const_iterator quantity = quantities_.begin();
+        quantity != quantities_.end(); ++quantity ) {
+    (*quantity)->writeHistogram(archive, eventId);
+  }
+}
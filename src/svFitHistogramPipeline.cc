@@ -0,0 +1,94 @@
+#include "TauAnalysis/ClassicSVfit/interface/svFitHistogramPipeline.h"
+
+#include <assert.h>
+
+using namespace classic_svFit;
+
+HistogramPipelineDiTau::HistogramPipelineDiTau(size_t capacity)
+  : buffer_(capacity)
+  , histogramAdapter_(nullptr)
+  , isConsumerWaiting_(false)
+  , isProducerWaiting_(false)
+  , numEventsPushed_(0)
+  , numEventsProcessed_(0)
+{}
+
+HistogramPipelineDiTau::~HistogramPipelineDiTau()
+{
+  if ( consumer_.joinable() ) {
+    record_.type_ = kTerminate;
+    pushRecord(record_);
+    consumer_.join();
+  }
+}
+
+void HistogramPipelineDiTau::start(const HistogramAdapterDiTau* histogramAdapter)
+{
+  // CV: the consumer thread does not access the histogram adapter between events,
+  //     and the new value becomes visible to it together with the first record pushed for this event
+  histogramAdapter_ = histogramAdapter;
+  if ( !consumer_.joinable() ) consumer_ = std::thread(&HistogramPipelineDiTau::consume, this);
+}
+
+void HistogramPipelineDiTau::stop()
+{
+  if ( !consumer_.joinable() ) return;
+  record_.type_ = kEndOfEvent;
+  ++numEventsPushed_;
+  pushRecord(record_);
+  std::unique_lock<std::mutex> lock(mutex_);
+  producerCondition_.wait(lock, [this]() { return numEventsProcessed_ == numEventsPushed_; });
+}
+
+void HistogramPipelineDiTau::waitForSpace(const Record& record)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  isProducerWaiting_.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  while ( !buffer_.push(record) ) producerCondition_.wait(lock);
+  isProducerWaiting_.store(false, std::memory_order_relaxed);
+}
+
+void HistogramPipelineDiTau::waitForRecord(Record& record)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  isConsumerWaiting_.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  while ( !buffer_.pop(record) ) consumerCondition_.wait(lock);
+  isConsumerWaiting_.store(false, std::memory_order_relaxed);
+}
+
+void HistogramPipelineDiTau::wakeConsumer()
+{
+  // CV: acquiring the mutex ensures that the consumer thread either has not checked the buffer yet or is waiting
+  std::lock_guard<std::mutex> lock(mutex_);
+  consumerCondition_.notify_one();
+}
+
+void HistogramPipelineDiTau::wakeProducer()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  producerCondition_.notify_one();
+}
+
+void HistogramPipelineDiTau::consume()
+{
+  Record record;
+  while ( true ) {
+    if ( !buffer_.pop(record) ) waitForRecord(record);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if ( isProducerWaiting_.load(std::memory_order_relaxed) ) wakeProducer();
+    if ( record.type_ == kSample ) {
+      histogramAdapter_->fill(record.tau1P4_, record.tau2P4_);
+    } else if ( record.type_ == kBurnin ) {
+      histogramAdapter_->fillBurnin(record.tau1P4_, record.tau2P4_);
+    } else if ( record.type_ == kEndOfEvent ) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++numEventsProcessed_;
+      producerCondition_.notify_one();
+    } else {
+      assert(record.type_ == kTerminate);
+      break;
+    }
+  }
+}
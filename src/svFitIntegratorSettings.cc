@@ -0,0 +1,175 @@
+#include "TauAnalysis/ClassicSVfit/interface/svFitIntegratorSettings.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <assert.h>
+
+using namespace classic_svFit;
+
+namespace
+{
+  const int presetsFileVersion = 1;
+}
+
+SVfitIntegratorSettings::SVfitIntegratorSettings()
+  : maxObjFunctionCalls_(100000)
+  , fractionBurnin_(0.10)
+  , fractionSimAnnealingPhase1_(0.20)
+  , fractionSimAnnealingPhase2_(0.60)
+  , T0_(15.)
+  , fractionTemperatureDecay_(0.10)
+  , numBatches_(100)
+  , epsilon0_(1.e-2)
+  , nu_(0.71)
+{}
+
+bool SVfitIntegratorSettings::operator==(const SVfitIntegratorSettings& settings) const
+{
+  return ( maxObjFunctionCalls_        == settings.maxObjFunctionCalls_        &&
+           fractionBurnin_             == settings.fractionBurnin_             &&
+           fractionSimAnnealingPhase1_ == settings.fractionSimAnnealingPhase1_ &&
+           fractionSimAnnealingPhase2_ == settings.fractionSimAnnealingPhase2_ &&
+           T0_                         == settings.T0_                         &&
+           fractionTemperatureDecay_   == settings.fractionTemperatureDecay_   &&
+           numBatches_                 == settings.numBatches_                 &&
+           epsilon0_                   == settings.epsilon0_                   &&
+           nu_                         == settings.nu_                         );
+}
+
+void SVfitIntegratorSettings::hash(SVfitHash& hash) const
+{
+  hash.add(maxObjFunctionCalls_);
+  hash.add(fractionBurnin_);
+  hash.add(fractionSimAnnealingPhase1_);
+  hash.add(fractionSimAnnealingPhase2_);
+  hash.add(T0_);
+  hash.add(fractionTemperatureDecay_);
+  hash.add(numBatches_);
+  hash.add(epsilon0_);
+  hash.add(nu_);
+}
+
+SVfitPrecisionSettings::SVfitPrecisionSettings()
+  : targetMassPrecision_(0.)
+  , minObjFunctionCalls_(0)
+  , maxObjFunctionCalls_(1000000)
+{}
+
+SVfitPrecisionSettings SVfitPrecisionSettings::getPreset(const std::string& presetName)
+{
+  SVfitPrecisionSettings settings;
+  if ( presetName == "fast" ) {
+    settings.targetMassPrecision_ = 2.e-2;
+    settings.minObjFunctionCalls_ = 10000;
+    settings.maxObjFunctionCalls_ = 100000;
+  } else if ( presetName == "standard" ) {
+    settings.targetMassPrecision_ = 1.e-2;
+    settings.minObjFunctionCalls_ = 20000;
+    settings.maxObjFunctionCalls_ = 300000;
+  } else if ( presetName == "reference" ) {
+    settings.targetMassPrecision_ = 2.e-3;
+    settings.minObjFunctionCalls_ = 100000;
+    settings.maxObjFunctionCalls_ = 3000000;
+  } else {
+    std::cerr << "<SVfitPrecisionSettings::getPreset>:"
+              << "Invalid preset = " << presetName << ","
+              << " expected to be either \"fast\", \"standard\" or \"reference\" --> ABORTING !!\n";
+    assert(0);
+  }
+  return settings;
+}
+
+void SVfitPrecisionSettings::hash(SVfitHash& hash) const
+{
+  hash.add(targetMassPrecision_);
+  hash.add(minObjFunctionCalls_);
+  hash.add(maxObjFunctionCalls_);
+}
+
+SVfitRefinementSettings::SVfitRefinementSettings()
+  : numObjFunctionCallsCoarse_(10000)
+  , massMin_(0.)
+  , massMax_(0.)
+  , numSigma_(1.)
+  , maxMassStatErr_(0.05)
+{}
+
+void SVfitRefinementSettings::hash(SVfitHash& hash) const
+{
+  hash.add(numObjFunctionCallsCoarse_);
+  hash.add(massMin_);
+  hash.add(massMax_);
+  hash.add(numSigma_);
+  hash.add(maxMassStatErr_);
+}
+
+SVfitIntegratorPresets::SVfitIntegratorPresets()
+{}
+
+SVfitIntegratorPresets::~SVfitIntegratorPresets()
+{}
+
+void SVfitIntegratorPresets::load(const std::string& fileName)
+{
+  std::ifstream file(fileName.data());
+  if ( !file ) {
+    std::cerr << "<SVfitIntegratorPresets::load>:"
+              << "Failed to open file = " << fileName << " --> ABORTING !!\n";
+    assert(0);
+  }
+  int version = -1;
+  std::string line;
+  while ( std::getline(file, line) ) {
+    if ( line.empty() || line[0] == '#' ) continue;
+    std::istringstream stream(line);
+    std::string key;
+    stream >> key;
+    if ( key == "version" ) {
+      stream >> version;
+      if ( version != presetsFileVersion ) {
+        std::cerr << "<SVfitIntegratorPresets::load>:"
+                  << "Unsupported version = " << version << " of file = " << fileName << " --> ABORTING !!\n";
+        assert(0);
+      }
+      continue;
+    }
+    SVfitIntegratorSettings settings;
+    stream >> settings.maxObjFunctionCalls_ >> settings.fractionBurnin_
+           >> settings.fractionSimAnnealingPhase1_ >> settings.fractionSimAnnealingPhase2_
+           >> settings.T0_ >> settings.fractionTemperatureDecay_ >> settings.numBatches_
+           >> settings.epsilon0_ >> settings.nu_;
+    if ( version != presetsFileVersion || stream.fail() ) {
+      std::cerr << "<SVfitIntegratorPresets::load>:"
+                << "Invalid line = '" << line << "' in file = " << fileName << " --> ABORTING !!\n";
+      assert(0);
+    }
+    presets_[key] = settings;
+  }
+}
+
+void SVfitIntegratorPresets::write(std::ostream& stream) const
+{
+  stream << "# channel maxObjFunctionCalls fractionBurnin fractionSimAnnealingPhase1 fractionSimAnnealingPhase2"
+         << " T0 fractionTemperatureDecay numBatches epsilon0 nu" << std::endl;
+  stream << "version " << presetsFileVersion << std::endl;
+  for ( std::map<std::string, SVfitIntegratorSettings>::const_iterator preset = presets_.begin();
+        preset != presets_.end(); ++preset ) {
+    const SVfitIntegratorSettings& settings = preset->second;
+    stream << preset->first << " " << settings.maxObjFunctionCalls_ << " " << settings.fractionBurnin_
+           << " " << settings.fractionSimAnnealingPhase1_ << " " << settings.fractionSimAnnealingPhase2_
+           << " " << settings.T0_ << " " << settings.fractionTemperatureDecay_ << " " << settings.numBatches_
+           << " " << settings.epsilon0_ << " " << settings.nu_ << std::endl;
+  }
+}
+
+void SVfitIntegratorPresets::set(const std::string& channelName, const SVfitIntegratorSettings& settings)
+{
+  presets_[channelName] = settings;
+}
+
+const SVfitIntegratorSettings* SVfitIntegratorPresets::find(const std::string& channelName) const
+{
+  std::map<std::string, SVfitIntegratorSettings>::const_iterator preset = presets_.find(channelName);
+  return ( preset != presets_.end() ) ? &preset->second : nullptr;
+}
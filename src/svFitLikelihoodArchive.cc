@@ -0,0 +1,92 @@
+#include "TauAnalysis/ClassicSVfit/interface/svFitLikelihoodArchive.h"
+
+#include "TauAnalysis/ClassicSVfit/interface/svFitHistogramAdapter.h"
+
+#include <TMath.h>
+
+#include <iostream>
+#include <limits>
+#include <assert.h>
+
+using namespace classic_svFit;
+
+SVfitLikelihoodArchive::SVfitLikelihoodArchive(const std::string& fileName, int compressionSettings)
+  : file_(nullptr)
+  , tree_(nullptr)
+  , eventId_(0)
+  , scale_(0.)
+{
+  file_ = new TFile(fileName.data(), "RECREATE", "SVfit likelihoods", compressionSettings);
+  if ( !file_ || file_->IsZombie() ) {
+    std::cerr << "<SVfitLikelihoodArchive>:"
+              << "Failed to open file = " << fileName << " --> ABORTING !!\n";
+    assert(0);
+  }
+  file_->cd();
+  tree_ = new TTree("likelihoods", "SVfit likelihoods");
+  tree_->Branch("eventId", &eventId_, "eventId/l");
+  tree_->Branch("quantity", &quantity_);
+  tree_->Branch("binEdges", &binEdges_);
+  tree_->Branch("binContents", &binContents_);
+  tree_->Branch("scale", &scale_, "scale/F");
+}
+
+SVfitLikelihoodArchive::~SVfitLikelihoodArchive()
+{
+  file_->cd();
+  tree_->Write();
+  file_->Close();
+  delete file_;
+}
+
+void SVfitLikelihoodArchive::addHistogram(unsigned long long eventId, const std::string& quantity, const SVfitHistogram& histogram)
+{
+  eventId_ = eventId;
+  quantity_ = quantity;
+  binEdges_.clear();
+  binContents_.clear();
+  scale_ = 0.;
+
+  int numBins = histogram.getNumBins();
+  int firstBin = numBins + 1;
+  int lastBin = 0;
+  double maxBinContent = 0.;
+  for ( int idxBin = 1; idxBin <= numBins; ++idxBin ) {
+    double binContent = histogram.getBinContent(idxBin);
+    if ( binContent > 0. ) {
+      if ( idxBin < firstBin ) firstBin = idxBin;
+      lastBin = idxBin;
+      if ( binContent > maxBinContent ) maxBinContent = binContent;
+    }
+  }
+
+  if ( maxBinContent > 0. ) {
+    const double maxQuantizedBinContent = std::numeric_limits<unsigned short>::max();
+    scale_ = maxBinContent/maxQuantizedBinContent;
+    for ( int idxBin = firstBin; idxBin <= lastBin; ++idxBin ) {
+      binEdges_.push_back(histogram.getBinLowEdge(idxBin));
+      binContents_.push_back(TMath::Nint(histogram.getBinContent(idxBin)/scale_));
+    }
+    binEdges_.push_back(histogram.getBinLowEdge(lastBin + 1));
+  }
+
+  tree_->Fill();
+}
+
+void SVfitLikelihoodArchive::addHistogram(unsigned long long eventId, const std::string& quantity, const TH1* histogram)
+{
+  SVfitHistogram histogram_copy;
+  HistogramTools::copyHistogram(histogram, histogram_copy);
+  addHistogram(eventId, quantity, histogram_copy);
+}
+
+TH1* SVfitLikelihoodArchive::makeHistogram(const std::string& histogramName,
+                                           const std::vector<float>& binEdges, const std::vector<unsigned short>& binContents, float scale)
+{
+  if ( binContents.empty() || binEdges.size() != (binContents.size() + 1) ) return nullptr;
+  TH1* histogram = new TH1D(histogramName.data(), histogramName.data(), binContents.size(), binEdges.data());
+  for ( size_t idxBin = 0; idxBin < binContents.size(); ++idxBin ) {
+    histogram->SetBinContent(idxBin + 1, binContents[idxBin]*scale);
+  }
+  return histogram;
+}
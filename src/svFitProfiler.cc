@@ -0,0 +1,107 @@
+#include "TauAnalysis/ClassicSVfit/interface/svFitProfiler.h"
+
+using namespace classic_svFit;
+
+SVfitProfile::SVfitProfile()
+{
+  reset();
+}
+
+void SVfitProfile::reset()
+{
+  for ( int iStage = 0; iStage < kNumStages; ++iStage ) {
+    stageTime_real_[iStage] = 0.;
+  }
+  for ( int iCounter = 0; iCounter < kNumCounters; ++iCounter ) {
+    counts_[iCounter] = 0;
+  }
+  numSeconds_cpu_ = 0.;
+  numSeconds_real_ = 0.;
+}
+
+void SVfitProfile::add(const SVfitProfile& profile)
+{
+  for ( int iStage = 0; iStage < kNumStages; ++iStage ) {
+    stageTime_real_[iStage] += profile.stageTime_real_[iStage];
+  }
+  for ( int iCounter = 0; iCounter < kNumCounters; ++iCounter ) {
+    counts_[iCounter] += profile.counts_[iCounter];
+  }
+  numSeconds_cpu_ += profile.numSeconds_cpu_;
+  numSeconds_real_ += profile.numSeconds_real_;
+}
+
+const char* SVfitProfile::getStageName(int stage)
+{
+  switch ( stage ) {
+    case kPrepareInputs:     return "prepareInputs";
+    case kStartPosition:     return "startPosition";
+    case kAnnealingPhase1:   return "annealingPhase1";
+    case kAnnealingPhase2:   return "annealingPhase2";
+    case kBurnin:            return "burnin";
+    case kSampling:          return "sampling";
+    case kHistogramFill:     return "histogramFill";
+    case kExtractStatistics: return "extractStatistics";
+    case kFileOutput:        return "fileOutput";
+  }
+  return "undefined";
+}
+
+const char* SVfitProfile::getCounterName(int counter)
+{
+  switch ( counter ) {
+    case kNumEvents:            return "numEvents";
+    case kIntegrandCalls:       return "integrandCalls";
+    case kZeroProbability:      return "zeroProbability";
+    case kMovesAccepted:        return "movesAccepted";
+    case kMovesRejected:        return "movesRejected";
+    case kStartPositionRetries: return "startPositionRetries";
+  }
+  return "undefined";
+}
+
+void SVfitProfile::writeJSON(std::ostream& stream) const
+{
+  stream << "{\n";
+  stream << "  \"numSeconds_cpu\": " << numSeconds_cpu_ << ",\n";
+  stream << "  \"numSeconds_real\": " << numSeconds_real_ << ",\n";
+  stream << "  \"stages\": {";
+  for ( int iStage = 0; iStage < kNumStages; ++iStage ) {
+    stream << ( iStage > 0 ? ",\n" : "\n" ) << "    \"" << getStageName(iStage) << "\": " << stageTime_real_[iStage];
+  }
+  stream << "\n  },\n";
+  stream << "  \"counters\": {";
+  for ( int iCounter = 0; iCounter < kNumCounters; ++iCounter ) {
+    stream << ( iCounter > 0 ? ",\n" : "\n" ) << "    \"" << getCounterName(iCounter) << "\": " << counts_[iCounter];
+  }
+  stream << "\n  }\n";
+  stream << "}\n";
+}
+
+SVfitProfiler::SVfitProfiler()
+  : isEnabled_(false)
+  , stage_(SVfitProfile::kNumStages)
+  , eventStart_cpu_(0)
+{}
+
+void SVfitProfiler::startEvent()
+{
+  event_.reset();
+  event_.counts_[SVfitProfile::kNumEvents] = 1;
+  stage_ = SVfitProfile::kNumStages;
+  eventStart_cpu_ = std::clock();
+  eventStart_real_ = Clock::now();
+  stageStart_ = eventStart_real_;
+}
+
+void SVfitProfiler::stopEvent()
+{
+  Clock::time_point now = Clock::now();
+  if ( isEnabled_ && stage_ != SVfitProfile::kNumStages ) {
+    event_.stageTime_real_[stage_] += std::chrono::duration<double>(now - stageStart_).count();
+  }
+  stage_ = SVfitProfile::kNumStages;
+  event_.numSeconds_cpu_ = double(std::clock() - eventStart_cpu_)/CLOCKS_PER_SEC;
+  event_.numSeconds_real_ = std::chrono::duration<double>(now - eventStart_real_).count();
+  process_.add(event_);
+}
@@ -0,0 +1,122 @@
+#include "TauAnalysis/ClassicSVfit/interface/svFitQuantileEstimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace classic_svFit;
+
+TDigest::TDigest()
+{
+  reset();
+}
+
+TDigest::~TDigest()
+{}
+
+void TDigest::reset()
+{
+  numCentroids_ = 0;
+  numBuffered_ = 0;
+  min_ = 0.;
+  max_ = 0.;
+  sum_ = 0.;
+  numEntries_ = 0;
+}
+
+void TDigest::add(double value)
+{
+  if ( numEntries_ == 0 || value < min_ ) min_ = value;
+  if ( numEntries_ == 0 || value > max_ ) max_ = value;
+  sum_ += value;
+  ++numEntries_;
+
+  Centroid& centroid = centroids_[numCentroids_ + numBuffered_];
+  centroid.mean_ = value;
+  centroid.weight_ = 1.;
+  ++numBuffered_;
+  if ( numBuffered_ == bufferSize_ ) merge();
+}
+
+double TDigest::compScale(double q) const
+{
+  return (compression_/(2.*M_PI))*std::asin(2.*q - 1.);
+}
+
+double TDigest::compScaleInverse(double k) const
+{
+  return 0.5*(std::sin(k*(2.*M_PI/compression_)) + 1.);
+}
+
+void TDigest::merge() const
+{
+  if ( numBuffered_ == 0 ) return;
+
+  int numPoints = numCentroids_ + numBuffered_;
+  std::sort(centroids_, centroids_ + numPoints);
+
+  double totalWeight = 0.;
+  for ( int idxPoint = 0; idxPoint < numPoints; ++idxPoint ) {
+    totalWeight += centroids_[idxPoint].weight_;
+  }
+
+//--- merge neighbouring points as long as the size of the merged centroid does not exceed the limit given by the scale function
+//   (Algorithm 1 in [1])
+  double q0 = 0.;
+  double qLimit = compScaleInverse(compScale(q0) + 1.);
+  int idxCentroid = 0;
+  for ( int idxPoint = 1; idxPoint < numPoints; ++idxPoint ) {
+    Centroid& current = centroids_[idxCentroid];
+    const Centroid& next = centroids_[idxPoint];
+    double q = q0 + (current.weight_ + next.weight_)/totalWeight;
+    if ( q <= qLimit ) {
+      current.mean_ += (next.mean_ - current.mean_)*next.weight_/(current.weight_ + next.weight_);
+      current.weight_ += next.weight_;
+    } else {
+      q0 += current.weight_/totalWeight;
+      qLimit = compScaleInverse(compScale(q0) + 1.);
+      ++idxCentroid;
+      centroids_[idxCentroid] = next;
+    }
+  }
+  numCentroids_ = idxCentroid + 1;
+  numBuffered_ = 0;
+}
+
+double TDigest::getQuantile(double probability) const
+{
+  if ( numEntries_ == 0 ) return 0.;
+  merge();
+  if ( numCentroids_ == 1 ) return centroids_[0].mean_;
+
+//--- interpolate linearly between centroid means,
+//    taking each centroid to be centered at the middle of its cumulative weight
+  double target = probability*numEntries_;
+  const Centroid& first = centroids_[0];
+  if ( target < 0.5*first.weight_ ) {
+    return min_ + (first.mean_ - min_)*target/(0.5*first.weight_);
+  }
+  double cumulativeWeight = 0.5*first.weight_;
+  for ( int idxCentroid = 1; idxCentroid < numCentroids_; ++idxCentroid ) {
+    const Centroid& left = centroids_[idxCentroid - 1];
+    const Centroid& right = centroids_[idxCentroid];
+    double dWeight = 0.5*(left.weight_ + right.weight_);
+    if ( target < (cumulativeWeight + dWeight) ) {
+      return left.mean_ + (right.mean_ - left.mean_)*(target - cumulativeWeight)/dWeight;
+    }
+    cumulativeWeight += dWeight;
+  }
+  const Centroid& last = centroids_[numCentroids_ - 1];
+  double dWeight = 0.5*last.weight_;
+  if ( target >= numEntries_ || dWeight <= 0. ) return max_;
+  return last.mean_ + (max_ - last.mean_)*(target - cumulativeWeight)/dWeight;
+}
+
+double TDigest::getMean() const
+{
+  return ( numEntries_ > 0 ) ? sum_/numEntries_ : 0.;
+}
+
+unsigned long TDigest::getNumEntries() const
+{
+  return numEntries_;
+}
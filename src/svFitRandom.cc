@@ -0,0 +1,121 @@
+#include "TauAnalysis/ClassicSVfit/interface/svFitRandom.h"
+
+#include <cmath>
+
+using namespace classic_svFit;
+
+SVfitRandom::SVfitRandom()
+#ifdef USE_TRANDOM3
+  : rnd_(4357)
+#else
+  : engine_(4357) // CV: default seed of TRandom3
+#endif
+{}
+
+void SVfitRandom::setSeed(unsigned seed)
+{
+#ifdef USE_TRANDOM3
+  rnd_.SetSeed(seed);
+#else
+  engine_.seed(seed);
+#endif
+}
+
+double SVfitRandom::gaus(double mean, double sigma)
+{
+#ifdef USE_TRANDOM3
+  return rnd_.Gaus(mean, sigma);
+#else
+  // CV: ratio-of-uniforms algorithm with quadratic bounds, as in TRandom::Gaus
+  //    (J. L. Leva, "A fast normal random number generator", ACM Trans. Math. Softw. 18 (1992) 449)
+  const double kC1 = 1.448242853;
+  const double kC2 = 3.307147487;
+  const double kC3 = 1.46754004;
+  const double kD1 = 1.036467755;
+  const double kD2 = 5.295844968;
+  const double kD3 = 3.631288474;
+  const double kHm = 0.483941449;
+  const double kZm = 0.107981933;
+  const double kHp = 4.132731354;
+  const double kZp = 18.52161694;
+  const double kPhln = 0.4515827053;
+  const double kHm1 = 0.516058551;
+  const double kHp1 = 3.132731354;
+  const double kHzm = 0.375959516;
+  const double kHzmp = 0.591923442;
+  const double kAs = 0.8853395638;
+  const double kBs = 0.2452635696;
+  const double kCs = 0.2770276848;
+  const double kB  = 0.5029324303;
+  const double kX0 = 0.4571828819;
+  const double kYm = 0.187308492;
+  const double kS  = 0.7270572718;
+  const double kT  = 0.03895759111;
+
+  double result = 0.;
+  double rn, x, y, z;
+  do {
+    y = rndm();
+    if ( y > kHm1 ) {
+      result = kHp*y - kHp1;
+      break;
+    } else if ( y < kZm ) {
+      rn = kZp*y - 1;
+      result = ( rn > 0 ) ? (1 + rn) : (-1 + rn);
+      break;
+    } else if ( y < kHm ) {
+      rn = rndm();
+      rn = rn - 1 + rn;
+      z = ( rn > 0 ) ? 2 - rn : -2 - rn;
+      if ( (kC1 - y)*(kC3 + std::fabs(z)) < kC2 ) {
+        result = z;
+        break;
+      } else {
+        x = rn*rn;
+        if ( (y + kD1)*(kD3 + x) < kD2 ) {
+          result = rn;
+          break;
+        } else if ( kHzmp - y < std::exp(-(z*z + kPhln)/2) ) {
+          result = z;
+          break;
+        } else if ( y + kHzm < std::exp(-(x + kPhln)/2) ) {
+          result = rn;
+          break;
+        }
+      }
+    }
+    while ( true ) {
+      x = rndm();
+      y = kYm*rndm();
+      z = kX0 - kS*x - y;
+      if ( z > 0 ) {
+        rn = 2 + y/x;
+      } else {
+        x = 1 - x;
+        y = kYm - y;
+        rn = -(2 + y/x);
+      }
+      if ( (y - kAs + x)*(kCs + x) + kBs < 0 ) {
+        result = rn;
+        break;
+      } else if ( y < x + kT ) {
+        if ( rn*rn < 4*(kB - std::log(x)) ) {
+          result = rn;
+          break;
+        }
+      }
+    }
+  } while ( false );
+  return mean + sigma*result;
+#endif
+}
+
+double SVfitRandom::breitWigner(double mean, double gamma)
+{
+#ifdef USE_TRANDOM3
+  return rnd_.BreitWigner(mean, gamma);
+#else
+  double rval = 2*rndm() - 1;
+  return mean + 0.5*gamma*std::tan(rval*(0.5*M_PI));
+#endif
+}
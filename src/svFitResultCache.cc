@@ -0,0 +1,237 @@
+#include "TauAnalysis/ClassicSVfit/interface/svFitResultCache.h"
+
+#include <iostream>
+#include <assert.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace classic_svFit;
+
+namespace
+{
+  // CV: the last character is the version of the file layout,
+  //     which needs to be incremented whenever the content of the slots changes
+  const char fileHeader[8] = { 'S', 'V', 'F', 'I', 'T', 'R', 'C', '3' };
+  const size_t headerSize = sizeof(fileHeader) + 2*sizeof(uint64_t);
+  const size_t numPropertiesPerQuantity = 7;
+  const size_t numValuesPerResult = 5; // probMax, integral, integralErr, acceptanceRate, massStatErr
+  const uint32_t flagIsValidSolution = 0x1;
+  const uint32_t flagIsRefined = 0x2;
+  const size_t slotSize = sizeof(uint64_t) + numValuesPerResult*sizeof(double) + 2*sizeof(uint32_t)
+                        + SVfitResultCache::maxNumQuantities*numPropertiesPerQuantity*sizeof(double);
+
+  void writeProperties(const HistogramProperties& properties, char* data)
+  {
+    double values[numPropertiesPerQuantity] = {
+      properties.xMaximum_, properties.xMaximum_interpol_, properties.xMean_,
+      properties.xQuantile016_, properties.xQuantile050_, properties.xQuantile084_, properties.Lmax_
+    };
+    memcpy(data, values, sizeof(values));
+  }
+
+  void readProperties(const char* data, HistogramProperties& properties)
+  {
+    double values[numPropertiesPerQuantity];
+    memcpy(values, data, sizeof(values));
+    properties.xMaximum_ = values[0];
+    properties.xMaximum_interpol_ = values[1];
+    properties.xMean_ = values[2];
+    properties.xQuantile016_ = values[3];
+    properties.xQuantile050_ = values[4];
+    properties.xQuantile084_ = values[5];
+    properties.Lmax_ = values[6];
+  }
+}
+
+SVfitCachedResult::SVfitCachedResult()
+  : probMax_(0.)
+  , isValidSolution_(false)
+  , integral_(0.)
+  , integralErr_(0.)
+  , acceptanceRate_(0.)
+  , massStatErr_(0.)
+  , isRefined_(false)
+{}
+
+SVfitResultCache::SVfitResultCache(unsigned long capacity, const std::string& fileName, unsigned long numFileSlots)
+  : capacity_(( capacity > 0 ) ? capacity : 1)
+  , fd_(-1)
+  , fileData_(nullptr)
+  , fileSize_(0)
+  , numFileSlots_(0)
+  , numHits_(0)
+  , numMisses_(0)
+{
+  if ( fileName == "" ) return;
+
+  fd_ = open(fileName.data(), O_RDWR | O_CREAT, 0644);
+  struct stat fileStat;
+  if ( fd_ < 0 || fstat(fd_, &fileStat) != 0 ) {
+    std::cerr << "<SVfitResultCache>:"
+              << "Failed to open file = " << fileName << " --> ABORTING !!\n";
+    assert(0);
+  }
+  if ( fileStat.st_size == 0 ) {
+//--- create new file; the slots are allocated lazily by the file system
+    assert(numFileSlots > 0);
+    numFileSlots_ = numFileSlots;
+    fileSize_ = headerSize + numFileSlots_*slotSize;
+    if ( ftruncate(fd_, fileSize_) != 0 ) {
+      std::cerr << "<SVfitResultCache>:"
+                << "Failed to allocate " << fileSize_ << " bytes for file = " << fileName << " --> ABORTING !!\n";
+      assert(0);
+    }
+  } else {
+//--- reuse existing file, keeping its number of slots
+    char header[headerSize] = {};
+    uint64_t header_numSlots = 0;
+    uint64_t header_slotSize = 0;
+    if ( pread(fd_, header, headerSize, 0) == (ssize_t)headerSize ) {
+      memcpy(&header_numSlots, header + sizeof(fileHeader), sizeof(uint64_t));
+      memcpy(&header_slotSize, header + sizeof(fileHeader) + sizeof(uint64_t), sizeof(uint64_t));
+    }
+    if ( memcmp(header, fileHeader, sizeof(fileHeader) - 1) == 0 && header[sizeof(fileHeader) - 1] != fileHeader[sizeof(fileHeader) - 1] ) {
+      std::cerr << "<SVfitResultCache>:"
+                << "File = " << fileName << " has been written with a different version of the file layout"
+                << " (" << header[sizeof(fileHeader) - 1] << ", expected " << fileHeader[sizeof(fileHeader) - 1] << ")"
+                << ", delete it to start a new cache --> ABORTING !!\n";
+      assert(0);
+    }
+    if ( memcmp(header, fileHeader, sizeof(fileHeader)) != 0 || header_slotSize != slotSize ||
+         (size_t)fileStat.st_size != headerSize + header_numSlots*slotSize ) {
+      std::cerr << "<SVfitResultCache>:"
+                << "File = " << fileName << " is not a valid SVfit result cache --> ABORTING !!\n";
+      assert(0);
+    }
+    numFileSlots_ = header_numSlots;
+    fileSize_ = fileStat.st_size;
+  }
+
+  void* fileData = mmap(nullptr, fileSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if ( fileData == MAP_FAILED ) {
+    std::cerr << "<SVfitResultCache>:"
+              << "Failed to map file = " << fileName << " into memory --> ABORTING !!\n";
+    assert(0);
+  }
+  fileData_ = static_cast<char*>(fileData);
+  if ( fileStat.st_size == 0 ) {
+    uint64_t header_numSlots = numFileSlots_;
+    uint64_t header_slotSize = slotSize;
+    memcpy(fileData_, fileHeader, sizeof(fileHeader));
+    memcpy(fileData_ + sizeof(fileHeader), &header_numSlots, sizeof(uint64_t));
+    memcpy(fileData_ + sizeof(fileHeader) + sizeof(uint64_t), &header_slotSize, sizeof(uint64_t));
+  }
+}
+
+SVfitResultCache::~SVfitResultCache()
+{
+  if ( fileData_ ) {
+    msync(fileData_, fileSize_, MS_SYNC);
+    munmap(fileData_, fileSize_);
+  }
+  if ( fd_ >= 0 ) close(fd_);
+}
+
+bool SVfitResultCache::find(uint64_t key, SVfitCachedResult& result)
+{
+  std::unordered_map<uint64_t, EntryList::iterator>::iterator entry = index_.find(key);
+  if ( entry != index_.end() ) {
+//--- move entry to the front of the list of most recently used entries
+    entries_.splice(entries_.begin(), entries_, entry->second);
+    result = entry->second->second;
+    ++numHits_;
+    return true;
+  }
+  if ( findInFile(key, result) ) {
+    insertInMemory(key, result);
+    ++numHits_;
+    return true;
+  }
+  ++numMisses_;
+  return false;
+}
+
+void SVfitResultCache::insert(uint64_t key, const SVfitCachedResult& result)
+{
+  insertInMemory(key, result);
+  insertInFile(key, result);
+}
+
+void SVfitResultCache::insertInMemory(uint64_t key, const SVfitCachedResult& result)
+{
+  std::unordered_map<uint64_t, EntryList::iterator>::iterator entry = index_.find(key);
+  if ( entry != index_.end() ) {
+    entry->second->second = result;
+    entries_.splice(entries_.begin(), entries_, entry->second);
+    return;
+  }
+  if ( entries_.size() >= capacity_ ) {
+//--- evict least recently used entry
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+  entries_.push_front(std::make_pair(key, result));
+  index_[key] = entries_.begin();
+}
+
+char* SVfitResultCache::getSlot(uint64_t key) const
+{
+  return fileData_ + headerSize + (key % numFileSlots_)*slotSize;
+}
+
+bool SVfitResultCache::findInFile(uint64_t key, SVfitCachedResult& result) const
+{
+  if ( !fileData_ || key == 0 ) return false;
+  const char* slot = getSlot(key);
+  uint64_t slot_key;
+  memcpy(&slot_key, slot, sizeof(uint64_t));
+  if ( slot_key != key ) return false;
+  double values[numValuesPerResult];
+  memcpy(values, slot + sizeof(uint64_t), sizeof(values));
+  const char* flags = slot + sizeof(uint64_t) + sizeof(values);
+  uint32_t flagBits, numQuantities;
+  memcpy(&flagBits, flags, sizeof(uint32_t));
+  memcpy(&numQuantities, flags + sizeof(uint32_t), sizeof(uint32_t));
+  if ( numQuantities > maxNumQuantities ) return false;
+  result.probMax_ = values[0];
+  result.integral_ = values[1];
+  result.integralErr_ = values[2];
+  result.acceptanceRate_ = values[3];
+  result.massStatErr_ = values[4];
+  result.isValidSolution_ = ((flagBits & flagIsValidSolution) != 0);
+  result.isRefined_ = ((flagBits & flagIsRefined) != 0);
+  result.properties_.resize(numQuantities);
+  const char* data = flags + 2*sizeof(uint32_t);
+  for ( unsigned idxQuantity = 0; idxQuantity < numQuantities; ++idxQuantity ) {
+    readProperties(data + idxQuantity*numPropertiesPerQuantity*sizeof(double), result.properties_[idxQuantity]);
+  }
+  return true;
+}
+
+void SVfitResultCache::insertInFile(uint64_t key, const SVfitCachedResult& result)
+{
+  // CV: key zero marks empty slots
+  if ( !fileData_ || key == 0 || result.properties_.size() > maxNumQuantities ) return;
+  char* slot = getSlot(key);
+//--- mark slot as empty while its content is being overwritten
+  uint64_t emptyKey = 0;
+  memcpy(slot, &emptyKey, sizeof(uint64_t));
+  double values[numValuesPerResult] = { result.probMax_, result.integral_, result.integralErr_, result.acceptanceRate_, result.massStatErr_ };
+  memcpy(slot + sizeof(uint64_t), values, sizeof(values));
+  char* flags = slot + sizeof(uint64_t) + sizeof(values);
+  uint32_t flagBits = 0;
+  if ( result.isValidSolution_ ) flagBits |= flagIsValidSolution;
+  if ( result.isRefined_ ) flagBits |= flagIsRefined;
+  uint32_t numQuantities = result.properties_.size();
+  memcpy(flags, &flagBits, sizeof(uint32_t));
+  memcpy(flags + sizeof(uint32_t), &numQuantities, sizeof(uint32_t));
+  char* data = flags + 2*sizeof(uint32_t);
+  for ( unsigned idxQuantity = 0; idxQuantity < numQuantities; ++idxQuantity ) {
+    writeProperties(result.properties_[idxQuantity], data + idxQuantity*numPropertiesPerQuantity*sizeof(double));
+  }
+//--- write key last, so that a slot is never marked as valid before its content is complete
+  memcpy(slot, &key, sizeof(uint64_t));
+}
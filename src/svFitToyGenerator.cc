@@ -0,0 +1,346 @@
+#include "TauAnalysis/ClassicSVfit/interface/svFitToyGenerator.h"
+
+#include <cmath>
+#include <iostream>
+#include <assert.h>
+#include <string.h>
+
+using namespace classic_svFit;
+
+namespace
+{
+  const char fileHeader[8] = { 'S', 'V', 'F', 'I', 'T', 'E', 'V', '1' };
+
+  /// branching fractions of tau lepton decays into electrons and muons (all other decays are hadronic)
+  const double brTauToElecDecay = 0.1782;
+  const double brTauToMuDecay = 0.1739;
+
+  /// fractions of hadronic tau decays into pi nu and into rho nu (including pi pi0 pi0 nu);
+  /// all other hadronic decays are three-prong decays into a1 nu
+  const double fractionDecayMode_pi = 0.17;
+  const double fractionDecayMode_rho = 0.52;
+
+  const double rhoMass = 0.7753; // GeV
+  const double rhoWidth = 0.1491; // GeV
+  const double a1Mass = 1.230; // GeV
+  const double a1Width = 0.420; // GeV
+
+  /// range of masses of the visible decay products in hadronic tau decays with neutral pions or three prongs (cf. MeasuredTauLepton)
+  const double minHadTauMass = 0.3; // GeV
+  const double maxHadTauMass = 1.5; // GeV
+
+  /// transform momentum given in restframe of the parent particle to labframe
+  LorentzVector boostToLabFrame(const LorentzVector& p4, const LorentzVector& parentP4)
+  {
+    double bx = parentP4.px()/parentP4.E();
+    double by = parentP4.py()/parentP4.E();
+    double bz = parentP4.pz()/parentP4.E();
+    double b2 = bx*bx + by*by + bz*bz;
+    if ( !(b2 > 0.) ) return p4;
+    double gamma = 1./std::sqrt(1. - b2);
+    double bp = bx*p4.px() + by*p4.py() + bz*p4.pz();
+    double gamma2 = (gamma - 1.)/b2;
+    return LorentzVector(
+      p4.px() + gamma2*bp*bx + gamma*bx*p4.E(),
+      p4.py() + gamma2*bp*by + gamma*by*p4.E(),
+      p4.pz() + gamma2*bp*bz + gamma*bz*p4.E(),
+      gamma*(p4.E() + bp));
+  }
+
+  template <typename T>
+  void writeValue(std::ofstream& file, T value)
+  {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  template <typename T>
+  bool readValue(std::ifstream& file, T& value)
+  {
+    return bool(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+  }
+}
+
+SVfitToyEvent::SVfitToyEvent()
+  : eventId_(0)
+  , trueMass_(0.)
+  , genMETx_(0.)
+  , genMETy_(0.)
+  , measuredMETx_(0.)
+  , measuredMETy_(0.)
+{}
+
+SVfitToyGenerator::SVfitToyGenerator(int decayType1, int decayType2, unsigned seed)
+  : decayType1_(decayType1)
+  , decayType2_(decayType2)
+  , mass_(125.)
+  , width_(0.)
+  , meanPt_(30.)
+  , maxRapidity_(2.5)
+  , minSigmaMET_(15.)
+  , maxSigmaMET_(30.)
+  , minPt_lep_(20.)
+  , minPt_had_(30.)
+  , maxAbsEta_(2.3)
+  , rnd_(seed)
+  , numEventsGenerated_(0)
+  , numEventsAccepted_(0)
+{
+  if ( decayType2_ == MeasuredTauLepton::kPrompt ) {
+    std::cerr << "<SVfitToyGenerator>:"
+              << "Only the first leg can be a prompt lepton --> ABORTING !!\n";
+    assert(0);
+  }
+}
+
+SVfitToyGenerator::~SVfitToyGenerator()
+{}
+
+void SVfitToyGenerator::setMass(double mass, double width)
+{
+  mass_ = mass;
+  width_ = width;
+}
+
+void SVfitToyGenerator::setResonanceKinematics(double meanPt, double maxRapidity)
+{
+  meanPt_ = meanPt;
+  maxRapidity_ = maxRapidity;
+}
+
+void SVfitToyGenerator::setMETResolution(double minSigma, double maxSigma)
+{
+  minSigmaMET_ = minSigma;
+  maxSigmaMET_ = maxSigma;
+}
+
+void SVfitToyGenerator::setAcceptanceCuts(double minPt_lep, double minPt_had, double maxAbsEta)
+{
+  minPt_lep_ = minPt_lep;
+  minPt_had_ = minPt_had;
+  maxAbsEta_ = maxAbsEta;
+}
+
+void SVfitToyGenerator::generateDecayType(int requestedDecayType, int& decayType, int& decayMode, double& visMass)
+{
+  decayType = requestedDecayType;
+  if ( decayType == MeasuredTauLepton::kUndefinedDecayType ) {
+    double u = rnd_.Rndm();
+    if      ( u < brTauToElecDecay                  ) decayType = MeasuredTauLepton::kTauToElecDecay;
+    else if ( u < brTauToElecDecay + brTauToMuDecay ) decayType = MeasuredTauLepton::kTauToMuDecay;
+    else                                              decayType = MeasuredTauLepton::kTauToHadDecay;
+  }
+  decayMode = -1;
+  if ( decayType == MeasuredTauLepton::kTauToElecDecay ) {
+    visMass = electronMass;
+  } else if ( decayType == MeasuredTauLepton::kTauToMuDecay || decayType == MeasuredTauLepton::kPrompt ) {
+    visMass = muonMass;
+  } else if ( decayType == MeasuredTauLepton::kTauToHadDecay ) {
+    double u = rnd_.Rndm();
+    if ( u < fractionDecayMode_pi ) {
+      decayMode = 0;
+      visMass = chargedPionMass;
+    } else {
+      bool isOneProng = ( u < (fractionDecayMode_pi + fractionDecayMode_rho) );
+      decayMode = ( isOneProng ) ? 1 : 10;
+      do {
+        visMass = ( isOneProng ) ? rnd_.BreitWigner(rhoMass, rhoWidth) : rnd_.BreitWigner(a1Mass, a1Width);
+      } while ( !(visMass > minHadTauMass && visMass < maxHadTauMass) );
+    }
+  } else {
+    std::cerr << "<SVfitToyGenerator>:"
+              << "Invalid decay type = " << decayType << " --> ABORTING !!\n";
+    assert(0);
+  }
+}
+
+double SVfitToyGenerator::compMomentum_twoBodyDecay(double M, double m1, double m2) const
+{
+  return std::sqrt(std::max(0., (square(M) - square(m1 + m2))*(square(M) - square(m1 - m2))))/(2.*M);
+}
+
+Vector SVfitToyGenerator::generateDirection(double p)
+{
+  double cosTheta = rnd_.Uniform(-1., +1.);
+  double sinTheta = std::sqrt(std::max(0., 1. - square(cosTheta)));
+  double phi = rnd_.Uniform(-M_PI, +M_PI);
+  return Vector(p*sinTheta*std::cos(phi), p*sinTheta*std::sin(phi), p*cosTheta);
+}
+
+void SVfitToyGenerator::generateTauDecay(const LorentzVector& tauP4, int decayType, double visMass, LorentzVector& visP4, LorentzVector& nuP4)
+{
+  if ( decayType == MeasuredTauLepton::kPrompt ) {
+    visP4 = tauP4;
+    nuP4 = LorentzVector(0., 0., 0., 0.);
+    return;
+  }
+  double visEn_rf, visP_rf;
+  if ( decayType == MeasuredTauLepton::kTauToHadDecay ) {
+    visP_rf = compMomentum_twoBodyDecay(tauLeptonMass, visMass, 0.);
+    visEn_rf = std::sqrt(square(visP_rf) + square(visMass));
+  } else {
+//--- energy fraction y = 2*E/mTau of the lepton, distributed according to y^2*(3 - 2*y)
+    double y = 0.;
+    do {
+      y = rnd_.Rndm();
+      visEn_rf = 0.5*y*tauLeptonMass;
+    } while ( !(rnd_.Rndm() < square(y)*(3. - 2.*y)) || !(visEn_rf > visMass) );
+    visP_rf = std::sqrt(square(visEn_rf) - square(visMass));
+  }
+  Vector visP3_rf = generateDirection(visP_rf);
+  LorentzVector visP4_rf(visP3_rf.x(), visP3_rf.y(), visP3_rf.z(), visEn_rf);
+  LorentzVector nuP4_rf(-visP3_rf.x(), -visP3_rf.y(), -visP3_rf.z(), tauLeptonMass - visEn_rf);
+  visP4 = boostToLabFrame(visP4_rf, tauP4);
+  nuP4 = boostToLabFrame(nuP4_rf, tauP4);
+}
+
+bool SVfitToyGenerator::isAccepted(const LorentzVector& visP4, int decayType) const
+{
+  double minPt = ( decayType == MeasuredTauLepton::kTauToHadDecay ) ? minPt_had_ : minPt_lep_;
+  return ( visP4.pt() > minPt && std::abs(visP4.eta()) < maxAbsEta_ );
+}
+
+void SVfitToyGenerator::generate(SVfitToyEvent& event)
+{
+  while ( true ) {
+    ++numEventsGenerated_;
+
+    int decayType1, decayMode1, decayType2, decayMode2;
+    double visMass1, visMass2;
+    generateDecayType(decayType1_, decayType1, decayMode1, visMass1);
+    generateDecayType(decayType2_, decayType2, decayMode2, visMass2);
+    double legMass1 = ( decayType1 == MeasuredTauLepton::kPrompt ) ? visMass1 : tauLeptonMass;
+    double legMass2 = tauLeptonMass;
+
+//--- generate momentum of resonance
+    double mass = mass_;
+    if ( width_ > 0. ) {
+      do {
+        mass = rnd_.BreitWigner(mass_, width_);
+      } while ( !(mass > (legMass1 + legMass2) && mass < (mass_ + 10.*width_)) );
+    }
+    double pt = rnd_.Exp(meanPt_);
+    double rapidity = rnd_.Uniform(-maxRapidity_, +maxRapidity_);
+    double phi = rnd_.Uniform(-M_PI, +M_PI);
+    double mt = std::sqrt(square(mass) + square(pt));
+    LorentzVector resonanceP4(pt*std::cos(phi), pt*std::sin(phi), mt*std::sinh(rapidity), mt*std::cosh(rapidity));
+
+//--- decay resonance into two tau leptons (or prompt lepton and tau lepton)
+    double p_rf = compMomentum_twoBodyDecay(mass, legMass1, legMass2);
+    Vector p3_rf = generateDirection(p_rf);
+    LorentzVector leg1P4 = boostToLabFrame(LorentzVector(p3_rf.x(), p3_rf.y(), p3_rf.z(), std::sqrt(square(p_rf) + square(legMass1))), resonanceP4);
+    LorentzVector leg2P4 = boostToLabFrame(LorentzVector(-p3_rf.x(), -p3_rf.y(), -p3_rf.z(), std::sqrt(square(p_rf) + square(legMass2))), resonanceP4);
+
+    LorentzVector vis1P4, nu1P4, vis2P4, nu2P4;
+    generateTauDecay(leg1P4, decayType1, visMass1, vis1P4, nu1P4);
+    generateTauDecay(leg2P4, decayType2, visMass2, vis2P4, nu2P4);
+    if ( !(isAccepted(vis1P4, decayType1) && isAccepted(vis2P4, decayType2)) ) continue;
+
+//--- smear MET according to covariance matrix with random resolution and orientation of principal axes
+    double sigma1 = rnd_.Uniform(minSigmaMET_, maxSigmaMET_);
+    double sigma2 = rnd_.Uniform(minSigmaMET_, maxSigmaMET_);
+    double angle = rnd_.Uniform(0., M_PI);
+    double cosAngle = std::cos(angle);
+    double sinAngle = std::sin(angle);
+    double covXX = square(sigma1*cosAngle) + square(sigma2*sinAngle);
+    double covYY = square(sigma1*sinAngle) + square(sigma2*cosAngle);
+    double covXY = (square(sigma1) - square(sigma2))*cosAngle*sinAngle;
+    double delta1 = rnd_.Gaus(0., sigma1);
+    double delta2 = rnd_.Gaus(0., sigma2);
+
+    event.eventId_ = numEventsAccepted_;
+    event.trueMass_ = mass;
+    event.genMETx_ = nu1P4.px() + nu2P4.px();
+    event.genMETy_ = nu1P4.py() + nu2P4.py();
+    event.measuredMETx_ = event.genMETx_ + cosAngle*delta1 - sinAngle*delta2;
+    event.measuredMETy_ = event.genMETy_ + sinAngle*delta1 + cosAngle*delta2;
+    event.covMET_ = Matrix2x2(covXX, covXY, covXY, covYY);
+    event.measuredTauLeptons_.clear();
+    event.measuredTauLeptons_.push_back(MeasuredTauLepton(decayType1, vis1P4.pt(), vis1P4.eta(), vis1P4.phi(), visMass1, decayMode1));
+    event.measuredTauLeptons_.push_back(MeasuredTauLepton(decayType2, vis2P4.pt(), vis2P4.eta(), vis2P4.phi(), visMass2, decayMode2));
+    ++numEventsAccepted_;
+    return;
+  }
+}
+
+SVfitToyEventWriter::SVfitToyEventWriter(const std::string& fileName)
+  : file_(fileName.data(), std::ios::out | std::ios::binary | std::ios::trunc)
+{
+  if ( !file_ ) {
+    std::cerr << "<SVfitToyEventWriter>:"
+              << "Failed to open file = " << fileName << " --> ABORTING !!\n";
+    assert(0);
+  }
+  file_.write(fileHeader, sizeof(fileHeader));
+}
+
+SVfitToyEventWriter::~SVfitToyEventWriter()
+{
+  file_.close();
+}
+
+void SVfitToyEventWriter::write(const SVfitToyEvent& event)
+{
+  assert(event.measuredTauLeptons_.size() == 2);
+  writeValue<uint64_t>(file_, event.eventId_);
+  writeValue<double>(file_, event.trueMass_);
+  writeValue<double>(file_, event.genMETx_);
+  writeValue<double>(file_, event.genMETy_);
+  writeValue<double>(file_, event.measuredMETx_);
+  writeValue<double>(file_, event.measuredMETy_);
+  writeValue<double>(file_, event.covMET_.xx_);
+  writeValue<double>(file_, event.covMET_.xy_);
+  writeValue<double>(file_, event.covMET_.yy_);
+  for ( std::vector<MeasuredTauLepton>::const_iterator measuredTauLepton = event.measuredTauLeptons_.begin();
+        measuredTauLepton != event.measuredTauLeptons_.end(); ++measuredTauLepton ) {
+    writeValue<int32_t>(file_, measuredTauLepton->type());
+    writeValue<int32_t>(file_, measuredTauLepton->decayMode());
+    writeValue<double>(file_, measuredTauLepton->pt());
+    writeValue<double>(file_, measuredTauLepton->eta());
+    writeValue<double>(file_, measuredTauLepton->phi());
+    writeValue<double>(file_, measuredTauLepton->mass());
+  }
+}
+
+SVfitToyEventReader::SVfitToyEventReader(const std::string& fileName)
+  : file_(fileName.data(), std::ios::in | std::ios::binary)
+{
+  char header[sizeof(fileHeader)] = {};
+  if ( !file_ || !file_.read(header, sizeof(header)) || memcmp(header, fileHeader, sizeof(fileHeader)) != 0 ) {
+    std::cerr << "<SVfitToyEventReader>:"
+              << "File = " << fileName << " is not a valid file of SVfit toy events --> ABORTING !!\n";
+    assert(0);
+  }
+}
+
+SVfitToyEventReader::~SVfitToyEventReader()
+{
+  file_.close();
+}
+
+bool SVfitToyEventReader::read(SVfitToyEvent& event)
+{
+  double covXX, covXY, covYY;
+  if ( !(readValue(file_, event.eventId_) &&
+         readValue(file_, event.trueMass_) &&
+         readValue(file_, event.genMETx_) &&
+         readValue(file_, event.genMETy_) &&
+         readValue(file_, event.measuredMETx_) &&
+         readValue(file_, event.measuredMETy_) &&
+         readValue(file_, covXX) &&
+         readValue(file_, covXY) &&
+         readValue(file_, covYY)) ) return false;
+  event.covMET_ = Matrix2x2(covXX, covXY, covXY, covYY);
+  event.measuredTauLeptons_.clear();
+  for ( int idxLeg = 0; idxLeg < 2; ++idxLeg ) {
+    int32_t type, decayMode;
+    double pt, eta, phi, mass;
+    if ( !(readValue(file_, type) &&
+           readValue(file_, decayMode) &&
+           readValue(file_, pt) &&
+           readValue(file_, eta) &&
+           readValue(file_, phi) &&
+           readValue(file_, mass)) ) return false;
+    event.measuredTauLeptons_.push_back(MeasuredTauLepton(type, pt, eta, phi, mass, decayMode));
+  }
+  return true;
+}